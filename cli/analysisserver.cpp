@@ -0,0 +1,353 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2013 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "analysisserver.h"
+#include "cmdlineparser.h"
+#include "cppcheck.h"
+#include "filelister.h"
+#include "path.h"
+#include "pathmatch.h"
+#include "preprocessor.h"
+#include "settings.h"
+#include "threadexecutor.h"
+#include "tokenize.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+/** @brief Largest request that is accepted */
+static const std::size_t MaxRequestSize = 1024 * 1024;
+
+/** Default time to wait for a request in milliseconds */
+static const int RequestTimeout = 10000;
+
+namespace {
+    /** @brief Sends the results of a request to the client */
+    class ResultWriter : public ErrorLogger {
+    public:
+        explicit ResultWriter(int fd) : _fd(fd), _settings(0), _failed(false) {
+        }
+
+        void setSettings(Settings *settings) {
+            _settings = settings;
+        }
+
+        /** @brief Send a line, the checking is terminated if the client has gone */
+        void write(const std::string &line) {
+#ifndef _WIN32
+            if (_failed)
+                return;
+            const std::string data(line + '\n');
+            std::size_t done = 0;
+            while (done < data.size()) {
+                const ssize_t n = ::write(_fd, data.data() + done, data.size() - done);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0) {
+                    _failed = true;
+                    if (_settings)
+                        _settings->terminate();
+                    return;
+                }
+                done += static_cast<std::size_t>(n);
+            }
+#else
+            (void)line;
+#endif
+        }
+
+        virtual void reportOut(const std::string &/*outmsg*/) {
+        }
+
+        virtual void reportErr(const ErrorLogger::ErrorMessage &msg) {
+            const std::string text = _settings->_xml ?
+                                     msg.toXML(_settings->_verbose, _settings->_xml_version) :
+                                     msg.toString(_settings->_verbose, _settings->_outputFormat);
+
+            // Alert only about unique errors
+            if (_errors.insert(text).second)
+                write(text);
+        }
+
+        virtual void reportInfo(const ErrorLogger::ErrorMessage &msg) {
+            reportErr(msg);
+        }
+
+    private:
+        int _fd;
+        Settings *_settings;
+        bool _failed;
+        std::set<std::string> _errors;
+    };
+}
+
+AnalysisServer::AnalysisServer(const Settings &settings)
+    : _settings(settings), _requestTimeout(RequestTimeout), _socket(-1)
+{
+}
+
+bool AnalysisServer::isEnabled()
+{
+#ifdef _WIN32
+    return false;
+#else
+    return true;
+#endif
+}
+
+bool AnalysisServer::parseRequest(const std::string &request, std::string &command, std::vector<std::string> &args)
+{
+    command.clear();
+    args.clear();
+
+    std::istringstream istr(request);
+    std::string line;
+    while (std::getline(istr, line)) {
+        if (!line.empty() && line[line.size() - 1] == '\r')
+            line.erase(line.size() - 1);
+        if (line.empty())
+            break;
+        if (command.empty())
+            command = line;
+        else
+            args.push_back(line);
+    }
+    return !command.empty();
+}
+
+#ifdef _WIN32
+
+int AnalysisServer::run()
+{
+    std::cerr << "cppcheck: error: --server is not supported on this platform." << std::endl;
+    return EXIT_FAILURE;
+}
+
+bool AnalysisServer::handleConnection(int /*fd*/)
+{
+    return false;
+}
+
+void AnalysisServer::check(const std::vector<std::string> &/*args*/, int /*fd*/)
+{
+}
+
+#else
+
+int AnalysisServer::run()
+{
+    const std::string &path = _settings.serverSocket;
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "cppcheck: error: the socket path '" << path << "' is too long." << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::strcpy(addr.sun_path, path.c_str());
+
+    const int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) {
+        std::cerr << "cppcheck: error: could not create a socket: " << std::strerror(errno) << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    bool bound = bind(sock, reinterpret_cast<const struct sockaddr *>(&addr), sizeof(addr)) == 0;
+    if (!bound && errno == EADDRINUSE) {
+        // Remove the socket of a server that is not running anymore
+        const int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        const bool running = probe >= 0 && connect(probe, reinterpret_cast<const struct sockaddr *>(&addr), sizeof(addr)) == 0;
+        if (probe >= 0)
+            close(probe);
+        if (!running) {
+            unlink(path.c_str());
+            bound = bind(sock, reinterpret_cast<const struct sockaddr *>(&addr), sizeof(addr)) == 0;
+        } else {
+            errno = EADDRINUSE;
+        }
+    }
+    if (!bound || listen(sock, 16) != 0) {
+        std::cerr << "cppcheck: error: could not listen on '" << path << "': " << std::strerror(errno) << std::endl;
+        close(sock);
+        return EXIT_FAILURE;
+    }
+
+    // A client that disconnects early must not stop the server
+    signal(SIGPIPE, SIG_IGN);
+    _socket = sock;
+
+    for (;;) {
+        const int fd = accept(sock, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            std::cerr << "cppcheck: error: could not accept a connection: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        const bool more = handleConnection(fd);
+        close(fd);
+        if (!more)
+            break;
+    }
+
+    _socket = -1;
+    close(sock);
+    unlink(path.c_str());
+    return EXIT_SUCCESS;
+}
+
+bool AnalysisServer::handleConnection(int fd)
+{
+    // Read until the empty line that ends the request. The server handles
+    // one connection at a time, a client that does not send its request
+    // must not block the others.
+    struct timeval timeout;
+    timeout.tv_sec = _requestTimeout / 1000;
+    timeout.tv_usec = (_requestTimeout % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    std::string request;
+    char buf[4096];
+    bool timedOut = false;
+    while (request.find("\n\n") == std::string::npos && request.find("\r\n\r\n") == std::string::npos) {
+        const ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            timedOut = true;
+        if (n <= 0)
+            break;
+        request.append(buf, static_cast<std::size_t>(n));
+        if (request.size() > MaxRequestSize)
+            break;
+    }
+
+    ResultWriter writer(fd);
+    std::string command;
+    std::vector<std::string> args;
+    if (timedOut)
+        writer.write("cppcheck: error: no request received in time.");
+    else if (request.size() > MaxRequestSize)
+        writer.write("cppcheck: error: the request is too large.");
+    else if (!parseRequest(request, command, args))
+        writer.write("cppcheck: error: empty request.");
+    else if (command == "shutdown")
+        return false;
+    else if (command == "check")
+        check(args, fd);
+    else
+        writer.write("cppcheck: error: unknown request '" + command + "'.");
+    return true;
+}
+
+void AnalysisServer::check(const std::vector<std::string> &args, int fd)
+{
+    ResultWriter writer(fd);
+    CppCheck cppCheck(writer, true);
+    Settings &settings = cppCheck.settings();
+    settings = _settings;
+    settings.serverSocket.clear();
+    writer.setSettings(&settings);
+
+    // The messages of the command line parser are sent to the client
+    std::vector<const char *> argv;
+    argv.push_back("cppcheck");
+    for (std::vector<std::string>::const_iterator it = args.begin(); it != args.end(); ++it)
+        argv.push_back(it->c_str());
+    std::ostringstream messages;
+    std::streambuf * const coutbuf = std::cout.rdbuf(messages.rdbuf());
+    CmdLineParser parser(&settings);
+    const bool success = parser.ParseFromArgs(static_cast<int>(argv.size()), &argv[0]);
+    std::cout.rdbuf(coutbuf);
+    std::string text = messages.str();
+    if (!text.empty() && text[text.size() - 1] == '\n')
+        text.erase(text.size() - 1);
+    if (!text.empty())
+        writer.write(text);
+    if (!success || parser.ExitAfterPrinting())
+        return;
+    if (!settings.serverSocket.empty()) {
+        writer.write("cppcheck: error: '--server' can't be used in a request.");
+        return;
+    }
+
+    std::map<std::string, std::size_t> files;
+    const std::vector<std::string> &pathnames = parser.GetPathNames();
+    for (std::vector<std::string>::const_iterator it = pathnames.begin(); it != pathnames.end(); ++it)
+        FileLister::recursiveAddFiles(files, Path::toNativeSeparators(*it));
+    PathMatch matcher(parser.GetIgnoredPaths());
+    for (std::map<std::string, std::size_t>::iterator it = files.begin(); it != files.end();) {
+        if (matcher.Match(it->first))
+            files.erase(it++);
+        else
+            ++it;
+    }
+    if (files.empty()) {
+        writer.write("cppcheck: error: could not find or open any of the paths given.");
+        return;
+    }
+
+    // Each request reports the messages of the headers (--check-headers-once),
+    // and the strings of the tokens of the previous request are freed
+    Preprocessor::missingIncludeFlag = false;
+    Tokenizer::clearCheckedHeaders();
+    Token::resetSymbols();
+    if (settings._xml)
+        writer.write(ErrorLogger::ErrorMessage::getXMLHeader(settings._xml_version));
+
+    if (settings._jobs > 1 && ThreadExecutor::isEnabled()) {
+        ThreadExecutor executor(files, settings, writer);
+        executor.closeInWorkers(_socket);
+        executor.closeInWorkers(fd);
+        executor.check();
+
+        if (settings.isEnabled("unusedFunction")) {
+            const std::list<std::string> &functionUsage = executor.functionUsage();
+            for (std::list<std::string>::const_iterator it = functionUsage.begin(); it != functionUsage.end(); ++it)
+                cppCheck.mergeFunctionUsage(*it);
+        }
+    } else {
+        for (std::map<std::string, std::size_t>::const_iterator it = files.begin(); it != files.end(); ++it)
+            cppCheck.check(it->first);
+    }
+    cppCheck.checkFunctionUsage();
+
+    if (!settings.checkConfiguration) {
+        if (!settings._errorsOnly)
+            writer.reportUnmatchedSuppressions(settings.nomsg.getUnmatchedGlobalSuppressions());
+        cppCheck.tooManyConfigsError("", 0U);
+    }
+
+    if (settings._xml)
+        writer.write(ErrorLogger::ErrorMessage::getXMLFooter(settings._xml_version));
+}
+
+#endif
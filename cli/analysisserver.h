@@ -0,0 +1,98 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2013 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANALYSISSERVER_H
+#define ANALYSISSERVER_H
+
+#include <string>
+#include <vector>
+
+class Settings;
+
+/// @addtogroup CLI
+/// @{
+
+/**
+ * @brief Checks files on request over a Unix domain socket (--server).
+ *
+ * The server keeps running between requests, so the caches of the
+ * process (the headers read by the preprocessor, --cache-dir) stay warm
+ * and editors or bots get the results of an edited file quickly.
+ *
+ * A request is the word "check" on the first line, followed by command
+ * line arguments, one on each line, and an empty line. The arguments are
+ * applied on top of the options the server was started with. The errors
+ * are sent back as they are found, formatted like on the command line
+ * (XML with --xml or --xml-version), and the connection is closed when
+ * the check is done. The request "shutdown" stops the server.
+ */
+class AnalysisServer {
+public:
+    /**
+     * @param settings the options of the server, these are the defaults
+     * of every request
+     */
+    explicit AnalysisServer(const Settings &settings);
+
+    /**
+     * @brief Listen on the socket given by --server and handle requests
+     * until a "shutdown" request is received.
+     * @return EXIT_FAILURE if the socket can't be created
+     */
+    int run();
+
+    /**
+     * @brief Read a request from @p fd, handle it and send the results
+     * to @p fd. Public so it can be used in unit testing.
+     * @return false if the request was "shutdown"
+     */
+    bool handleConnection(int fd);
+
+    /**
+     * @brief Time a client has to send its request, the connection is
+     * dropped after that so the other clients are not blocked
+     */
+    void setRequestTimeout(int milliseconds) {
+        _requestTimeout = milliseconds;
+    }
+
+    /**
+     * @brief Split a request into its command and arguments
+     * @return false if the request is not complete or has no command
+     */
+    static bool parseRequest(const std::string &request, std::string &command, std::vector<std::string> &args);
+
+    /** @brief Is the server supported on this platform? */
+    static bool isEnabled();
+
+private:
+    /** @brief Check the files given by the arguments of a request */
+    void check(const std::vector<std::string> &args, int fd);
+
+    const Settings &_settings;
+
+    /** @brief Milliseconds to wait for a request, see setRequestTimeout() */
+    int _requestTimeout;
+
+    /** @brief The listening socket, -1 if run() is not used */
+    int _socket;
+};
+
+/// @}
+
+#endif // ANALYSISSERVER_H
@@ -14,15 +14,23 @@ BASEPATH = ../lib/
 include($$PWD/../lib/lib.pri)
 
 SOURCES += main.cpp \
+           analysisserver.cpp \
            cppcheckexecutor.cpp \
            cmdlineparser.cpp \
+           compiledatabase.cpp \
            filelister.cpp \
+           filescheduler.cpp \
+           jobserver.cpp \
            pathmatch.cpp \
            threadexecutor.cpp
 
-HEADERS += cppcheckexecutor.h \
+HEADERS += analysisserver.h \
+           cppcheckexecutor.h \
            cmdlineparser.h \
+           compiledatabase.h \
            filelister.h \
+           filescheduler.h \
+           jobserver.h \
            pathmatch.h \
            threadexecutor.h
 
@@ -27,9 +27,17 @@
 #include "timer.h"
 #include "settings.h"
 #include "cmdlineparser.h"
+#include "compiledatabase.h"
 #include "path.h"
 #include "filelister.h"
 
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
 #ifdef HAVE_RULES
 // xml is used in rules
 #include <tinyxml2.h>
@@ -86,6 +94,17 @@ static void AddInclPathsToList(const std::string& FileList, std::list<std::strin
     }
 }
 
+/** Create the directory if it does not exist, @return false if there is no such directory afterwards */
+static bool MakeDirectory(const std::string &dir)
+{
+#ifdef _WIN32
+    _mkdir(dir.c_str());
+#else
+    mkdir(dir.c_str(), 0777);
+#endif
+    return FileLister::isDirectory(dir);
+}
+
 CmdLineParser::CmdLineParser(Settings *settings)
     : _settings(settings)
     , _showHelp(false)
@@ -102,6 +121,8 @@ void CmdLineParser::PrintMessage(const std::string &message)
 
 bool CmdLineParser::ParseFromArgs(int argc, const char* const argv[])
 {
+    std::string project;
+
     for (int i = 1; i < argc; i++) {
         if (std::strcmp(argv[i], "--version") == 0) {
             _showVersion = true;
@@ -540,6 +561,117 @@ bool CmdLineParser::ParseFromArgs(int argc, const char* const argv[])
             }
         }
 
+        // Share the job slots of GNU make
+        else if (std::strcmp(argv[i], "--jobserver") == 0)
+            _settings->jobServer = true;
+
+        // How the checking threads are run
+        else if (std::strncmp(argv[i], "--executor=", 11) == 0) {
+            const std::string executor(argv[i] + 11);
+            if (executor == "process")
+                _settings->executor = Settings::Process;
+            else if (executor == "thread")
+                _settings->executor = Settings::Thread;
+            else {
+                PrintMessage("cppcheck: error: unrecognized executor: \"" + executor + "\".");
+                return false;
+            }
+        }
+
+        // Check the configurations of a file in parallel
+        else if (std::strncmp(argv[i], "--config-jobs=", 14) == 0) {
+            std::istringstream iss(argv[i] + 14);
+            if (!(iss >> _settings->configJobs) || _settings->configJobs < 1) {
+                PrintMessage("cppcheck: argument to '--config-jobs' must be a positive number.");
+                return false;
+            }
+
+            if (_settings->configJobs > 10000) {
+                // This limit is here just to catch typos, like for '-j'.
+                PrintMessage("cppcheck: argument for '--config-jobs' is allowed to be 10000 at max.");
+                return false;
+            }
+        }
+
+        // Keep the results in a directory and reuse them in the next run
+        else if (std::strncmp(argv[i], "--cache-dir=", 12) == 0) {
+            _settings->cacheDir = Path::fromNativeSeparators(argv[i] + 12);
+            if (_settings->cacheDir.empty()) {
+                PrintMessage("cppcheck: error: no directory given to '--cache-dir'.");
+                return false;
+            }
+            if (!MakeDirectory(_settings->cacheDir)) {
+                PrintMessage("cppcheck: error: could not create the cache directory '" + _settings->cacheDir + "'.");
+                return false;
+            }
+        }
+
+        // Only check the files that changed since the previous run
+        else if (std::strncmp(argv[i], "--incremental=", 14) == 0) {
+            _settings->incrementalDir = Path::fromNativeSeparators(argv[i] + 14);
+            if (_settings->incrementalDir.empty()) {
+                PrintMessage("cppcheck: error: no directory given to '--incremental'.");
+                return false;
+            }
+            if (!MakeDirectory(_settings->incrementalDir)) {
+                PrintMessage("cppcheck: error: could not create the directory '" + _settings->incrementalDir + "'.");
+                return false;
+            }
+        }
+
+        // Check the files that are requested over a socket
+        else if (std::strncmp(argv[i], "--server=", 9) == 0) {
+            _settings->serverSocket = argv[i] + 9;
+            if (_settings->serverSocket.empty()) {
+                PrintMessage("cppcheck: error: no socket given to '--server'.");
+                return false;
+            }
+        }
+
+        // Check a part of the files
+        else if (std::strncmp(argv[i], "--shard=", 8) == 0) {
+            std::istringstream iss(argv[i] + 8);
+            char slash = 0;
+            if (!(iss >> _settings->shardIndex >> slash >> _settings->shardCount) || slash != '/' || !iss.eof() ||
+                _settings->shardIndex < 1 || _settings->shardIndex > _settings->shardCount) {
+                PrintMessage("cppcheck: argument to '--shard' must be <i>/<N> with 1 <= i <= N.");
+                return false;
+            }
+        }
+
+        // Check the files of a compilation database
+        else if (std::strncmp(argv[i], "--project=", 10) == 0) {
+            project = Path::fromNativeSeparators(argv[i] + 10);
+            if (project.empty()) {
+                PrintMessage("cppcheck: error: no file given to '--project'.");
+                return false;
+            }
+        }
+
+        // Run the checks of a file in parallel
+        else if (std::strncmp(argv[i], "--check-jobs=", 13) == 0) {
+            std::istringstream iss(argv[i] + 13);
+            if (!(iss >> _settings->checkJobs) || _settings->checkJobs < 1) {
+                PrintMessage("cppcheck: argument to '--check-jobs' must be a positive number.");
+                return false;
+            }
+
+            if (_settings->checkJobs > 10000) {
+                // This limit is here just to catch typos, like for '-j'.
+                PrintMessage("cppcheck: argument for '--check-jobs' is allowed to be 10000 at max.");
+                return false;
+            }
+        }
+
+        // File where the check time of each file is kept between runs
+        else if (std::strncmp(argv[i], "--timings-file=", 15) == 0) {
+            _settings->timingsFile = Path::fromNativeSeparators(argv[i] + 15);
+            if (_settings->timingsFile.empty()) {
+                PrintMessage("cppcheck: error: no file name given to '--timings-file'.");
+                return false;
+            }
+        }
+
         // print all possible error messages..
         else if (std::strcmp(argv[i], "--errorlist") == 0) {
             _showErrorMessages = true;
@@ -625,6 +757,11 @@ bool CmdLineParser::ParseFromArgs(int argc, const char* const argv[])
             _settings->checkConfiguration = true;
         }
 
+        // Check the code of each header once
+        else if (std::strcmp(argv[i], "--check-headers-once") == 0) {
+            _settings->checkHeadersOnce = true;
+        }
+
         // Specify platform
         else if (std::strncmp(argv[i], "--platform=", 11) == 0) {
             std::string platform(11+argv[i]);
@@ -664,6 +801,29 @@ bool CmdLineParser::ParseFromArgs(int argc, const char* const argv[])
             }
         }
 
+        // Memory budget of the -j jobs
+        else if (std::strncmp(argv[i], "--max-memory=", 13) == 0) {
+            std::istringstream iss(13+argv[i]);
+            unsigned long long size = 0;
+            std::string unit;
+            if (!(iss >> size) || (iss >> unit && unit != "K" && unit != "M" && unit != "G")) {
+                PrintMessage("cppcheck: argument to '--max-memory=' is not a size.");
+                return false;
+            }
+
+            if (size < 1) {
+                PrintMessage("cppcheck: argument to '--max-memory=' must be greater than 0.");
+                return false;
+            }
+
+            if (unit == "K")
+                _settings->maxMemory = size * 1024ULL;
+            else if (unit == "G")
+                _settings->maxMemory = size * 1024ULL * 1024ULL * 1024ULL;
+            else
+                _settings->maxMemory = size * 1024ULL * 1024ULL;
+        }
+
         // Print help
         else if (std::strcmp(argv[i], "-h") == 0 || std::strcmp(argv[i], "--help") == 0) {
             _pathnames.clear();
@@ -687,10 +847,6 @@ bool CmdLineParser::ParseFromArgs(int argc, const char* const argv[])
         }
     }
 
-    if (_settings->isEnabled("unusedFunction") && _settings->_jobs > 1) {
-        PrintMessage("cppcheck: unusedFunction check can't be used with '-j' option, so it's disabled.");
-    }
-
     if (argc <= 1)
         _showHelp = true;
 
@@ -699,6 +855,34 @@ bool CmdLineParser::ParseFromArgs(int argc, const char* const argv[])
         return true;
     }
 
+    // The server gets the files in its requests
+    if (!_settings->serverSocket.empty()) {
+        if (!_pathnames.empty()) {
+            PrintMessage("cppcheck: error: no files can be given with '--server', they are given in the requests.");
+            return false;
+        }
+        return true;
+    }
+
+    // The files and their flags are read from the compilation database
+    // after all options, its flags are added to the ones of the options
+    if (!project.empty()) {
+        if (!_pathnames.empty()) {
+            PrintMessage("cppcheck: error: no files can be given with '--project', they are read from the project.");
+            return false;
+        }
+        std::string errmsg;
+        if (!CompileDatabase::load(project, *_settings, errmsg)) {
+            PrintMessage("cppcheck: error: could not read the project '" + project + "': " + errmsg + ".");
+            return false;
+        }
+        if (_settings->fileSettings.empty()) {
+            PrintMessage("cppcheck: error: no files to check in the project '" + project + "'.");
+            return false;
+        }
+        return true;
+    }
+
     // Print error only if we have "real" command and expect files
     if (!_exitAfterPrint && _pathnames.empty()) {
         PrintMessage("cppcheck: No C or C++ source files found.");
@@ -724,8 +908,25 @@ void CmdLineParser::PrintHelp()
               "Options:\n"
               "    --append=<file>      This allows you to provide information about functions\n"
               "                         by providing an implementation for them.\n"
+              "    --cache-dir=<dir>    Keep the results of each configuration of a file in\n"
+              "                         <dir>. The configurations whose preprocessed code and\n"
+              "                         settings have not changed since the previous run are\n"
+              "                         not checked again, their results are read from <dir>.\n"
+              "                         The number of configurations found in and missing\n"
+              "                         from <dir> is shown at the end.\n"
               "    --check-config       Check cppcheck configuration. The normal code\n"
               "                         analysis is disabled by this flag.\n"
+              "    --check-headers-once Check the code of a header once, not for every file\n"
+              "                         that includes it. When the same header code is met\n"
+              "                         again, the function bodies in it that the other\n"
+              "                         code doesn't use are not checked, and the messages\n"
+              "                         about the header are not reported again.\n"
+              "    --check-jobs=<jobs>  Run the checks of a file in <jobs> threads. The\n"
+              "                         results are reported in the same order as without\n"
+              "                         this option.\n"
+              "    --config-jobs=<jobs> Check the preprocessor configurations of a file in\n"
+              "                         <jobs> threads. The results are reported in the same\n"
+              "                         order as without this option.\n"
               "    -D<ID>               By default Cppcheck checks all configurations. Use -D\n"
               "                         to limit the checking to a particular configuration.\n"
               "                         Example: '-DDEBUG=1 -D__cplusplus'.\n"
@@ -759,6 +960,14 @@ void CmdLineParser::PrintHelp()
               "                         provided. Note that your operating system can modify\n"
               "                         this value, e.g. '256' can become '0'.\n"
               "    --errorlist          Print a list of all the error messages in XML format.\n"
+              "    --executor=<type>    How the jobs given with '-j' are run. The available\n"
+              "                         types are:\n"
+              "                          * process\n"
+              "                                 Check each file in a separate process\n"
+              "                                 (default)\n"
+              "                          * thread\n"
+              "                                 Check the files in threads of one process\n"
+              "                         On Windows threads are always used.\n"
               "    --exitcode-suppressions=<file>\n"
               "                         Used when certain messages should be displayed but\n"
               "                         should not cause a non-zero exitcode.\n"
@@ -794,10 +1003,20 @@ void CmdLineParser::PrintHelp()
               "                         There are false positives with this option. Each result\n"
               "                         must be carefully investigated before you know if it is\n"
               "                         good or bad.\n"
+              "    --incremental=<dir>  Keep the results of each file in <dir> together with\n"
+              "                         hashes of the file and the headers it includes. Only\n"
+              "                         the files that changed, or whose headers changed,\n"
+              "                         since the previous run are checked again. The results\n"
+              "                         of the other files are read from <dir>.\n"
               "    --inline-suppr       Enable inline suppressions. Use them by placing one or\n"
               "                         more comments, like: '// cppcheck-suppress warningId'\n"
               "                         on the lines before the warning to suppress.\n"
               "    -j <jobs>            Start [jobs] threads to do the checking simultaneously.\n"
+              "    --jobserver          When run by 'make -jN', check a file only when the\n"
+              "                         GNU make jobserver gives a free job slot. '-j' is the\n"
+              "                         largest number of files that are checked at the same\n"
+              "                         time. Without a jobserver one file is checked at a\n"
+              "                         time. Not supported on Windows.\n"
               "    --language=<language>, -x <language>\n"
               "                         Forces cppcheck to check all files as the given\n"
               "                         language. Valid values are: c, c++\n"
@@ -806,6 +1025,12 @@ void CmdLineParser::PrintHelp()
               "                         before skipping it. Default is '12'. If used together\n"
               "                         with '--force', the last option is the one that is\n"
               "                         effective.\n"
+              "    --max-memory=<size>  Memory budget of the jobs given with '-j'. A new file\n"
+              "                         is not started while the memory used by the jobs and\n"
+              "                         the estimated memory of the file are above the budget.\n"
+              "                         The size is in megabytes, or ends with K, M or G.\n"
+              "                         The files that were delayed are listed at the end.\n"
+              "                         Not supported on Windows.\n"
               "    --platform=<type>    Specifies platform specific types and sizes. The\n"
               "                         available platforms are:\n"
               "                          * unix32\n"
@@ -818,6 +1043,12 @@ void CmdLineParser::PrintHelp()
               "                                 32 bit Windows UNICODE character encoding\n"
               "                          * win64\n"
               "                                 64 bit Windows\n"
+              "    --project=<file>     Check the files of the compilation database <file>\n"
+              "                         (compile_commands.json). Each file is checked once\n"
+              "                         for each set of flags it is compiled with, in the\n"
+              "                         configuration of its -D, -U, -I and -include flags.\n"
+              "                         The flags are added to the ones of the options. No\n"
+              "                         files can be given with '--project'.\n"
               "    -q, --quiet          Only print error messages.\n"
               "    -rp, --relative-paths\n"
               "    -rp=<paths>, --relative-paths=<paths>\n"
@@ -834,6 +1065,19 @@ void CmdLineParser::PrintHelp()
               "    --rule-file=<file>   Use given rule file. For more information, see: \n"
               "                         https://sourceforge.net/projects/cppcheck/files/Articles/\n"
 #endif
+              "    --server=<socket>    Wait for requests on the Unix domain socket <socket>\n"
+              "                         instead of checking files. A request is the line\n"
+              "                         'check', the options and files to check (one on each\n"
+              "                         line) and an empty line. The results are sent back\n"
+              "                         and the connection is closed. The caches stay warm\n"
+              "                         between the requests. The request 'shutdown' stops\n"
+              "                         the server. Not supported on Windows.\n"
+              "    --shard=<i>/<N>      Check only the part <i> of <N> parts of the files. The\n"
+              "                         files are split by size in the same way on every\n"
+              "                         machine, so <N> machines can each check one part.\n"
+              "                         Combine the --xml-version=2 results of the parts with\n"
+              "                         tools/mergeshards.py. unusedFunction needs all files\n"
+              "                         and is not reliable with this option.\n"
               "    --std=<id>           Set standard.\n"
               "                         The available options are:\n"
               "                          * posix\n"
@@ -862,6 +1106,11 @@ void CmdLineParser::PrintHelp()
               "                         '{file}:{line},{severity},{id},{message}' or\n"
               "                         '{file}({line}):({severity}) {message}'\n"
               "                         Pre-defined templates: gcc, vs, edit.\n"
+              "    --timings-file=<file>\n"
+              "                         Keep the time it takes to check each file in <file>.\n"
+              "                         With '-j' the files that took longest in the previous\n"
+              "                         run are checked first, and files without timings are\n"
+              "                         ordered by size. The file is updated after the run.\n"
               "    -v, --verbose        Output more detailed error information.\n"
               "    --version            Print out version number.\n"
               "    --xml                Write results in xml format to error stream (stderr).\n"
@@ -0,0 +1,369 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2013 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "compiledatabase.h"
+#include "path.h"
+#include <fstream>
+#include <sstream>
+#include <cctype>
+
+namespace {
+    /** @brief Reads the few JSON values of a compilation database */
+    class JsonReader {
+    public:
+        explicit JsonReader(std::istream &istr) : _pos(0) {
+            std::ostringstream ostr;
+            ostr << istr.rdbuf();
+            _json = ostr.str();
+        }
+
+        /** @brief Skip whitespace, return the next character or 0 at the end */
+        char peek() {
+            while (_pos < _json.size() && std::isspace(static_cast<unsigned char>(_json[_pos])))
+                ++_pos;
+            return _pos < _json.size() ? _json[_pos] : '\0';
+        }
+
+        bool expect(char c) {
+            if (peek() != c)
+                return false;
+            ++_pos;
+            return true;
+        }
+
+        bool readString(std::string &str) {
+            if (!expect('"'))
+                return false;
+            str.clear();
+            while (_pos < _json.size()) {
+                const char c = _json[_pos++];
+                if (c == '"')
+                    return true;
+                if (c != '\\') {
+                    str += c;
+                    continue;
+                }
+                if (_pos >= _json.size())
+                    return false;
+                const char e = _json[_pos++];
+                switch (e) {
+                case 'b':
+                    str += '\b';
+                    break;
+                case 'f':
+                    str += '\f';
+                    break;
+                case 'n':
+                    str += '\n';
+                    break;
+                case 'r':
+                    str += '\r';
+                    break;
+                case 't':
+                    str += '\t';
+                    break;
+                case 'u': {
+                    if (_pos + 4 > _json.size())
+                        return false;
+                    unsigned int code = 0;
+                    std::istringstream hex(_json.substr(_pos, 4));
+                    if (!(hex >> std::hex >> code))
+                        return false;
+                    _pos += 4;
+                    // Paths and flags are ASCII
+                    str += (code < 0x80) ? static_cast<char>(code) : '?';
+                    break;
+                }
+                default:
+                    str += e;
+                }
+            }
+            return false;
+        }
+
+        bool readStringArray(std::vector<std::string> &array) {
+            if (!expect('['))
+                return false;
+            array.clear();
+            if (expect(']'))
+                return true;
+            do {
+                std::string str;
+                if (!readString(str))
+                    return false;
+                array.push_back(str);
+            } while (expect(','));
+            return expect(']');
+        }
+
+        /** @brief Skip a value that is not used */
+        bool skipValue() {
+            const char c = peek();
+            if (c == '"') {
+                std::string str;
+                return readString(str);
+            }
+            if (c == '[' || c == '{') {
+                const char end = (c == '[') ? ']' : '}';
+                ++_pos;
+                if (expect(end))
+                    return true;
+                do {
+                    if (c == '{') {
+                        std::string key;
+                        if (!readString(key) || !expect(':'))
+                            return false;
+                    }
+                    if (!skipValue())
+                        return false;
+                } while (expect(','));
+                return expect(end);
+            }
+            // Number, true, false or null
+            const std::string::size_type start = _pos;
+            while (_pos < _json.size() && (std::isalnum(static_cast<unsigned char>(_json[_pos])) || _json[_pos] == '-' || _json[_pos] == '+' || _json[_pos] == '.'))
+                ++_pos;
+            return _pos > start;
+        }
+
+        std::string::size_type position() const {
+            return _pos;
+        }
+
+    private:
+        std::string _json;
+        std::string::size_type _pos;
+    };
+
+    bool sameFlags(const Settings::FileSettings &fs1, const Settings::FileSettings &fs2)
+    {
+        return fs1.defines == fs2.defines &&
+               fs1.undefs == fs2.undefs &&
+               fs1.includePaths == fs2.includePaths &&
+               fs1.userIncludes == fs2.userIncludes;
+    }
+}
+
+bool CompileDatabase::load(const std::string &filename, Settings &settings, std::string &errmsg)
+{
+    std::ifstream fin(filename.c_str());
+    if (!fin.is_open()) {
+        errmsg = "could not open the file";
+        return false;
+    }
+    return parse(fin, settings, settings.fileSettings, errmsg);
+}
+
+bool CompileDatabase::parse(std::istream &istr, const Settings &settings, std::map<std::string, Settings::FileSettings> &files, std::string &errmsg)
+{
+    JsonReader json(istr);
+
+    if (!json.expect('[')) {
+        errmsg = "an array of commands is expected";
+        return false;
+    }
+    if (json.expect(']'))
+        return true;
+
+    do {
+        std::string directory, file, command;
+        std::vector<std::string> arguments;
+
+        bool valid = json.expect('{');
+        if (valid && !json.expect('}')) {
+            do {
+                std::string key;
+                if (!json.readString(key) || !json.expect(':'))
+                    valid = false;
+                else if (key == "directory")
+                    valid = json.readString(directory);
+                else if (key == "file")
+                    valid = json.readString(file);
+                else if (key == "command")
+                    valid = json.readString(command);
+                else if (key == "arguments")
+                    valid = json.readStringArray(arguments);
+                else
+                    valid = json.skipValue();
+            } while (valid && json.expect(','));
+            valid = valid && json.expect('}');
+        }
+        if (!valid) {
+            std::ostringstream ostr;
+            ostr << "invalid JSON at offset " << json.position();
+            errmsg = ostr.str();
+            return false;
+        }
+        if (file.empty()) {
+            errmsg = "a command without \"file\"";
+            return false;
+        }
+
+        if (arguments.empty())
+            arguments = splitCommand(command);
+        const Settings::FileSettings fs = getFileSettings(directory, file, arguments, settings);
+
+        // A file that is compiled more than once is checked once for each
+        // set of flags
+        std::string name = fs.filename;
+        for (unsigned int count = 2; files.find(name) != files.end(); ++count) {
+            if (sameFlags(files[name], fs)) {
+                name.clear();
+                break;
+            }
+            std::ostringstream ostr;
+            ostr << fs.filename << " (" << count << ")";
+            name = ostr.str();
+        }
+        if (!name.empty())
+            files[name] = fs;
+    } while (json.expect(','));
+
+    if (!json.expect(']') || json.peek() != '\0') {
+        std::ostringstream ostr;
+        ostr << "invalid JSON at offset " << json.position();
+        errmsg = ostr.str();
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::string> CompileDatabase::splitCommand(const std::string &command)
+{
+    std::vector<std::string> arguments;
+    std::string argument;
+    bool inArgument = false;
+    char quote = '\0';
+
+    for (std::string::size_type i = 0; i < command.size(); ++i) {
+        const char c = command[i];
+        if (quote == '\'') {
+            if (c == '\'')
+                quote = '\0';
+            else
+                argument += c;
+        } else if (c == '\\' && i + 1 < command.size() &&
+                   (quote == '\0' || command[i+1] == '"' || command[i+1] == '\\')) {
+            argument += command[++i];
+            inArgument = true;
+        } else if (quote == '"') {
+            if (c == '"')
+                quote = '\0';
+            else
+                argument += c;
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+            inArgument = true;
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            if (inArgument)
+                arguments.push_back(argument);
+            argument.clear();
+            inArgument = false;
+        } else {
+            argument += c;
+            inArgument = true;
+        }
+    }
+    if (inArgument)
+        arguments.push_back(argument);
+
+    return arguments;
+}
+
+Settings::FileSettings CompileDatabase::getFileSettings(const std::string &directory, const std::string &file, const std::vector<std::string> &arguments, const Settings &settings)
+{
+    // The flags of the command line come first
+    Settings::FileSettings fs;
+    fs.filename = Path::toNativeSeparators(absolutePath(directory, file));
+    fs.defines = settings.userDefines;
+    fs.undefs = settings.userUndefs;
+    fs.includePaths = settings._includePaths;
+    fs.userIncludes = settings.userIncludes;
+
+    // arguments[0] is the compiler
+    for (std::vector<std::string>::size_type i = 1; i < arguments.size(); ++i) {
+        const std::string &arg = arguments[i];
+
+        std::string flag, value;
+        if (arg == "-isystem" || arg == "-iquote" || arg == "-include") {
+            flag = arg;
+        } else if (arg.compare(0, 8, "-isystem") == 0 || arg.compare(0, 7, "-iquote") == 0) {
+            flag = arg.substr(0, arg[2] == 's' ? 8 : 7);
+            value = arg.substr(flag.size());
+        } else if (arg.size() >= 2 && arg[0] == '-' && (arg[1] == 'D' || arg[1] == 'U' || arg[1] == 'I')) {
+            flag = arg.substr(0, 2);
+            value = arg.substr(2);
+        } else {
+            continue;
+        }
+
+        // "-D define"
+        if (value.empty()) {
+            if (i + 1 >= arguments.size())
+                break;
+            value = arguments[++i];
+        }
+
+        if (flag == "-D") {
+            // No "=", append a "=1"
+            if (value.find('=') == std::string::npos)
+                value += "=1";
+
+            // DEF= => empty define
+            else if (value.find('=') + 1U == value.size())
+                value.erase(value.size() - 1U);
+
+            if (!fs.defines.empty())
+                fs.defines += ";";
+            fs.defines += value;
+        } else if (flag == "-U") {
+            fs.undefs.insert(value);
+        } else if (flag == "-include") {
+            fs.userIncludes.push_back(absolutePath(directory, value));
+        } else {
+            std::string path = absolutePath(directory, value);
+            if (path[path.length()-1] != '/')
+                path += '/';
+            fs.includePaths.push_back(path);
+        }
+    }
+
+    return fs;
+}
+
+std::string CompileDatabase::absolutePath(const std::string &directory, const std::string &path)
+{
+    std::string result = Path::fromNativeSeparators(Path::removeQuotationMarks(path));
+    const bool absolute = (!result.empty() && result[0] == '/') ||
+                          (result.size() > 1 && result[1] == ':');
+    if (!absolute && !directory.empty()) {
+        std::string dir = Path::fromNativeSeparators(directory);
+        if (dir[dir.length()-1] != '/')
+            dir += '/';
+        result = dir + result;
+    }
+
+    // Remove the "." parts, simplifyPath() removes the ".." parts
+    std::string::size_type pos;
+    while ((pos = result.find("/./")) != std::string::npos)
+        result.erase(pos, 2);
+    if (result.size() > 2 && result.compare(result.size() - 2, 2, "/.") == 0)
+        result.erase(result.size() - 1);
+
+    return Path::simplifyPath(result.c_str());
+}
@@ -0,0 +1,84 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2013 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPILEDATABASE_H
+#define COMPILEDATABASE_H
+
+#include <istream>
+#include <map>
+#include <string>
+#include <vector>
+#include "settings.h"
+
+/// @addtogroup CLI
+/// @{
+
+/**
+ * @brief Read the files to check and their flags from a compilation
+ * database (compile_commands.json).
+ *
+ * Each file is checked in the configuration it is compiled with: the
+ * -D, -U, -I and -include flags of its command are added to the ones
+ * given on the command line.
+ */
+class CompileDatabase {
+public:
+    /**
+     * @brief Read the compilation database into settings.fileSettings.
+     * @param filename The compile_commands.json file
+     * @param settings The settings of the command line. The flags of the
+     *   files are added to them.
+     * @param errmsg Set to the reason when the file can't be read.
+     * @return true if the file was read
+     */
+    static bool load(const std::string &filename, Settings &settings, std::string &errmsg);
+
+    /**
+     * @brief Parse the JSON of a compilation database.
+     * @param istr The JSON
+     * @param settings The settings of the command line
+     * @param files The files are added here, see Settings::fileSettings
+     * @param errmsg Set to the reason when the JSON is invalid.
+     * @return true if the JSON was parsed
+     */
+    static bool parse(std::istream &istr, const Settings &settings, std::map<std::string, Settings::FileSettings> &files, std::string &errmsg);
+
+    /**
+     * @brief Split a command into its arguments the way a shell does.
+     * Whitespace separates the arguments, quotes and backslashes keep
+     * the characters together.
+     */
+    static std::vector<std::string> splitCommand(const std::string &command);
+
+    /**
+     * @brief The flags of one entry of the database.
+     * @param directory The directory the command is run in
+     * @param file The compiled file
+     * @param arguments The command, the compiler first
+     * @param settings The settings of the command line
+     */
+    static Settings::FileSettings getFileSettings(const std::string &directory, const std::string &file, const std::vector<std::string> &arguments, const Settings &settings);
+
+private:
+    /** @brief Path relative to the directory of the command, simplified */
+    static std::string absolutePath(const std::string &directory, const std::string &path);
+};
+
+/// @}
+
+#endif // COMPILEDATABASE_H
@@ -17,10 +17,12 @@
  */
 
 #include "cppcheckexecutor.h"
+#include "analysisserver.h"
 #include "cppcheck.h"
 #include "threadexecutor.h"
 #include "preprocessor.h"
 #include "errorlogger.h"
+#include "token.h"
 #include <iostream>
 #include <sstream>
 #include <cstdlib> // EXIT_SUCCESS and EXIT_FAILURE
@@ -30,6 +32,7 @@
 
 #include "cmdlineparser.h"
 #include "filelister.h"
+#include "filescheduler.h"
 #include "path.h"
 #include "pathmatch.h"
 
@@ -89,9 +92,24 @@ bool CppCheckExecutor::parseFromArgs(CppCheck *cppcheck, int argc, const char* c
         }
     }
 
+    // The server gets the files to check in its requests
+    if (!settings.serverSocket.empty())
+        return true;
+
     const std::vector<std::string>& pathnames = parser.GetPathNames();
 
-    if (!pathnames.empty()) {
+    if (!settings.fileSettings.empty()) {
+        // The files of the compilation database, a file that is compiled
+        // with different flags is a job for each set of flags
+        for (std::map<std::string, Settings::FileSettings>::const_iterator fs = settings.fileSettings.begin(); fs != settings.fileSettings.end(); ++fs) {
+            std::map<std::string, std::size_t> file;
+            FileLister::recursiveAddFiles(file, fs->second.filename);
+            if (file.size() == 1)
+                _files[fs->first] = file.begin()->second;
+            else
+                std::cout << "cppcheck: warning: Couldn't find the file '" << fs->second.filename << "' of the project." << std::endl;
+        }
+    } else if (!pathnames.empty()) {
         // Execute recursiveAddFiles() to each given file parameter
         std::vector<std::string>::const_iterator iter;
         for (iter = pathnames.begin(); iter != pathnames.end(); ++iter)
@@ -135,6 +153,17 @@ bool CppCheckExecutor::parseFromArgs(CppCheck *cppcheck, int argc, const char* c
         return false;
     }
 
+    // Keep the files of this machine's part. A part may be empty when
+    // there are few files.
+    if (settings.shardCount > 1 && !_files.empty()) {
+        const std::vector<std::string> shard = FileScheduler(_files).shard(settings.shardIndex - 1, settings.shardCount);
+        std::map<std::string, std::size_t> files;
+        for (std::vector<std::string>::const_iterator it = shard.begin(); it != shard.end(); ++it)
+            files[*it] = _files[*it];
+        _files.swap(files);
+        return true;
+    }
+
     if (!_files.empty()) {
         return true;
     } else {
@@ -156,6 +185,13 @@ int CppCheckExecutor::check(int argc, const char* const argv[])
         return EXIT_FAILURE;
     }
 
+    if (!settings.serverSocket.empty()) {
+        AnalysisServer server(settings);
+        const int ret = server.run();
+        _settings = 0;
+        return ret;
+    }
+
     if (settings.reportProgress)
         time1 = std::time(0);
 
@@ -176,6 +212,7 @@ int CppCheckExecutor::check(int argc, const char* const argv[])
         unsigned int c = 0;
         for (std::map<std::string, std::size_t>::const_iterator i = _files.begin(); i != _files.end(); ++i) {
             returnValue += cppCheck.check(i->first);
+            Token::resetSymbols();
             processedsize += i->second;
             if (!settings._errorsOnly)
                 reportStatus(c + 1, _files.size(), processedsize, totalfilesize);
@@ -183,12 +220,22 @@ int CppCheckExecutor::check(int argc, const char* const argv[])
         }
 
         cppCheck.checkFunctionUsage();
+        reportCacheStatistics(cppCheck.cacheHits(), cppCheck.cacheMisses());
     } else if (!ThreadExecutor::isEnabled()) {
         std::cout << "No thread support yet implemented for this platform." << std::endl;
     } else {
         // Multiple processes
         ThreadExecutor executor(_files, settings, *this);
         returnValue = executor.check();
+
+        // Look for unused functions in the function usage of all jobs
+        if (settings.isEnabled("unusedFunction")) {
+            const std::list<std::string> &functionUsage = executor.functionUsage();
+            for (std::list<std::string>::const_iterator it = functionUsage.begin(); it != functionUsage.end(); ++it)
+                cppCheck.mergeFunctionUsage(*it);
+            cppCheck.checkFunctionUsage();
+        }
+        reportCacheStatistics(executor.cacheHits(), executor.cacheMisses());
     }
 
     if (!settings.checkConfiguration) {
@@ -279,6 +326,16 @@ void CppCheckExecutor::reportStatus(std::size_t fileindex, std::size_t filecount
     }
 }
 
+void CppCheckExecutor::reportCacheStatistics(unsigned int hits, unsigned int misses)
+{
+    if (_settings->cacheDir.empty() || _settings->_errorsOnly)
+        return;
+
+    std::ostringstream oss;
+    oss << "Cache: " << hits << " hits, " << misses << " misses";
+    reportOut(oss.str());
+}
+
 void CppCheckExecutor::reportErr(const ErrorLogger::ErrorMessage &msg)
 {
     if (errorlist) {
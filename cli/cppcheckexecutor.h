@@ -108,6 +108,13 @@ protected:
 
 private:
 
+    /**
+     * @brief Show how many configurations were found in the cache (--cache-dir)
+     * @param hits configurations whose results were read from the cache
+     * @param misses configurations that were checked
+     */
+    void reportCacheStatistics(unsigned int hits, unsigned int misses);
+
     /**
      * Pointer to current settings; set while check() is running.
      */
@@ -0,0 +1,186 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2013 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "filescheduler.h"
+#include <algorithm>
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
+/** @brief Sort the files by decreasing cost, and by name if the cost is the same */
+static bool moreCostly(const std::pair<double, std::string> &a, const std::pair<double, std::string> &b)
+{
+    if (a.first > b.first)
+        return true;
+    if (a.first < b.first)
+        return false;
+    return a.second < b.second;
+}
+
+/** @brief Memory per byte of source code assumed before any file is checked */
+static const double defaultMemoryPerByte = 100.0;
+
+FileScheduler::FileScheduler(const std::map<std::string, std::size_t> &files)
+    : _files(files), _measuredMemory(0), _measuredSize(0)
+{
+}
+
+void FileScheduler::loadTimings(std::istream &istr)
+{
+    std::string line;
+    while (std::getline(istr, line)) {
+        std::istringstream iss(line);
+        double seconds = 0;
+        if (!(iss >> seconds) || seconds < 0)
+            continue;
+
+        // The rest of the line after the separating space is the file name
+        std::string file;
+        iss.get();
+        std::getline(iss, file);
+        if (!file.empty())
+            _timings[file] = seconds;
+    }
+}
+
+void FileScheduler::saveTimings(std::ostream &ostr) const
+{
+    for (std::map<std::string, double>::const_iterator it = _timings.begin(); it != _timings.end(); ++it)
+        ostr << it->second << ' ' << it->first << '\n';
+}
+
+void FileScheduler::setTiming(const std::string &file, double seconds)
+{
+    _timings[file] = seconds;
+}
+
+double FileScheduler::secondsPerByte() const
+{
+    double seconds = 0;
+    double size = 0;
+    for (std::map<std::string, std::size_t>::const_iterator it = _files.begin(); it != _files.end(); ++it) {
+        const std::map<std::string, double>::const_iterator timing = _timings.find(it->first);
+        if (timing != _timings.end() && it->second > 0) {
+            seconds += timing->second;
+            size += static_cast<double>(it->second);
+        }
+    }
+
+    // Without timings only the relative sizes of the files matter
+    if (seconds <= 0 || size <= 0)
+        return 1.0;
+    return seconds / size;
+}
+
+double FileScheduler::cost(const std::string &file) const
+{
+    const std::map<std::string, double>::const_iterator timing = _timings.find(file);
+    if (timing != _timings.end())
+        return timing->second;
+
+    const std::map<std::string, std::size_t>::const_iterator it = _files.find(file);
+    if (it == _files.end())
+        return 0;
+    return static_cast<double>(it->second) * secondsPerByte();
+}
+
+void FileScheduler::setMemory(const std::string &file, std::size_t bytes)
+{
+    const std::map<std::string, std::size_t>::const_iterator it = _files.find(file);
+    if (it != _files.end() && it->second > 0 && _memory.find(file) == _memory.end()) {
+        _measuredMemory += static_cast<double>(bytes);
+        _measuredSize += static_cast<double>(it->second);
+    }
+    _memory[file] = bytes;
+}
+
+std::size_t FileScheduler::memory(const std::string &file) const
+{
+    const std::map<std::string, std::size_t>::const_iterator measured = _memory.find(file);
+    if (measured != _memory.end())
+        return measured->second;
+
+    const std::map<std::string, std::size_t>::const_iterator it = _files.find(file);
+    if (it == _files.end())
+        return 0;
+    const double perByte = (_measuredSize > 0) ? (_measuredMemory / _measuredSize) : defaultMemoryPerByte;
+    return static_cast<std::size_t>(static_cast<double>(it->second) * perByte);
+}
+
+std::vector<std::string> FileScheduler::order() const
+{
+    const double perByte = secondsPerByte();
+
+    std::vector<std::pair<double, std::string> > costs;
+    costs.reserve(_files.size());
+    for (std::map<std::string, std::size_t>::const_iterator it = _files.begin(); it != _files.end(); ++it) {
+        const std::map<std::string, double>::const_iterator timing = _timings.find(it->first);
+        if (timing != _timings.end())
+            costs.push_back(std::make_pair(timing->second, it->first));
+        else
+            costs.push_back(std::make_pair(static_cast<double>(it->second) * perByte, it->first));
+    }
+
+    std::sort(costs.begin(), costs.end(), moreCostly);
+
+    std::vector<std::string> files;
+    files.reserve(costs.size());
+    for (std::vector<std::pair<double, std::string> >::const_iterator it = costs.begin(); it != costs.end(); ++it)
+        files.push_back(it->second);
+    return files;
+}
+
+std::vector<std::string> FileScheduler::shard(unsigned int index, unsigned int count) const
+{
+    std::vector<std::pair<double, std::string> > sizes;
+    sizes.reserve(_files.size());
+    for (std::map<std::string, std::size_t>::const_iterator it = _files.begin(); it != _files.end(); ++it)
+        sizes.push_back(std::make_pair(static_cast<double>(it->second), it->first));
+    std::sort(sizes.begin(), sizes.end(), moreCostly);
+
+    // The biggest file goes to the smallest part. Empty files count as
+    // one byte so that they are spread over the parts too.
+    std::vector<double> total(count, 0.0);
+    std::vector<std::string> files;
+    for (std::vector<std::pair<double, std::string> >::const_iterator it = sizes.begin(); it != sizes.end(); ++it) {
+        unsigned int smallest = 0;
+        for (unsigned int part = 1; part < count; ++part) {
+            if (total[part] < total[smallest])
+                smallest = part;
+        }
+        total[smallest] += std::max(it->first, 1.0);
+        if (smallest == index)
+            files.push_back(it->second);
+    }
+    return files;
+}
+
+double FileScheduler::now()
+{
+#ifdef _WIN32
+    return GetTickCount() / 1000.0;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return static_cast<double>(tv.tv_sec) + static_cast<double>(tv.tv_usec) / 1000000.0;
+#endif
+}
@@ -0,0 +1,109 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2013 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef filescheduler_H
+#define filescheduler_H
+
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/// @addtogroup CLI
+/// @{
+
+/**
+ * @brief Decide in which order the files are checked by the jobs.
+ *
+ * The most costly files are started first so that a big file that happens
+ * to be last in alphabetical order does not keep one job busy while the
+ * others are already done. The cost of a file is the time it took to check
+ * it in a previous run (see loadTimings()). Files without a timing are
+ * estimated from their size.
+ */
+class FileScheduler {
+public:
+    /**
+     * @param files the files to check, the value is the size of the file
+     */
+    explicit FileScheduler(const std::map<std::string, std::size_t> &files);
+
+    /**
+     * @brief Read the timings of a previous run. Each line is the
+     * time in seconds followed by a space and the file name.
+     */
+    void loadTimings(std::istream &istr);
+
+    /**
+     * @brief Write the timings in the format read by loadTimings().
+     * Timings of files that were not checked in this run are kept.
+     */
+    void saveTimings(std::ostream &ostr) const;
+
+    /** @brief Record how many seconds it took to check a file */
+    void setTiming(const std::string &file, double seconds);
+
+    /** @brief Estimated cost of checking the file */
+    double cost(const std::string &file) const;
+
+    /** @brief Record how many bytes of memory checking the file took */
+    void setMemory(const std::string &file, std::size_t bytes);
+
+    /**
+     * @brief Estimated bytes of memory needed to check the file. Files
+     * that are not checked yet are estimated from their size and the
+     * memory used per byte by the files that are checked.
+     */
+    std::size_t memory(const std::string &file) const;
+
+    /** @brief The files ordered by cost, most costly first */
+    std::vector<std::string> order() const;
+
+    /**
+     * @brief Split the files in parts of about the same total size and
+     * return one part. Only the sizes are used, not the timings, so all
+     * machines that have the same files get the same parts.
+     * @param index the part, 0..count-1
+     * @param count number of parts
+     */
+    std::vector<std::string> shard(unsigned int index, unsigned int count) const;
+
+    /** @brief Current wall clock time in seconds */
+    static double now();
+
+private:
+    const std::map<std::string, std::size_t> &_files;
+
+    /** @brief Seconds it took to check a file */
+    std::map<std::string, double> _timings;
+
+    /** @brief Estimated seconds per byte, used for files without a timing */
+    double secondsPerByte() const;
+
+    /** @brief Bytes of memory it took to check a file */
+    std::map<std::string, std::size_t> _memory;
+
+    /** @brief Total memory and total size of the files in _memory */
+    double _measuredMemory;
+    double _measuredSize;
+};
+
+/// @}
+
+#endif // filescheduler_H
@@ -0,0 +1,201 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2013 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "jobserver.h"
+#include <cstdlib>
+
+#ifndef _WIN32
+#include <sys/select.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstdio>
+#include <cstring>
+#endif
+
+JobServer::JobServer()
+    : _authRead(-1), _authWrite(-1), _rfd(-1), _wfd(-1)
+{
+}
+
+JobServer::~JobServer()
+{
+    releaseAll();
+#ifndef _WIN32
+    if (_rfd >= 0)
+        close(_rfd);
+    if (!_fifo.empty() && _wfd >= 0)
+        close(_wfd);
+#endif
+}
+
+bool JobServer::parse(const std::string &makeflags)
+{
+    _authRead = _authWrite = -1;
+    _fifo.clear();
+
+    // When the option is given several times the last one is used
+    std::string value;
+    const char * const options[] = { "--jobserver-auth=", "--jobserver-fds=" };
+    std::string::size_type found = std::string::npos;
+    for (std::size_t i = 0; i < sizeof(options) / sizeof(*options); ++i) {
+        const std::string option(options[i]);
+        const std::string::size_type pos = makeflags.rfind(option);
+        if (pos == std::string::npos || (found != std::string::npos && pos < found))
+            continue;
+        found = pos;
+        const std::string::size_type start = pos + option.size();
+        value = makeflags.substr(start, makeflags.find_first_of(" \t", start) - start);
+    }
+    if (found == std::string::npos)
+        return false;
+
+    if (value.compare(0, 5, "fifo:") == 0) {
+        _fifo = value.substr(5);
+        return !_fifo.empty();
+    }
+
+    const std::string::size_type comma = value.find(',');
+    if (comma == std::string::npos || comma == 0 || comma + 1 == value.size() ||
+        value.find_first_not_of("0123456789,") != std::string::npos)
+        return false;
+    _authRead = std::atoi(value.substr(0, comma).c_str());
+    _authWrite = std::atoi(value.substr(comma + 1).c_str());
+    return true;
+}
+
+#ifndef _WIN32
+
+bool JobServer::connect()
+{
+    if (!_fifo.empty()) {
+        _rfd = open(_fifo.c_str(), O_RDONLY | O_NONBLOCK);
+        if (_rfd < 0)
+            return false;
+        _wfd = open(_fifo.c_str(), O_WRONLY);
+        if (_wfd < 0) {
+            close(_rfd);
+            _rfd = -1;
+            return false;
+        }
+        return true;
+    }
+
+    // Make does not pass the descriptors to commands that it does not
+    // consider to be recursive make invocations
+    if (_authRead < 0 || fcntl(_authRead, F_GETFD) == -1 || fcntl(_authWrite, F_GETFD) == -1)
+        return false;
+
+    // The pipe is shared with make and the other clients, so it can't be
+    // made non-blocking. Opening it again gives a descriptor of our own
+    // that can be. Without that the jobserver is not used: another client
+    // can take a token between a check and a blocking read, and the read
+    // would wait until make has a token again.
+    char path[64];
+    std::sprintf(path, "/proc/self/fd/%d", _authRead);
+    _rfd = open(path, O_RDONLY | O_NONBLOCK);
+    if (_rfd < 0)
+        return false;
+    _wfd = _authWrite;
+    return true;
+}
+
+bool JobServer::tryAcquire()
+{
+    if (_rfd < 0)
+        return false;
+
+    // The descriptor is non-blocking, another client may still take the
+    // token after poll()
+    struct pollfd pfd;
+    pfd.fd = _rfd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, 0) <= 0 || !(pfd.revents & POLLIN))
+        return false;
+
+    char token;
+    ssize_t n;
+    do {
+        n = read(_rfd, &token, 1);
+    } while (n < 0 && errno == EINTR);
+    if (n != 1)
+        return false;
+
+    _tokens += token;
+    return true;
+}
+
+void JobServer::wait(int milliseconds) const
+{
+    // Without a jobserver this just sleeps
+    fd_set rfds;
+    FD_ZERO(&rfds);
+    if (_rfd >= 0)
+        FD_SET(_rfd, &rfds);
+    struct timeval tv;
+    tv.tv_sec = milliseconds / 1000;
+    tv.tv_usec = (milliseconds % 1000) * 1000;
+    select(_rfd + 1, &rfds, NULL, NULL, &tv);
+}
+
+void JobServer::release()
+{
+    if (_tokens.empty())
+        return;
+
+    const char token = _tokens[_tokens.size() - 1];
+    ssize_t n;
+    do {
+        n = write(_wfd, &token, 1);
+    } while (n < 0 && errno == EINTR);
+    _tokens.erase(_tokens.size() - 1);
+}
+
+#else
+
+// The jobserver of make on Windows is a semaphore, that is not supported
+
+bool JobServer::connect()
+{
+    return false;
+}
+
+bool JobServer::tryAcquire()
+{
+    return false;
+}
+
+void JobServer::wait(int) const
+{
+}
+
+void JobServer::release()
+{
+}
+
+#endif
+
+void JobServer::releaseAll()
+{
+    while (!_tokens.empty())
+        release();
+}
@@ -0,0 +1,128 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2013 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef jobserver_H
+#define jobserver_H
+
+#include <string>
+
+/// @addtogroup CLI
+/// @{
+
+/**
+ * @brief Client of the GNU make jobserver.
+ *
+ * When cppcheck is run by "make -jN" it can share the job slots of make
+ * instead of using a fixed number of jobs. Make passes a pipe (or a named
+ * fifo) in MAKEFLAGS that holds one byte, a token, for each free job slot.
+ * A client reads a token before it starts a job and writes the same byte
+ * back when the job is done. Each client also has one implicit slot that
+ * needs no token, so a client that holds N tokens may run N+1 jobs.
+ */
+class JobServer {
+public:
+    JobServer();
+
+    /** @brief Returns the held tokens and closes the jobserver */
+    ~JobServer();
+
+    /**
+     * @brief Find the jobserver in the value of MAKEFLAGS. Both
+     * "--jobserver-auth=R,W" (and the older "--jobserver-fds=R,W") with
+     * file descriptors and "--jobserver-auth=fifo:PATH" are supported.
+     * @return true if a jobserver was given
+     */
+    bool parse(const std::string &makeflags);
+
+    /**
+     * @brief Open the jobserver found by parse().
+     * @return false if it can't be used, for instance because make did not
+     * pass the file descriptors to this process, or because the pipe can't
+     * be opened again as a non-blocking descriptor
+     */
+    bool connect();
+
+    /** @brief Is the jobserver connected? */
+    bool connected() const {
+        return _rfd >= 0;
+    }
+
+    /** @brief Read end of the jobserver, it is readable when a token might be available */
+    int readFd() const {
+        return _rfd;
+    }
+
+    /**
+     * @brief Take a token if one is available, without waiting
+     * @return true if a token was taken
+     */
+    bool tryAcquire();
+
+    /**
+     * @brief Wait until a token might be available. Without a connected
+     * jobserver this sleeps.
+     * @param milliseconds maximum time to wait
+     */
+    void wait(int milliseconds) const;
+
+    /** @brief Give one of the held tokens back */
+    void release();
+
+    /** @brief Give all held tokens back */
+    void releaseAll();
+
+    /** @brief Number of tokens held */
+    std::size_t tokens() const {
+        return _tokens.size();
+    }
+
+    /** @brief File descriptors given in MAKEFLAGS, -1 if none */
+    int authReadFd() const {
+        return _authRead;
+    }
+    int authWriteFd() const {
+        return _authWrite;
+    }
+
+    /** @brief Path of the fifo given in MAKEFLAGS, empty if none */
+    const std::string &fifo() const {
+        return _fifo;
+    }
+
+private:
+    int _authRead;
+    int _authWrite;
+    std::string _fifo;
+
+    /** @brief Descriptors used to take and give back tokens */
+    int _rfd;
+    int _wfd;
+
+    /** @brief The held tokens. Make wants the same bytes back. */
+    std::string _tokens;
+
+    /** disabled copy constructor */
+    JobServer(const JobServer &);
+
+    /** disabled assignment operator */
+    void operator=(const JobServer &);
+};
+
+/// @}
+
+#endif // jobserver_H
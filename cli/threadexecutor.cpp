@@ -19,19 +19,26 @@
 #include "cppcheckexecutor.h"
 #include "threadexecutor.h"
 #include "cppcheck.h"
-#ifdef THREADING_MODEL_FORK
+#include "timer.h"
+#include "token.h"
 #include <algorithm>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
+#ifdef THREADING_MODEL_FORK
+#include "threadpool.h"
 #include <sys/select.h>
+#include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <cstdlib>
 #include <cstdio>
 #include <errno.h>
+#include <signal.h>
 #include <time.h>
 #include <cstring>
-#include <sstream>
 #endif
 #ifdef THREADING_MODEL_WIN
 #include <process.h>
@@ -45,11 +52,21 @@
 using std::memset;
 
 ThreadExecutor::ThreadExecutor(const std::map<std::string, std::size_t> &files, Settings &settings, ErrorLogger &errorLogger)
-    : _files(files), _settings(settings), _errorLogger(errorLogger), _fileCount(0)
+    : _files(files), _settings(settings), _errorLogger(errorLogger), _fileCount(0), _cacheHits(0), _cacheMisses(0), _scheduler(files), _startTime(0)
 {
 #if defined(THREADING_MODEL_FORK)
     _wpipe = 0;
+    _threadCount = 0;
+    _processedSize = 0;
+    _totalFileSize = 0;
+    _threadResult = 0;
+    _useJobServer = false;
+    _busyThreads = 0;
+    _baseMemory = 0;
+    _threadFileMemory = 0;
 #elif defined(THREADING_MODEL_WIN)
+    _threadCount = 0;
+    _busyThreads = 0;
     _processedFiles = 0;
     _totalFiles = 0;
     _processedSize = 0;
@@ -62,6 +79,68 @@ ThreadExecutor::~ThreadExecutor()
     //dtor
 }
 
+void ThreadExecutor::startScheduling()
+{
+    if (!_settings.timingsFile.empty()) {
+        std::ifstream fin(_settings.timingsFile.c_str());
+        if (fin.is_open())
+            _scheduler.loadTimings(fin);
+    }
+
+    _order = _scheduler.order();
+    _busyTime.assign(_settings._jobs, 0.0);
+    _startTime = FileScheduler::now();
+}
+
+void ThreadExecutor::finishScheduling()
+{
+    const double wallTime = FileScheduler::now() - _startTime;
+
+    if (!_settings.timingsFile.empty()) {
+        std::ofstream fout(_settings.timingsFile.c_str());
+        if (fout.is_open())
+            _scheduler.saveTimings(fout);
+        else
+            std::cerr << "cppcheck: Failed to write timings file '" << _settings.timingsFile << "'" << std::endl;
+    }
+
+    for (std::map<std::string, std::size_t>::const_iterator it = _delayedFiles.begin(); it != _delayedFiles.end(); ++it) {
+        std::ostringstream oss;
+        oss << "Delayed by --max-memory: " << it->first << " (estimated " << (it->second + 1024 * 1024 - 1) / (1024 * 1024) << " MB)";
+        _errorLogger.reportOut(oss.str());
+    }
+
+    if (_settings._showtime != SHOWTIME_NONE) {
+        for (std::size_t job = 0; job < _busyTime.size(); ++job) {
+            std::ostringstream oss;
+            oss << std::fixed << std::setprecision(3)
+                << "Job " << (job + 1) << ": busy " << _busyTime[job] << "s, idle " << std::max(0.0, wallTime - _busyTime[job]) << "s";
+            _errorLogger.reportOut(oss.str());
+        }
+    }
+}
+
+std::size_t ThreadExecutor::fileSize(const std::string &file) const
+{
+    const std::map<std::string, std::size_t>::const_iterator it = _files.find(file);
+    return (it != _files.end()) ? it->second : 0;
+}
+
+bool ThreadExecutor::fitsMemory(const std::string &file, unsigned long long used, std::size_t busy)
+{
+    // A file is always started when nothing else is checked, even if it
+    // is estimated to need more than the budget
+    if (_settings.maxMemory == 0 || busy == 0)
+        return true;
+
+    const std::size_t memory = _scheduler.memory(file);
+    if (used + memory <= _settings.maxMemory)
+        return true;
+
+    _delayedFiles[file] = memory;
+    return false;
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 ////// This code is for platforms that support fork() only ////////////////////
@@ -74,38 +153,74 @@ void ThreadExecutor::addFileContent(const std::string &path, const std::string &
     _fileContents[ path ] = content;
 }
 
-int ThreadExecutor::handleRead(int rpipe, unsigned int &result)
+/**
+ * Read exactly @p len bytes from the pipe. The read end of the pipe is
+ * non-blocking in the master process so wait until the rest of a
+ * partially written message is available.
+ * @return false if the pipe was closed or could not be read
+ */
+static bool readFromPipe(int rpipe, void *buf, std::size_t len)
 {
-    char type = 0;
-    if (read(rpipe, &type, 1) <= 0) {
-        if (errno == EAGAIN)
-            return 0;
-
-        return -1;
+    char *p = static_cast<char *>(buf);
+    while (len > 0) {
+        const ssize_t n = read(rpipe, p, len);
+        if (n > 0) {
+            p += n;
+            len -= static_cast<std::size_t>(n);
+        } else if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+            fd_set rfds;
+            FD_ZERO(&rfds);
+            FD_SET(rpipe, &rfds);
+            select(rpipe + 1, &rfds, NULL, NULL, NULL);
+        } else {
+            return false;
+        }
     }
+    return true;
+}
 
-    if (type != REPORT_OUT && type != REPORT_ERROR && type != REPORT_INFO && type != CHILD_END) {
-        std::cerr << "#### You found a bug from cppcheck.\nThreadExecutor::handleRead error, type was:" << type << std::endl;
-        std::exit(0);
-    }
+int ThreadExecutor::handleRead(Worker &worker, unsigned int &result)
+{
+    // Read all that is available, the worker sends its messages in batches
+    char buf[65536];
+    const ssize_t n = read(worker.rpipe, buf, sizeof(buf));
+    if (n < 0 && (errno == EAGAIN || errno == EINTR))
+        return 0;
+    if (n <= 0)
+        return -1;
+    worker.input.append(buf, static_cast<std::size_t>(n));
+
+    // Handle the complete messages. Each message is the type, the length
+    // of the data and the data.
+    int ret = 1;
+    const std::size_t headerSize = 1 + sizeof(unsigned int);
+    std::size_t pos = 0;
+    while (worker.input.size() - pos >= headerSize) {
+        const char type = worker.input[pos];
+        unsigned int len = 0;
+        std::memcpy(&len, worker.input.data() + pos + 1, sizeof(len));
+        if (worker.input.size() - pos - headerSize < len)
+            break;
 
-    unsigned int len = 0;
-    if (read(rpipe, &len, sizeof(len)) <= 0) {
-        std::cerr << "#### You found a bug from cppcheck.\nThreadExecutor::handleRead error, type was:" << type << std::endl;
-        std::exit(0);
+        if (handleMessage(worker, type, worker.input.data() + pos + headerSize, len, result))
+            ret = 2;
+        pos += headerSize + len;
     }
+    worker.input.erase(0, pos);
 
-    char *buf = new char[len];
-    if (read(rpipe, buf, len) <= 0) {
-        std::cerr << "#### You found a bug from cppcheck.\nThreadExecutor::handleRead error, type was:" << type << std::endl;
-        std::exit(0);
-    }
+    return ret;
+}
 
+bool ThreadExecutor::handleMessage(Worker &worker, char type, const char *data, std::size_t len, unsigned int &result)
+{
     if (type == REPORT_OUT) {
-        _errorLogger.reportOut(buf);
+        _errorLogger.reportOut(std::string(data, len));
     } else if (type == REPORT_ERROR || type == REPORT_INFO) {
         ErrorLogger::ErrorMessage msg;
-        msg.deserialize(buf);
+        if (!msg.deserializeBinary(data, len)) {
+            std::cerr << "#### You found a bug from cppcheck.\nThreadExecutor::handleMessage error, invalid message" << std::endl;
+            std::exit(0);
+        }
 
         std::string file;
         unsigned int line(0);
@@ -116,29 +231,327 @@ int ThreadExecutor::handleRead(int rpipe, unsigned int &result)
 
         if (!_settings.nomsg.isSuppressed(msg._id, file, line)) {
             // Alert only about unique errors
-            std::string errmsg = msg.toString(_settings._verbose);
-            if (std::find(_errorList.begin(), _errorList.end(), errmsg) == _errorList.end()) {
-                _errorList.push_back(errmsg);
+            if (_errorFingerprints.insert(msg.fingerprint(_settings._verbose)).second) {
                 if (type == REPORT_ERROR)
                     _errorLogger.reportErr(msg);
                 else
                     _errorLogger.reportInfo(msg);
             }
         }
+    } else if (type == REPORT_FUNCTION_USAGE) {
+        _functionUsage.push_back(std::string(data, len));
+    } else if (type == REPORT_CACHE_STATS) {
+        std::istringstream iss(std::string(data, len));
+        unsigned int hits = 0, misses = 0;
+        iss >> hits >> misses;
+        _cacheHits += hits;
+        _cacheMisses += misses;
     } else if (type == CHILD_END) {
-        std::istringstream iss(buf);
+        std::istringstream iss(std::string(data, len));
         unsigned int fileResult = 0;
         iss >> fileResult;
         result += fileResult;
-        delete [] buf;
-        return -1;
+
+        // With --max-memory the worker also tells how much memory the file needed
+        std::size_t memory = 0;
+        if (iss >> memory)
+            _scheduler.setMemory(worker.file, memory);
+        return true;
+    } else {
+        std::cerr << "#### You found a bug from cppcheck.\nThreadExecutor::handleMessage error, type was:" << type << std::endl;
+        std::exit(0);
     }
 
-    delete [] buf;
-    return 1;
+    return false;
 }
 
 unsigned int ThreadExecutor::check()
+{
+    startScheduling();
+
+    const unsigned int result = (_settings.executor == Settings::Thread) ? checkThreads() : checkProcesses();
+
+    finishScheduling();
+    return result;
+}
+
+void ThreadExecutor::startJobServer()
+{
+    _useJobServer = _settings.jobServer;
+    if (!_useJobServer)
+        return;
+
+    const char *makeflags = std::getenv("MAKEFLAGS");
+    if (!makeflags || !_jobServer.parse(makeflags) || !_jobServer.connect())
+        std::cerr << "cppcheck: No usable GNU make jobserver found in MAKEFLAGS, checking one file at a time." << std::endl;
+}
+
+bool ThreadExecutor::acquireJobSlot(std::size_t busy)
+{
+    // Every client of the jobserver has one job slot without a token
+    if (!_useJobServer || busy < 1 + _jobServer.tokens())
+        return true;
+    return _jobServer.tryAcquire();
+}
+
+void ThreadExecutor::releaseJobSlots(std::size_t busy)
+{
+    while (_jobServer.tokens() > 0 && _jobServer.tokens() >= busy)
+        _jobServer.release();
+}
+
+std::size_t ThreadExecutor::residentMemory(pid_t pid)
+{
+    std::ostringstream path;
+    path << "/proc/";
+    if (pid == 0)
+        path << "self";
+    else
+        path << pid;
+    path << "/statm";
+
+    // The second field is the resident set size in pages
+    std::ifstream fin(path.str().c_str());
+    std::size_t size = 0, resident = 0;
+    if (!(fin >> size >> resident))
+        return 0;
+    return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+}
+
+/** @brief Peak resident memory of this process in bytes, 0 if it is not known */
+static std::size_t peakMemory()
+{
+    std::ifstream fin("/proc/self/status");
+    std::string line;
+    while (std::getline(fin, line)) {
+        if (line.compare(0, 7, "VmHWM:\t") == 0) {
+            std::istringstream iss(line.substr(7));
+            std::size_t kb = 0;
+            iss >> kb;
+            return kb * 1024;
+        }
+    }
+    return 0;
+}
+
+/** @brief Start measuring the peak memory again, this needs Linux 4.0 */
+static void resetPeakMemory()
+{
+    std::ofstream fout("/proc/self/clear_refs");
+    fout << "5";
+}
+
+unsigned long long ThreadExecutor::workerMemory(const std::list<Worker> &workers) const
+{
+    unsigned long long used = 0;
+    for (std::list<Worker>::const_iterator w = workers.begin(); w != workers.end(); ++w) {
+        const std::size_t resident = residentMemory(w->pid);
+        if (w->file.empty())
+            used += resident;
+        else
+            used += std::max(resident, w->startMemory + w->fileMemory);
+    }
+    return used;
+}
+
+unsigned long long ThreadExecutor::threadMemory() const
+{
+    if (_settings.maxMemory == 0)
+        return 0;
+    return std::max(static_cast<unsigned long long>(residentMemory(0)), _baseMemory + _threadFileMemory);
+}
+
+/**
+ * Messages of a worker that are not sent to the master process yet. This is
+ * a fixed buffer instead of a std::string so that the crash handler can send
+ * it, pipeBufferSize only counts complete messages.
+ */
+static char pipeBuffer[65536];
+static volatile std::size_t pipeBufferSize = 0;
+static int pipeBufferFd = -1;
+
+/** Write all data to the pipe, returns false if that fails */
+static bool writeAll(int fd, const char *p, std::size_t left)
+{
+    while (left > 0) {
+        const ssize_t n = write(fd, p, left);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        left -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+/** Send the messages that were found before a worker crashed, then crash */
+static void crashHandler(int sig)
+{
+    writeAll(pipeBufferFd, pipeBuffer, pipeBufferSize);
+    pipeBufferSize = 0;
+    raise(sig);
+}
+
+static void installCrashHandler(int fd)
+{
+    pipeBufferFd = fd;
+    pipeBufferSize = 0;
+
+    // The handler is reset when it is called so raise() ends the worker
+    // with the original signal and the master reports the crash.
+    struct sigaction act;
+    std::memset(&act, 0, sizeof(act));
+    act.sa_handler = crashHandler;
+    act.sa_flags = SA_RESETHAND | SA_NODEFER;
+    sigemptyset(&act.sa_mask);
+    const int signals[] = { SIGSEGV, SIGABRT, SIGBUS, SIGFPE, SIGILL };
+    for (std::size_t i = 0; i < sizeof(signals) / sizeof(signals[0]); ++i)
+        sigaction(signals[i], &act, NULL);
+}
+
+bool ThreadExecutor::startWorker(std::list<Worker> &workers)
+{
+    int rpipes[2];
+    int wpipes[2];
+    if (pipe(rpipes) == -1 || pipe(wpipes) == -1) {
+        std::cerr << "pipe() failed: "<< std::strerror(errno) << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    int flags = 0;
+    if ((flags = fcntl(rpipes[0], F_GETFL, 0)) < 0) {
+        std::cerr << "fcntl(F_GETFL) failed: "<< std::strerror(errno) << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    if (fcntl(rpipes[0], F_SETFL, flags | O_NONBLOCK) < 0) {
+        std::cerr << "fcntl(F_SETFL) failed: "<< std::strerror(errno) << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        // Error
+        std::cerr << "Failed to create child process: "<< std::strerror(errno) << std::endl;
+        std::exit(EXIT_FAILURE);
+    } else if (pid == 0) {
+        // The pipes of the other workers are inherited, close them so
+        // the other workers see when the master closes their pipes.
+        for (std::list<Worker>::const_iterator w = workers.begin(); w != workers.end(); ++w) {
+            close(w->rpipe);
+            if (w->wpipe >= 0)
+                close(w->wpipe);
+        }
+        close(rpipes[0]);
+        close(wpipes[1]);
+        for (std::vector<int>::const_iterator it = _closeInWorkers.begin(); it != _closeInWorkers.end(); ++it)
+            close(*it);
+        _wpipe = rpipes[1];
+        installCrashHandler(_wpipe);
+
+        workerLoop(wpipes[0]);
+        std::exit(0);
+    }
+
+    close(rpipes[1]);
+    close(wpipes[0]);
+
+    // A new worker takes the place of the first job that has no worker
+    std::vector<bool> jobTaken(_busyTime.size(), false);
+    for (std::list<Worker>::const_iterator w = workers.begin(); w != workers.end(); ++w)
+        jobTaken[w->job] = true;
+
+    Worker worker;
+    worker.pid = pid;
+    worker.rpipe = rpipes[0];
+    worker.wpipe = wpipes[1];
+    worker.job = std::find(jobTaken.begin(), jobTaken.end(), false) - jobTaken.begin();
+    worker.fileStart = 0;
+    worker.startMemory = 0;
+    worker.fileMemory = 0;
+    workers.push_back(worker);
+    return true;
+}
+
+void ThreadExecutor::workerLoop(int cmdpipe)
+{
+    // The same CppCheck instance is used for all files that this worker checks
+    CppCheck fileChecker(*this, false);
+    fileChecker.settings() = _settings;
+
+    for (;;) {
+        // Wait until the master sends the name of the next file to check.
+        // The pipe is closed when there are no more files.
+        unsigned int len = 0;
+        if (!readFromPipe(cmdpipe, &len, sizeof(len)))
+            break;
+        std::string filename(len, '\0');
+        if (len > 0 && !readFromPipe(cmdpipe, &filename[0], len))
+            break;
+
+        std::size_t startMemory = 0;
+        if (_settings.maxMemory > 0) {
+            resetPeakMemory();
+            startMemory = residentMemory(0);
+        }
+
+        unsigned int resultOfCheck = 0;
+        std::map<std::string, std::string>::const_iterator fileContent = _fileContents.find(filename);
+        if (fileContent != _fileContents.end()) {
+            // File content was given as a string
+            resultOfCheck = fileChecker.check(filename, fileContent->second);
+        } else {
+            // Read file from a file
+            resultOfCheck = fileChecker.check(filename);
+        }
+        Token::resetSymbols();
+
+        std::ostringstream oss;
+        oss << resultOfCheck;
+        if (_settings.maxMemory > 0) {
+            const std::size_t peak = peakMemory();
+            oss << ' ' << (peak > startMemory ? peak - startMemory : 0);
+        }
+        writeToPipe(CHILD_END, oss.str());
+    }
+
+    if (_settings.isEnabled("unusedFunction"))
+        writeToPipe(REPORT_FUNCTION_USAGE, fileChecker.serializeFunctionUsage());
+
+    if (!_settings.cacheDir.empty()) {
+        std::ostringstream oss;
+        oss << fileChecker.cacheHits() << ' ' << fileChecker.cacheMisses();
+        writeToPipe(REPORT_CACHE_STATS, oss.str());
+    }
+
+    close(cmdpipe);
+}
+
+bool ThreadExecutor::sendFile(Worker &worker, const std::string &filename)
+{
+    const unsigned int len = static_cast<unsigned int>(filename.size());
+    std::string data(reinterpret_cast<const char *>(&len), sizeof(len));
+    data += filename;
+
+    const char *p = data.c_str();
+    std::size_t left = data.size();
+    while (left > 0) {
+        const ssize_t n = write(worker.wpipe, p, left);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        left -= static_cast<std::size_t>(n);
+    }
+
+    worker.file = filename;
+    worker.fileStart = FileScheduler::now();
+    return true;
+}
+
+unsigned int ThreadExecutor::checkProcesses()
 {
     _fileCount = 0;
     unsigned int result = 0;
@@ -148,169 +561,335 @@ unsigned int ThreadExecutor::check()
         totalfilesize += i->second;
     }
 
-    std::list<int> rpipes;
-    std::map<pid_t, std::string> childFile;
-    std::map<int, std::string> pipeFile;
+    // A worker might die while the master is sending it a file name
+    void (*oldSigpipe)(int) = signal(SIGPIPE, SIG_IGN);
+
+    startJobServer();
+
+    std::list<Worker> workers;
     std::size_t processedsize = 0;
-    std::map<std::string, std::size_t>::const_iterator i = _files.begin();
+    std::vector<std::string>::const_iterator i = _order.begin();
     for (;;) {
-        // Start a new child
-        if (i != _files.end() && rpipes.size() < _settings._jobs) {
-            int pipes[2];
-            if (pipe(pipes) == -1) {
-                std::cerr << "pipe() failed: "<< std::strerror(errno) << std::endl;
-                std::exit(EXIT_FAILURE);
-            }
+        // Start the workers. A worker that crashed is replaced by a new one.
+        if (i != _order.end() && workers.size() < _settings._jobs) {
+            startWorker(workers);
+            continue;
+        }
 
-            int flags = 0;
-            if ((flags = fcntl(pipes[0], F_GETFL, 0)) < 0) {
-                std::cerr << "fcntl(F_GETFL) failed: "<< std::strerror(errno) << std::endl;
-                std::exit(EXIT_FAILURE);
+        std::size_t busy = 0;
+        for (std::list<Worker>::const_iterator w = workers.begin(); w != workers.end(); ++w) {
+            if (!w->file.empty())
+                ++busy;
+        }
+        releaseJobSlots(busy);
+        unsigned long long usedMemory = (_settings.maxMemory > 0) ? workerMemory(workers) : 0;
+
+        // Give the idle workers something to do, tell them to exit when
+        // all files have been handed out. A file waits while the jobs are
+        // near the memory budget or there is no free job slot.
+        bool waitForJobSlot = false;
+        for (std::list<Worker>::iterator w = workers.begin(); w != workers.end(); ++w) {
+            if (w->wpipe < 0 || !w->file.empty())
+                continue;
+            if (i != _order.end() && !fitsMemory(*i, usedMemory, busy))
+                break;
+            if (i != _order.end() && !acquireJobSlot(busy)) {
+                waitForJobSlot = true;
+                break;
+            }
+            if (i == _order.end() || !sendFile(*w, *i)) {
+                close(w->wpipe);
+                w->wpipe = -1;
+            } else {
+                if (_settings.maxMemory > 0) {
+                    w->startMemory = residentMemory(w->pid);
+                    w->fileMemory = _scheduler.memory(*i);
+                    usedMemory += w->fileMemory;
+                }
+                ++i;
+                ++busy;
             }
+        }
+
+        if (workers.empty())
+            break;
+
+        fd_set rfds;
+        FD_ZERO(&rfds);
+        int maxfd = 0;
+        for (std::list<Worker>::const_iterator w = workers.begin(); w != workers.end(); ++w) {
+            FD_SET(w->rpipe, &rfds);
+            maxfd = std::max(maxfd, w->rpipe);
+        }
+
+        // An idle worker waits for a token from the jobserver
+        if (waitForJobSlot && _jobServer.connected()) {
+            FD_SET(_jobServer.readFd(), &rfds);
+            maxfd = std::max(maxfd, _jobServer.readFd());
+        }
+
+        const int r = select(maxfd + 1, &rfds, NULL, NULL, NULL);
+        if (r <= 0)
+            continue;
 
-            if (fcntl(pipes[0], F_SETFL, flags | O_NONBLOCK) < 0) {
-                std::cerr << "fcntl(F_SETFL) failed: "<< std::strerror(errno) << std::endl;
-                std::exit(EXIT_FAILURE);
+        std::list<Worker>::iterator w = workers.begin();
+        while (w != workers.end()) {
+            if (!FD_ISSET(w->rpipe, &rfds)) {
+                ++w;
+                continue;
             }
 
-            pid_t pid = fork();
-            if (pid < 0) {
-                // Error
-                std::cerr << "Failed to create child process: "<< std::strerror(errno) << std::endl;
-                std::exit(EXIT_FAILURE);
-            } else if (pid == 0) {
-                close(pipes[0]);
-                _wpipe = pipes[1];
-
-                CppCheck fileChecker(*this, false);
-                fileChecker.settings() = _settings;
-                unsigned int resultOfCheck = 0;
-
-                if (!_fileContents.empty() && _fileContents.find(i->first) != _fileContents.end()) {
-                    // File content was given as a string
-                    resultOfCheck = fileChecker.check(i->first, _fileContents[ i->first ]);
-                } else {
-                    // Read file from a file
-                    resultOfCheck = fileChecker.check(i->first);
+            const int readRes = handleRead(*w, result);
+            if (readRes == 2 || readRes == -1) {
+                // The file is done, or the worker exited while checking it
+                if (!w->file.empty()) {
+                    const double elapsed = FileScheduler::now() - w->fileStart;
+                    _busyTime[w->job] += elapsed;
+                    if (readRes == 2)
+                        _scheduler.setTiming(w->file, elapsed);
+
+                    _fileCount++;
+                    processedsize += fileSize(w->file);
+                    if (!_settings._errorsOnly)
+                        CppCheckExecutor::reportStatus(_fileCount, _files.size(), processedsize, totalfilesize);
                 }
+            }
 
-                std::ostringstream oss;
-                oss << resultOfCheck;
-                writeToPipe(CHILD_END, oss.str());
-                std::exit(0);
+            if (readRes != -1) {
+                if (readRes == 2)
+                    w->file.clear();
+                ++w;
+                continue;
             }
 
-            close(pipes[1]);
-            rpipes.push_back(pipes[0]);
-            childFile[pid] = i->first;
-            pipeFile[pipes[0]] = i->first;
+            // The worker has closed its pipe => it has exited
+            close(w->rpipe);
+            if (w->wpipe >= 0)
+                close(w->wpipe);
 
-            ++i;
-        } else if (!rpipes.empty()) {
-            fd_set rfds;
-            FD_ZERO(&rfds);
-            for (std::list<int>::const_iterator rp = rpipes.begin(); rp != rpipes.end(); ++rp)
-                FD_SET(*rp, &rfds);
-
-            int r = select(*std::max_element(rpipes.begin(), rpipes.end()) + 1, &rfds, NULL, NULL, NULL);
-
-            if (r > 0) {
-                std::list<int>::iterator rp = rpipes.begin();
-                while (rp != rpipes.end()) {
-                    if (FD_ISSET(*rp, &rfds)) {
-                        int readRes = handleRead(*rp, result);
-                        if (readRes == -1) {
-                            std::size_t size = 0;
-                            std::map<int, std::string>::iterator p = pipeFile.find(*rp);
-                            if (p != pipeFile.end()) {
-                                std::string name = p->second;
-                                pipeFile.erase(p);
-                                std::map<std::string, std::size_t>::const_iterator fs = _files.find(name);
-                                if (fs != _files.end()) {
-                                    size = fs->second;
-                                }
-                            }
-
-                            _fileCount++;
-                            processedsize += size;
-                            if (!_settings._errorsOnly)
-                                CppCheckExecutor::reportStatus(_fileCount, _files.size(), processedsize, totalfilesize);
-
-                            close(*rp);
-                            rp = rpipes.erase(rp);
-                        } else
-                            ++rp;
-                    } else
-                        ++rp;
-                }
+            int stat = 0;
+            waitpid(w->pid, &stat, 0);
+            if (WIFSIGNALED(stat)) {
+                std::ostringstream oss;
+                oss << "Internal error: Child process crashed with signal " << WTERMSIG(stat);
+
+                std::list<ErrorLogger::ErrorMessage::FileLocation> locations;
+                locations.push_back(ErrorLogger::ErrorMessage::FileLocation(w->file, 0));
+                const ErrorLogger::ErrorMessage errmsg(locations,
+                                                       Severity::error,
+                                                       oss.str(),
+                                                       "cppcheckError",
+                                                       false);
+
+                if (!_settings.nomsg.isSuppressed(errmsg._id, w->file, 0))
+                    _errorLogger.reportErr(errmsg);
             }
 
-            int stat = 0;
-            pid_t child = waitpid(0, &stat, WNOHANG);
-            if (child > 0) {
-                std::string childname;
-                std::map<pid_t, std::string>::iterator c = childFile.find(child);
-                if (c != childFile.end()) {
-                    childname = c->second;
-                    childFile.erase(c);
-                }
+            w = workers.erase(w);
+        }
+    }
 
-                if (WIFSIGNALED(stat)) {
-                    std::ostringstream oss;
-                    oss << "Internal error: Child process crashed with signal " << WTERMSIG(stat);
+    _jobServer.releaseAll();
+    signal(SIGPIPE, oldSigpipe);
 
-                    std::list<ErrorLogger::ErrorMessage::FileLocation> locations;
-                    locations.push_back(ErrorLogger::ErrorMessage::FileLocation(childname, 0));
-                    const ErrorLogger::ErrorMessage errmsg(locations,
-                                                           Severity::error,
-                                                           oss.str(),
-                                                           "cppcheckError",
-                                                           false);
+    return result;
+}
 
-                    if (!_settings.nomsg.isSuppressed(errmsg._id, childname, 0))
-                        _errorLogger.reportErr(errmsg);
-                }
+unsigned int ThreadExecutor::checkThreads()
+{
+    _fileCount = 0;
+    _threadResult = 0;
+    _processedSize = 0;
+    _totalFileSize = 0;
+    for (std::map<std::string, std::size_t>::const_iterator i = _files.begin(); i != _files.end(); ++i) {
+        _totalFileSize += i->second;
+    }
+
+    _itNextFile = _order.begin();
+    _threadCount = 0;
+    _busyThreads = 0;
+    _baseMemory = residentMemory(0);
+    _threadFileMemory = 0;
+
+    startJobServer();
+    ThreadPool::run(_settings._jobs, threadProc, this);
+    _jobServer.releaseAll();
+
+    return _threadResult;
+}
+
+void ThreadExecutor::threadProc(void *data)
+{
+    ThreadExecutor *threadExecutor = static_cast<ThreadExecutor *>(data);
+
+    // The same CppCheck instance is used for all files checked by this thread
+    CppCheck fileChecker(*threadExecutor, false);
+    fileChecker.settings() = threadExecutor->_settings;
+
+    std::size_t job;
+    {
+        MutexLocker lock(threadExecutor->_fileSync);
+        job = threadExecutor->_threadCount++;
+    }
+
+    unsigned int result = 0;
+    for (;;) {
+        std::string file;
+        {
+            MutexLocker lock(threadExecutor->_fileSync);
+            if (threadExecutor->_itNextFile == threadExecutor->_order.end())
+                break;
+            const std::string &next = *threadExecutor->_itNextFile;
+            if (threadExecutor->fitsMemory(next, threadExecutor->threadMemory(), threadExecutor->_busyThreads) &&
+                threadExecutor->acquireJobSlot(threadExecutor->_busyThreads)) {
+                file = next;
+                ++threadExecutor->_itNextFile;
+                threadExecutor->_busyThreads++;
+                threadExecutor->_threadFileMemory += threadExecutor->_scheduler.memory(file);
             }
+        }
+
+        // Wait for memory to be freed or for a token from the jobserver
+        if (file.empty()) {
+            threadExecutor->_jobServer.wait(100);
+            continue;
+        }
+
+        const double fileStart = FileScheduler::now();
+        std::map<std::string, std::string>::const_iterator fileContent = threadExecutor->_fileContents.find(file);
+        if (fileContent != threadExecutor->_fileContents.end()) {
+            // File content was given as a string
+            result += fileChecker.check(file, fileContent->second);
         } else {
-            // All done
-            break;
+            // Read file from a file
+            result += fileChecker.check(file);
+        }
+        const double elapsed = FileScheduler::now() - fileStart;
+
+        MutexLocker lock(threadExecutor->_fileSync);
+        threadExecutor->_busyThreads--;
+        threadExecutor->releaseJobSlots(threadExecutor->_busyThreads);
+
+        // The strings of the tokens are freed when no thread is checking a
+        // file, a thread needs the lock to start the next one
+        if (threadExecutor->_busyThreads == 0)
+            Token::resetSymbols();
+        threadExecutor->_threadFileMemory -= threadExecutor->_scheduler.memory(file);
+        threadExecutor->_busyTime[job] += elapsed;
+        threadExecutor->_scheduler.setTiming(file, elapsed);
+        threadExecutor->_processedSize += threadExecutor->fileSize(file);
+        threadExecutor->_fileCount++;
+        if (!threadExecutor->_settings._errorsOnly) {
+            MutexLocker reportLock(threadExecutor->_reportSync);
+            CppCheckExecutor::reportStatus(threadExecutor->_fileCount, threadExecutor->_files.size(), threadExecutor->_processedSize, threadExecutor->_totalFileSize);
         }
     }
 
+    // The timing results are shown once by the CppCheck instance of the main thread
+    fileChecker.settings()._showtime = SHOWTIME_NONE;
 
-    return result;
+    MutexLocker lock(threadExecutor->_fileSync);
+    threadExecutor->_threadResult += result;
+    threadExecutor->_cacheHits += fileChecker.cacheHits();
+    threadExecutor->_cacheMisses += fileChecker.cacheMisses();
+    if (threadExecutor->_settings.isEnabled("unusedFunction"))
+        threadExecutor->_functionUsage.push_back(fileChecker.serializeFunctionUsage());
+}
+
+void ThreadExecutor::report(const ErrorLogger::ErrorMessage &msg, PipeSignal msgType)
+{
+    std::string file;
+    unsigned int line(0);
+    if (!msg._callStack.empty()) {
+        file = msg._callStack.back().getfile(false);
+        line = msg._callStack.back().line;
+    }
+
+    // Alert only about unique errors
+    const unsigned long long fingerprint = msg.fingerprint(_settings._verbose);
+    {
+        MutexLocker lock(_errorSync);
+        if (_settings.nomsg.isSuppressed(msg._id, file, line))
+            return;
+
+        if (!_errorFingerprints.insert(fingerprint).second)
+            return;
+    }
+
+    MutexLocker lock(_reportSync);
+    if (msgType == REPORT_ERROR)
+        _errorLogger.reportErr(msg);
+    else
+        _errorLogger.reportInfo(msg);
 }
 
 void ThreadExecutor::writeToPipe(PipeSignal type, const std::string &data)
 {
-    unsigned int len = static_cast<unsigned int>(data.length() + 1);
-    char *out = new char[ len + 1 + sizeof(len)];
-    out[0] = static_cast<char>(type);
-    std::memcpy(&(out[1]), &len, sizeof(len));
-    std::memcpy(&(out[1+sizeof(len)]), data.c_str(), len);
-    if (write(_wpipe, out, len + 1 + sizeof(len)) <= 0) {
-        delete [] out;
-        out = 0;
+    const unsigned int len = static_cast<unsigned int>(data.length());
+    std::string message;
+    message.reserve(1 + sizeof(len) + data.size());
+    message += static_cast<char>(type);
+    message.append(reinterpret_cast<const char *>(&len), sizeof(len));
+    message += data;
+
+    if (pipeBufferSize + message.size() > sizeof(pipeBuffer))
+        flushPipe();
+    if (message.size() > sizeof(pipeBuffer)) {
+        if (!writeAll(_wpipe, message.data(), message.size())) {
+            std::cerr << "#### ThreadExecutor::writeToPipe, Failed to write to pipe" << std::endl;
+            std::exit(0);
+        }
+        return;
+    }
+
+    // The size is updated after the copy so that a crash never sends a
+    // partial message
+    std::memcpy(pipeBuffer + pipeBufferSize, message.data(), message.size());
+    pipeBufferSize = pipeBufferSize + message.size();
+
+    // Error messages are sent in batches, everything else is sent at once
+    if (type != REPORT_ERROR && type != REPORT_INFO)
+        flushPipe();
+}
+
+void ThreadExecutor::flushPipe()
+{
+    if (!writeAll(_wpipe, pipeBuffer, pipeBufferSize)) {
         std::cerr << "#### ThreadExecutor::writeToPipe, Failed to write to pipe" << std::endl;
         std::exit(0);
     }
-
-    delete [] out;
+    pipeBufferSize = 0;
 }
 
 void ThreadExecutor::reportOut(const std::string &outmsg)
 {
-    writeToPipe(REPORT_OUT, outmsg);
+    if (_settings.executor == Settings::Thread) {
+        MutexLocker lock(_reportSync);
+        _errorLogger.reportOut(outmsg);
+    } else
+        writeToPipe(REPORT_OUT, outmsg);
 }
 
 void ThreadExecutor::reportErr(const ErrorLogger::ErrorMessage &msg)
 {
-    writeToPipe(REPORT_ERROR, msg.serialize());
+    if (_settings.executor == Settings::Thread)
+        report(msg, REPORT_ERROR);
+    else {
+        std::string data;
+        msg.serializeBinary(data);
+        writeToPipe(REPORT_ERROR, data);
+    }
 }
 
 void ThreadExecutor::reportInfo(const ErrorLogger::ErrorMessage &msg)
 {
-    writeToPipe(REPORT_INFO, msg.serialize());
+    if (_settings.executor == Settings::Thread)
+        report(msg, REPORT_INFO);
+    else {
+        std::string data;
+        msg.serializeBinary(data);
+        writeToPipe(REPORT_INFO, data);
+    }
 }
 
 #elif defined(THREADING_MODEL_WIN)
@@ -324,7 +903,10 @@ unsigned int ThreadExecutor::check()
 {
     HANDLE *threadHandles = new HANDLE[_settings._jobs];
 
-    _itNextFile = _files.begin();
+    startScheduling();
+    _itNextFile = _order.begin();
+    _threadCount = 0;
+    _busyThreads = 0;
 
     _processedFiles = 0;
     _processedSize = 0;
@@ -380,6 +962,8 @@ unsigned int ThreadExecutor::check()
 
     delete[] threadHandles;
 
+    finishScheduling();
+
     return result;
 }
 
@@ -388,13 +972,14 @@ unsigned int __stdcall ThreadExecutor::threadProc(void *args)
     unsigned int result = 0;
 
     ThreadExecutor *threadExecutor = static_cast<ThreadExecutor*>(args);
-    std::map<std::string, std::size_t>::const_iterator &it = threadExecutor->_itNextFile;
+    std::vector<std::string>::const_iterator &it = threadExecutor->_itNextFile;
 
     // guard static members of CppCheck against concurrent access
     EnterCriticalSection(&threadExecutor->_fileSync);
 
     CppCheck fileChecker(*threadExecutor, false);
     fileChecker.settings() = threadExecutor->_settings;
+    const std::size_t job = threadExecutor->_threadCount++;
 
     LeaveCriticalSection(&threadExecutor->_fileSync);
 
@@ -402,17 +987,24 @@ unsigned int __stdcall ThreadExecutor::threadProc(void *args)
 
         EnterCriticalSection(&threadExecutor->_fileSync);
 
-        if (it == threadExecutor->_files.end()) {
+        if (it == threadExecutor->_order.end()) {
+            threadExecutor->_cacheHits += fileChecker.cacheHits();
+            threadExecutor->_cacheMisses += fileChecker.cacheMisses();
+            if (threadExecutor->_settings.isEnabled("unusedFunction"))
+                threadExecutor->_functionUsage.push_back(fileChecker.serializeFunctionUsage());
             LeaveCriticalSection(&threadExecutor->_fileSync);
             return result;
 
         }
-        const std::string &file = it->first;
-        const std::size_t fileSize = it->second;
+        const std::string &file = *it;
+        const std::size_t size = threadExecutor->fileSize(file);
         ++it;
+        threadExecutor->_busyThreads++;
 
         LeaveCriticalSection(&threadExecutor->_fileSync);
 
+        const double fileStart = FileScheduler::now();
+
         std::map<std::string, std::string>::const_iterator fileContent = threadExecutor->_fileContents.find(file);
         if (fileContent != threadExecutor->_fileContents.end()) {
             // File content was given as a string
@@ -421,10 +1013,18 @@ unsigned int __stdcall ThreadExecutor::threadProc(void *args)
             // Read file from a file
             result += fileChecker.check(file);
         }
+        const double elapsed = FileScheduler::now() - fileStart;
 
         EnterCriticalSection(&threadExecutor->_fileSync);
 
-        threadExecutor->_processedSize += fileSize;
+        // The strings of the tokens are freed when no thread is checking a
+        // file, a thread needs the lock to start the next one
+        if (--threadExecutor->_busyThreads == 0)
+            Token::resetSymbols();
+
+        threadExecutor->_busyTime[job] += elapsed;
+        threadExecutor->_scheduler.setTiming(file, elapsed);
+        threadExecutor->_processedSize += size;
         threadExecutor->_processedFiles++;
         if (!threadExecutor->_settings._errorsOnly) {
             EnterCriticalSection(&threadExecutor->_reportSync);
@@ -469,14 +1069,10 @@ void ThreadExecutor::report(const ErrorLogger::ErrorMessage &msg, MessageType ms
         return;
 
     // Alert only about unique errors
-    bool reportError = false;
-    std::string errmsg = msg.toString(_settings._verbose);
+    const unsigned long long fingerprint = msg.fingerprint(_settings._verbose);
 
     EnterCriticalSection(&_errorSync);
-    if (std::find(_errorList.begin(), _errorList.end(), errmsg) == _errorList.end()) {
-        _errorList.push_back(errmsg);
-        reportError = true;
-    }
+    const bool reportError = _errorFingerprints.insert(fingerprint).second;
     LeaveCriticalSection(&_errorSync);
 
     if (reportError) {
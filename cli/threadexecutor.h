@@ -20,12 +20,18 @@
 #define THREADEXECUTOR_H
 
 #include <map>
+#include <set>
 #include <string>
 #include <list>
+#include <vector>
 #include "errorlogger.h"
+#include "filescheduler.h"
+#include "jobserver.h"
+#include "mutex.h"
 
 #if (defined(__GNUC__) || defined(__sun)) && !defined(__MINGW32__)
 #define THREADING_MODEL_FORK
+#include <sys/types.h>
 #elif defined(_WIN32)
 #define THREADING_MODEL_WIN
 #include <windows.h>
@@ -59,32 +65,217 @@ public:
      */
     void addFileContent(const std::string &path, const std::string &content);
 
+    /**
+     * @brief A descriptor of the caller that the forked workers close,
+     * for instance the listening socket of the server. Negative values
+     * are ignored.
+     */
+    void closeInWorkers(int fd) {
+        if (fd >= 0)
+            _closeInWorkers.push_back(fd);
+    }
+
+    /**
+     * @brief The function usage collected by each job, see
+     * CppCheck::serializeFunctionUsage(). Only filled if the
+     * unusedFunction check is enabled.
+     */
+    const std::list<std::string> &functionUsage() const {
+        return _functionUsage;
+    }
+
+    /** @brief Number of configurations whose results were read from the cache (--cache-dir) */
+    unsigned int cacheHits() const {
+        return _cacheHits;
+    }
+
+    /** @brief Number of configurations that were checked and stored in the cache (--cache-dir) */
+    unsigned int cacheMisses() const {
+        return _cacheMisses;
+    }
+
 private:
     const std::map<std::string, std::size_t> &_files;
     Settings &_settings;
     ErrorLogger &_errorLogger;
     unsigned int _fileCount;
 
+    /** @brief Function usage collected by each job */
+    std::list<std::string> _functionUsage;
+
+    /** @brief Cache statistics of all jobs */
+    unsigned int _cacheHits;
+    unsigned int _cacheMisses;
+
+    /** @brief Decides the order in which the files are checked */
+    FileScheduler _scheduler;
+
+    /** @brief The files in the order they are handed out to the jobs */
+    std::vector<std::string> _order;
+
+    /** @brief Seconds each job has spent checking files */
+    std::vector<double> _busyTime;
+
+    /** @brief Wall clock time when the checking was started */
+    double _startTime;
+
+    /** @brief Order the files and read the timings of the previous run (--timings-file) */
+    void startScheduling();
+
+    /** @brief Save the timings (--timings-file) and show how long each job was idle (--showtime) */
+    void finishScheduling();
+
+    /** @brief Get the size of a file that is checked */
+    std::size_t fileSize(const std::string &file) const;
+
+    /** @brief Descriptors that the forked workers close, see closeInWorkers() */
+    std::vector<int> _closeInWorkers;
+
+    /** @brief Files that were delayed by --max-memory, and their estimated memory */
+    std::map<std::string, std::size_t> _delayedFiles;
+
+    /**
+     * @brief Does the file fit in the memory budget (--max-memory)?
+     * Files that don't fit are recorded in _delayedFiles.
+     * @param file the file to start
+     * @param used the memory used by the jobs
+     * @param busy the number of files that are being checked
+     */
+    bool fitsMemory(const std::string &file, unsigned long long used, std::size_t busy);
+
 #if defined(THREADING_MODEL_FORK)
 
     /** @brief Key is file name, and value is the content of the file */
     std::map<std::string, std::string> _fileContents;
 private:
-    enum PipeSignal {REPORT_OUT='1',REPORT_ERROR='2', REPORT_INFO='3', CHILD_END='4'};
+    enum PipeSignal {REPORT_OUT='1',REPORT_ERROR='2', REPORT_INFO='3', CHILD_END='4', REPORT_FUNCTION_USAGE='5', REPORT_CACHE_STATS='6'};
+
+    /** @brief Check the files in forked child processes (--executor=process) */
+    unsigned int checkProcesses();
+
+    /** @brief Check the files in threads of this process (--executor=thread) */
+    unsigned int checkThreads();
+
+    /** @brief Checking thread used by checkThreads() */
+    static void threadProc(void *data);
+
+    /** @brief Report a message from a checking thread */
+    void report(const ErrorLogger::ErrorMessage &msg, PipeSignal msgType);
+
+    /** @brief The GNU make jobserver (--jobserver) */
+    JobServer _jobServer;
+
+    /** @brief Are the jobs limited by the jobserver? */
+    bool _useJobServer;
+
+    /** @brief Number of files being checked by checkThreads() */
+    std::size_t _busyThreads;
+
+    /** @brief Connect to the jobserver in MAKEFLAGS if --jobserver is given */
+    void startJobServer();
 
     /**
-     * Read from the pipe, parse and handle what ever is in there.
-     *@return -1 in case of error
+     * @brief May a file be started while @p busy files are being checked?
+     * Takes a token from the jobserver if that is needed.
+     */
+    bool acquireJobSlot(std::size_t busy);
+
+    /** @brief Give back the tokens that are not needed for @p busy files */
+    void releaseJobSlots(std::size_t busy);
+
+    /** @brief Next file to check in checkThreads() */
+    std::vector<std::string>::const_iterator _itNextFile;
+
+    /** @brief Number of checking threads started by checkThreads() */
+    unsigned int _threadCount;
+    std::size_t _processedSize;
+    std::size_t _totalFileSize;
+    unsigned int _threadResult;
+    Mutex _fileSync;
+    Mutex _errorSync;
+    Mutex _reportSync;
+
+    /** @brief A worker process. It checks the files that the master sends to it one at a time. */
+    struct Worker {
+        pid_t pid;
+
+        /** read end of the pipe that the worker reports to */
+        int rpipe;
+
+        /** write end of the pipe that file names are sent to, -1 when closed */
+        int wpipe;
+
+        /** file that the worker is checking, empty if it is idle */
+        std::string file;
+
+        /** index of the job in _busyTime */
+        std::size_t job;
+
+        /** when the worker was given the file */
+        double fileStart;
+
+        /** data read from the worker that is not a complete message yet */
+        std::string input;
+
+        /** memory used by the worker when it was given the file */
+        std::size_t startMemory;
+
+        /** estimated memory needed to check the file */
+        std::size_t fileMemory;
+    };
+
+    /** @brief Resident memory of a process in bytes, 0 if it is not known. 0 is this process. */
+    static std::size_t residentMemory(pid_t pid);
+
+    /** @brief Memory used by the workers, busy workers are expected to grow to their estimate */
+    unsigned long long workerMemory(const std::list<Worker> &workers) const;
+
+    /** @brief Resident memory of this process when checkThreads() started */
+    std::size_t _baseMemory;
+
+    /** @brief Estimated memory of the files that the threads are checking */
+    unsigned long long _threadFileMemory;
+
+    /** @brief Memory used by the checking threads, the files being checked are expected to grow to their estimate */
+    unsigned long long threadMemory() const;
+
+    /**
+     * Read from the pipe of the worker, parse and handle what ever is in there.
+     *@return -1 in case of error or if the pipe is closed
      *         0 if there is nothing in the pipe to be read
      *         1 if we did read something
+     *         2 if the worker finished checking a file
+     */
+    int handleRead(Worker &worker, unsigned int &result);
+
+    /**
+     * Handle one message read from a worker.
+     * @return true if the worker finished checking a file
      */
-    int handleRead(int rpipe, unsigned int &result);
+    bool handleMessage(Worker &worker, char type, const char *data, std::size_t len, unsigned int &result);
+
+    /** @brief Add a message to the messages that are sent to the master process */
     void writeToPipe(PipeSignal type, const std::string &data);
+
+    /** @brief Send the buffered messages to the master process */
+    void flushPipe();
+
+    /** @brief Fork a new worker process and add it to @p workers */
+    bool startWorker(std::list<Worker> &workers);
+
+    /** @brief Main loop of a worker process: check files until the master closes the pipe */
+    void workerLoop(int cmdpipe);
+
+    /** @brief Send a file name to an idle worker */
+    static bool sendFile(Worker &worker, const std::string &filename);
+
+    /** @brief Fingerprints of the reported messages, see ErrorMessage::fingerprint() */
+    std::set<unsigned long long> _errorFingerprints;
+
     /**
      * Write end of status pipe, different for each child.
      * Not used in master process.
      */
-    std::list<std::string> _errorList;
     int _wpipe;
 
 public:
@@ -101,14 +292,18 @@ private:
     enum MessageType {REPORT_ERROR, REPORT_INFO};
 
     std::map<std::string, std::string> _fileContents;
-    std::map<std::string, std::size_t>::const_iterator _itNextFile;
+    std::vector<std::string>::const_iterator _itNextFile;
+    unsigned int _threadCount;
+
+    /** @brief Number of threads that are checking a file */
+    unsigned int _busyThreads;
     std::size_t _processedFiles;
     std::size_t _totalFiles;
     std::size_t _processedSize;
     std::size_t _totalFileSize;
     CRITICAL_SECTION _fileSync;
 
-    std::list<std::string> _errorList;
+    std::set<unsigned long long> _errorFingerprints;
     CRITICAL_SECTION _errorSync;
 
     CRITICAL_SECTION _reportSync;
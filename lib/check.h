@@ -43,16 +43,22 @@ public:
 
     /** This constructor is used when running checks. */
     Check(const std::string &aname, const Tokenizer *tokenizer, const Settings *settings, ErrorLogger *errorLogger)
-        : _tokenizer(tokenizer), _settings(settings), _errorLogger(errorLogger), _name(aname)
+        : _tokenizer(tokenizer), _settings(settings), _errorLogger(errorLogger), _name(aname), _registered(false)
     { }
 
     virtual ~Check() {
 #if !defined(DJGPP) && !defined(__sun)
-        instances().remove(this);
+        // The checks that are created when running the checks never touch
+        // the registry, so several threads can run checks at the same time.
+        if (_registered)
+            instances().remove(this);
 #endif
     }
 
-    /** List of registered check classes. This is used by Cppcheck to run checks and generate documentation */
+    /**
+     * List of registered check classes. This is used by Cppcheck to run checks and generate documentation.
+     * The list is filled during static initialization and is read-only after that.
+     */
     static std::list<Check *> &instances() {
         static std::list<Check *> _instances;
         return _instances;
@@ -132,6 +138,9 @@ protected:
 private:
     const std::string _name;
 
+    /** Is this instance in the instances() list? */
+    const bool _registered;
+
     /** disabled assignment operator and copy constructor */
     void operator=(const Check &);
     Check(const Check &);
@@ -147,7 +156,7 @@ namespace std {
 }
 
 inline Check::Check(const std::string &aname)
-    : _tokenizer(0), _settings(0), _errorLogger(0), _name(aname)
+    : _tokenizer(0), _settings(0), _errorLogger(0), _name(aname), _registered(true)
 {
     instances().push_back(this);
     instances().sort(std::less<Check *>());
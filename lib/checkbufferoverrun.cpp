@@ -1942,7 +1942,7 @@ void CheckBufferOverrun::negativeIndexError(const Token *tok, MathLib::bigint in
 
 void CheckBufferOverrun::negativeIndex()
 {
-    const char pattern[] = "[ %num% ]";
+    static const char pattern[] = "[ %num% ]";
     for (const Token *tok = Token::findmatch(_tokenizer->tokens(), pattern); tok; tok = Token::findmatch(tok->next(),pattern)) {
         const MathLib::bigint index = MathLib::toLongNumber(tok->next()->str());
         if (index < 0) {
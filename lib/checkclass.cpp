@@ -912,7 +912,7 @@ void CheckClass::noMemset()
                     typeTok = arg3->tokAt(3);
                 else if (Token::simpleMatch(arg3, "sizeof ( * this ) )") || Token::simpleMatch(arg1, "this ,")) {
                     type = findFunctionOf(arg3->scope());
-                } else if (Token::Match(arg1, "&|*|%var%")) {
+                } else if (Token::Match(arg1, "%var%|&|*")) {
                     int derefs = 1;
                     for (;; arg1 = arg1->next()) {
                         if (arg1->str() == "&")
@@ -119,22 +119,12 @@ void CheckInternal::checkTokenSimpleMatchPatterns()
 
 void CheckInternal::checkMissingPercentCharacter()
 {
-    static std::set<std::string> magics;
-    if (magics.empty()) {
-        magics.insert("%any%");
-        magics.insert("%bool%");
-        magics.insert("%char%");
-        magics.insert("%comp%");
-        magics.insert("%num%");
-        magics.insert("%op%");
-        magics.insert("%cop%");
-        magics.insert("%or%");
-        magics.insert("%oror%");
-        magics.insert("%str%");
-        magics.insert("%type%");
-        magics.insert("%var%");
-        magics.insert("%varid%");
-    }
+    static const char * const magics_[] = {
+        "%any%", "%bool%", "%char%", "%comp%", "%num%", "%op%",
+        "%cop%", "%or%", "%oror%", "%str%", "%type%", "%var%",
+        "%varid%"
+    };
+    static const std::set<std::string> magics(magics_, magics_ + sizeof(magics_) / sizeof(*magics_));
 
     for (const Token *tok = _tokenizer->tokens(); tok; tok = tok->next()) {
         if (!Token::simpleMatch(tok, "Token :: Match (") && !Token::simpleMatch(tok, "Token :: findmatch ("))
@@ -175,22 +165,12 @@ void CheckInternal::checkMissingPercentCharacter()
 
 void CheckInternal::checkUnknownPattern()
 {
-    static std::set<std::string> knownPatterns;
-    if (knownPatterns.empty()) {
-        knownPatterns.insert("%any%");
-        knownPatterns.insert("%bool%");
-        knownPatterns.insert("%char%");
-        knownPatterns.insert("%comp%");
-        knownPatterns.insert("%num%");
-        knownPatterns.insert("%op%");
-        knownPatterns.insert("%cop%");
-        knownPatterns.insert("%or%");
-        knownPatterns.insert("%oror%");
-        knownPatterns.insert("%str%");
-        knownPatterns.insert("%type%");
-        knownPatterns.insert("%var%");
-        knownPatterns.insert("%varid%");
-    }
+    static const char * const knownPatterns_[] = {
+        "%any%", "%bool%", "%char%", "%comp%", "%num%", "%op%",
+        "%cop%", "%or%", "%oror%", "%str%", "%type%", "%var%",
+        "%varid%"
+    };
+    static const std::set<std::string> knownPatterns(knownPatterns_, knownPatterns_ + sizeof(knownPatterns_) / sizeof(*knownPatterns_));
 
     for (const Token *tok = _tokenizer->tokens(); tok; tok = tok->next()) {
         if (!Token::simpleMatch(tok, "Token :: Match (") && !Token::simpleMatch(tok, "Token :: findmatch ("))
@@ -408,12 +408,11 @@ static bool isComplexType(const Variable* var, const Token* varTypeTok)
     if (var->type())
         return(true);
 
-    static std::set<std::string> knownTypes;
-    if (knownTypes.empty()) {
-        knownTypes.insert("struct"); // If a type starts with the struct keyword, its a complex type
-        knownTypes.insert("string");
-        knownTypes.insert("wstring");
-    }
+    static const char * const knownTypes_[] = {
+        "struct", // If a type starts with the struct keyword, its a complex type
+        "string", "wstring"
+    };
+    static const std::set<std::string> knownTypes(knownTypes_, knownTypes_ + sizeof(knownTypes_) / sizeof(*knownTypes_));
 
     if (varTypeTok->str() == "std")
         varTypeTok = varTypeTok->tokAt(2);
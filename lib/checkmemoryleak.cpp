@@ -2553,13 +2553,10 @@ bool CheckMemoryLeakStructMember::isMalloc(const Variable *variable)
 void CheckMemoryLeakStructMember::checkStructVariable(const Variable * const variable)
 {
     // This should be in the CheckMemoryLeak base class
-    static std::set<std::string> ignoredFunctions;
-    if (ignoredFunctions.empty()) {
-        ignoredFunctions.insert("if");
-        ignoredFunctions.insert("for");
-        ignoredFunctions.insert("while");
-        ignoredFunctions.insert("malloc");
-    }
+    static const char * const ignoredFunctions_[] = {
+        "if", "for", "while", "malloc"
+    };
+    static const std::set<std::string> ignoredFunctions(ignoredFunctions_, ignoredFunctions_ + sizeof(ignoredFunctions_) / sizeof(*ignoredFunctions_));
 
     // Is struct variable a pointer?
     if (variable->isPointer()) {
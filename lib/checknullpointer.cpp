@@ -42,182 +42,56 @@ namespace {
 void CheckNullPointer::parseFunctionCall(const Token &tok, std::list<const Token *> &var, unsigned char value)
 {
     // standard functions that dereference first parameter..
-    static std::set<std::string> functionNames1_all;
-    static std::set<std::string> functionNames1_nullptr;
-    static std::set<std::string> functionNames1_uninit;
-    if (functionNames1_all.empty()) {
+    static const char * const functionNames1_all_[] = {
         // cstdlib
-        functionNames1_all.insert("atoi");
-        functionNames1_all.insert("atof");
-        functionNames1_all.insert("atol");
-        functionNames1_all.insert("qsort");
-        functionNames1_all.insert("strtof");
-        functionNames1_all.insert("strtod");
-        functionNames1_all.insert("strtol");
-        functionNames1_all.insert("strtoul");
-        functionNames1_all.insert("strtold");
-        functionNames1_all.insert("strtoll");
-        functionNames1_all.insert("strtoull");
-        functionNames1_all.insert("wcstof");
-        functionNames1_all.insert("wcstod");
-        functionNames1_all.insert("wcstol");
-        functionNames1_all.insert("wcstoul");
-        functionNames1_all.insert("wcstold");
-        functionNames1_all.insert("wcstoll");
-        functionNames1_all.insert("wcstoull");
+        "atoi", "atof", "atol", "qsort", "strtof", "strtod",
+        "strtol", "strtoul", "strtold", "strtoll", "strtoull", "wcstof",
+        "wcstod", "wcstol", "wcstoul", "wcstold", "wcstoll", "wcstoull",
         // cstring
-        functionNames1_all.insert("memchr");
-        functionNames1_all.insert("memcmp");
-        functionNames1_all.insert("strcat");
-        functionNames1_all.insert("strncat");
-        functionNames1_all.insert("strcoll");
-        functionNames1_all.insert("strchr");
-        functionNames1_all.insert("strrchr");
-        functionNames1_all.insert("strcmp");
-        functionNames1_all.insert("strncmp");
-        functionNames1_all.insert("strcspn");
-        functionNames1_all.insert("strdup");
-        functionNames1_all.insert("strndup");
-        functionNames1_all.insert("strpbrk");
-        functionNames1_all.insert("strlen");
-        functionNames1_all.insert("strspn");
-        functionNames1_all.insert("strstr");
-        functionNames1_all.insert("wcscat");
-        functionNames1_all.insert("wcsncat");
-        functionNames1_all.insert("wcscoll");
-        functionNames1_all.insert("wcschr");
-        functionNames1_all.insert("wcsrchr");
-        functionNames1_all.insert("wcscmp");
-        functionNames1_all.insert("wcsncmp");
-        functionNames1_all.insert("wcscspn");
-        functionNames1_all.insert("wcsdup");
-        functionNames1_all.insert("wcsndup");
-        functionNames1_all.insert("wcspbrk");
-        functionNames1_all.insert("wcslen");
-        functionNames1_all.insert("wcsspn");
-        functionNames1_all.insert("wcsstr");
+        "memchr", "memcmp", "strcat", "strncat", "strcoll", "strchr",
+        "strrchr", "strcmp", "strncmp", "strcspn", "strdup", "strndup",
+        "strpbrk", "strlen", "strspn", "strstr", "wcscat", "wcsncat",
+        "wcscoll", "wcschr", "wcsrchr", "wcscmp", "wcsncmp", "wcscspn",
+        "wcsdup", "wcsndup", "wcspbrk", "wcslen", "wcsspn", "wcsstr",
         // cstdio
-        functionNames1_all.insert("fclose");
-        functionNames1_all.insert("feof");
-        functionNames1_all.insert("fwrite");
-        functionNames1_all.insert("fseek");
-        functionNames1_all.insert("ftell");
-        functionNames1_all.insert("fputs");
-        functionNames1_all.insert("fputws");
-        functionNames1_all.insert("ferror");
-        functionNames1_all.insert("fgetc");
-        functionNames1_all.insert("fgetwc");
-        functionNames1_all.insert("fgetpos");
-        functionNames1_all.insert("fsetpos");
-        functionNames1_all.insert("freopen");
-        functionNames1_all.insert("fscanf");
-        functionNames1_all.insert("fprintf");
-        functionNames1_all.insert("fwscanf");
-        functionNames1_all.insert("fwprintf");
-        functionNames1_all.insert("fopen");
-        functionNames1_all.insert("rewind");
-        functionNames1_all.insert("printf");
-        functionNames1_all.insert("wprintf");
-        functionNames1_all.insert("scanf");
-        functionNames1_all.insert("wscanf");
-        functionNames1_all.insert("fscanf");
-        functionNames1_all.insert("sscanf");
-        functionNames1_all.insert("fwscanf");
-        functionNames1_all.insert("swscanf");
-        functionNames1_all.insert("setbuf");
-        functionNames1_all.insert("setvbuf");
-        functionNames1_all.insert("rename");
-        functionNames1_all.insert("remove");
-        functionNames1_all.insert("puts");
-        functionNames1_all.insert("getc");
-        functionNames1_all.insert("clearerr");
+        "fclose", "feof", "fwrite", "fseek", "ftell", "fputs",
+        "fputws", "ferror", "fgetc", "fgetwc", "fgetpos", "fsetpos",
+        "freopen", "fscanf", "fprintf", "fwscanf", "fwprintf", "fopen",
+        "rewind", "printf", "wprintf", "scanf", "wscanf", "fscanf",
+        "sscanf", "fwscanf", "swscanf", "setbuf", "setvbuf", "rename",
+        "remove", "puts", "getc", "clearerr",
         // ctime
-        functionNames1_all.insert("asctime");
-        functionNames1_all.insert("ctime");
-        functionNames1_all.insert("mktime");
-
-        functionNames1_nullptr.insert("itoa");
-        functionNames1_nullptr.insert("memcpy");
-        functionNames1_nullptr.insert("memmove");
-        functionNames1_nullptr.insert("memset");
-        functionNames1_nullptr.insert("strcpy");
-        functionNames1_nullptr.insert("sprintf");
-        functionNames1_nullptr.insert("vsprintf");
-        functionNames1_nullptr.insert("vprintf");
-        functionNames1_nullptr.insert("fprintf");
-        functionNames1_nullptr.insert("vfprintf");
-        functionNames1_nullptr.insert("wcscpy");
-        functionNames1_nullptr.insert("swprintf");
-        functionNames1_nullptr.insert("vswprintf");
-        functionNames1_nullptr.insert("vwprintf");
-        functionNames1_nullptr.insert("fwprintf");
-        functionNames1_nullptr.insert("vfwprintf");
-        functionNames1_nullptr.insert("fread");
-        functionNames1_nullptr.insert("gets");
-        functionNames1_nullptr.insert("gmtime");
-        functionNames1_nullptr.insert("localtime");
-        functionNames1_nullptr.insert("strftime");
-
-        functionNames1_uninit.insert("perror");
-        functionNames1_uninit.insert("fflush");
-    }
+        "asctime", "ctime", "mktime"
+    };
+    static const std::set<std::string> functionNames1_all(functionNames1_all_, functionNames1_all_ + sizeof(functionNames1_all_) / sizeof(*functionNames1_all_));
+    static const char * const functionNames1_nullptr_[] = {
+        "itoa", "memcpy", "memmove", "memset", "strcpy", "sprintf",
+        "vsprintf", "vprintf", "fprintf", "vfprintf", "wcscpy", "swprintf",
+        "vswprintf", "vwprintf", "fwprintf", "vfwprintf", "fread", "gets",
+        "gmtime", "localtime", "strftime"
+    };
+    static const std::set<std::string> functionNames1_nullptr(functionNames1_nullptr_, functionNames1_nullptr_ + sizeof(functionNames1_nullptr_) / sizeof(*functionNames1_nullptr_));
+    static const char * const functionNames1_uninit_[] = {
+        "perror", "fflush"
+    };
+    static const std::set<std::string> functionNames1_uninit(functionNames1_uninit_, functionNames1_uninit_ + sizeof(functionNames1_uninit_) / sizeof(*functionNames1_uninit_));
 
     // standard functions that dereference second parameter..
-    static std::set<std::string> functionNames2_all;
-    static std::set<std::string> functionNames2_nullptr;
-    if (functionNames2_all.empty()) {
-        functionNames2_all.insert("mbstowcs");
-        functionNames2_all.insert("wcstombs");
-        functionNames2_all.insert("memcmp");
-        functionNames2_all.insert("memcpy");
-        functionNames2_all.insert("memmove");
-        functionNames2_all.insert("strcat");
-        functionNames2_all.insert("strncat");
-        functionNames2_all.insert("strcmp");
-        functionNames2_all.insert("strncmp");
-        functionNames2_all.insert("strcoll");
-        functionNames2_all.insert("strcpy");
-        functionNames2_all.insert("strcspn");
-        functionNames2_all.insert("strncpy");
-        functionNames2_all.insert("strpbrk");
-        functionNames2_all.insert("strspn");
-        functionNames2_all.insert("strstr");
-        functionNames2_all.insert("strxfrm");
-        functionNames2_all.insert("wcscat");
-        functionNames2_all.insert("wcsncat");
-        functionNames2_all.insert("wcscmp");
-        functionNames2_all.insert("wcsncmp");
-        functionNames2_all.insert("wcscoll");
-        functionNames2_all.insert("wcscpy");
-        functionNames2_all.insert("wcscspn");
-        functionNames2_all.insert("wcsncpy");
-        functionNames2_all.insert("wcspbrk");
-        functionNames2_all.insert("wcsspn");
-        functionNames2_all.insert("wcsstr");
-        functionNames2_all.insert("wcsxfrm");
-        functionNames2_all.insert("sprintf");
-        functionNames2_all.insert("fprintf");
-        functionNames2_all.insert("fscanf");
-        functionNames2_all.insert("sscanf");
-        functionNames2_all.insert("swprintf");
-        functionNames2_all.insert("fwprintf");
-        functionNames2_all.insert("fwscanf");
-        functionNames2_all.insert("swscanf");
-        functionNames2_all.insert("fputs");
-        functionNames2_all.insert("fputc");
-        functionNames2_all.insert("ungetc");
-        functionNames2_all.insert("fputws");
-        functionNames2_all.insert("fputwc");
-        functionNames2_all.insert("ungetwc");
-        functionNames2_all.insert("rename");
-        functionNames2_all.insert("putc");
-        functionNames2_all.insert("putwc");
-        functionNames2_all.insert("freopen");
-
-        functionNames2_nullptr.insert("frexp");
-        functionNames2_nullptr.insert("modf");
-        functionNames2_nullptr.insert("fgetpos");
-    }
+    static const char * const functionNames2_all_[] = {
+        "mbstowcs", "wcstombs", "memcmp", "memcpy", "memmove", "strcat",
+        "strncat", "strcmp", "strncmp", "strcoll", "strcpy", "strcspn",
+        "strncpy", "strpbrk", "strspn", "strstr", "strxfrm", "wcscat",
+        "wcsncat", "wcscmp", "wcsncmp", "wcscoll", "wcscpy", "wcscspn",
+        "wcsncpy", "wcspbrk", "wcsspn", "wcsstr", "wcsxfrm", "sprintf",
+        "fprintf", "fscanf", "sscanf", "swprintf", "fwprintf", "fwscanf",
+        "swscanf", "fputs", "fputc", "ungetc", "fputws", "fputwc",
+        "ungetwc", "rename", "putc", "putwc", "freopen"
+    };
+    static const std::set<std::string> functionNames2_all(functionNames2_all_, functionNames2_all_ + sizeof(functionNames2_all_) / sizeof(*functionNames2_all_));
+    static const char * const functionNames2_nullptr_[] = {
+        "frexp", "modf", "fgetpos"
+    };
+    static const std::set<std::string> functionNames2_nullptr(functionNames2_nullptr_, functionNames2_nullptr_ + sizeof(functionNames2_nullptr_) / sizeof(*functionNames2_nullptr_));
 
     if (Token::Match(&tok, "%var% ( )") || !tok.tokAt(2))
         return;
@@ -1203,7 +1077,7 @@ void CheckNullPointer::removeAssignedVarFromSet(const Token* tok, std::set<unsig
     // If a pointer's address is passed into a function, stop considering it
     if (Token::Match(tok->previous(), "[;{}] %var% (")) {
         // Common functions that are known NOT to modify their pointer argument
-        const char safeFunctions[] = "printf|sprintf|fprintf|vprintf";
+        static const char safeFunctions[] = "printf|sprintf|fprintf|vprintf";
 
         const Token* endParen = tok->next()->link();
         for (const Token* tok2 = tok->next(); tok2 != endParen; tok2 = tok2->next()) {
@@ -22,10 +22,15 @@
 #include "tokenize.h"
 #include "token.h"
 #include <cctype>
+#include <sstream>
 //---------------------------------------------------------------------------
 
 
 
+// Register this check class (by creating a static instance of it)
+namespace {
+    CheckUnusedFunctions instance;
+}
 
 //---------------------------------------------------------------------------
 // FUNCTION USAGE - Check for unused functions etc
@@ -177,6 +182,50 @@ void CheckUnusedFunctions::check(ErrorLogger * const errorLogger)
     }
 }
 
+std::string CheckUnusedFunctions::serialize() const
+{
+    // One function per line: name, line number, usage flags and the file name.
+    // The file name is last because it may contain spaces.
+    std::ostringstream ostr;
+    for (std::map<std::string, FunctionUsage>::const_iterator it = _functions.begin(); it != _functions.end(); ++it) {
+        const FunctionUsage &func = it->second;
+        ostr << it->first << ' '
+             << func.lineNumber << ' '
+             << func.usedSameFile << ' '
+             << func.usedOtherFile << ' '
+             << func.filename << '\n';
+    }
+    return ostr.str();
+}
+
+void CheckUnusedFunctions::merge(const std::string &data)
+{
+    std::istringstream istr(data);
+    std::string line;
+    while (std::getline(istr, line)) {
+        std::istringstream iss(line);
+        std::string name;
+        FunctionUsage usage;
+        if (!(iss >> name >> usage.lineNumber >> usage.usedSameFile >> usage.usedOtherFile))
+            continue;
+        iss.get();
+        std::getline(iss, usage.filename);
+
+        FunctionUsage &func = _functions[name];
+
+        // Use the declaration in the first file, like when the files are
+        // parsed by one instance in alphabetical order
+        if (!usage.filename.empty() && (func.filename.empty() || usage.filename < func.filename)) {
+            func.filename = usage.filename;
+            func.lineNumber = usage.lineNumber;
+        }
+
+        // Only a function that is not used anywhere is reported
+        func.usedSameFile |= usage.usedSameFile;
+        func.usedOtherFile |= usage.usedOtherFile;
+    }
+}
+
 void CheckUnusedFunctions::unusedFunctionError(ErrorLogger * const errorLogger,
         const std::string &filename, unsigned int lineNumber,
         const std::string &funcname)
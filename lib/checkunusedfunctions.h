@@ -48,6 +48,18 @@ public:
 
     void check(ErrorLogger * const errorLogger);
 
+    /**
+     * @brief Serialize the function usage that has been parsed so far.
+     * Used to collect the results of several processes or threads.
+     */
+    std::string serialize() const;
+
+    /**
+     * @brief Add the function usage serialized by another instance.
+     * The order in which the results are merged does not matter.
+     */
+    void merge(const std::string &data);
+
 private:
 
     void getErrorMessages(ErrorLogger *errorLogger, const Settings *settings) const {
@@ -22,6 +22,8 @@
 
 #include "check.h"
 #include "path.h"
+#include "resultscache.h"
+#include "threadpool.h"
 
 #include <algorithm>
 #include <fstream>
@@ -39,8 +41,318 @@ static const char ExtraVersion[] = "";
 
 static TimerResults S_timerResults;
 
+#ifdef HAVE_RULES
+namespace {
+    /** @brief A --rule pattern, compiled and studied once for the process */
+    struct CompiledRule {
+        CompiledRule() : re(0), extra(0) {
+        }
+
+        pcre *re;
+        pcre_extra *extra;
+        std::string error;
+    };
+
+    /** @brief The rule patterns that have been compiled, shared by all threads */
+    class RuleCache {
+    public:
+        ~RuleCache() {
+            for (std::map<std::string, CompiledRule>::iterator it = _rules.begin(); it != _rules.end(); ++it) {
+#ifdef PCRE_STUDY_JIT_COMPILE
+                if (it->second.extra)
+                    pcre_free_study(it->second.extra);
+#else
+                if (it->second.extra)
+                    pcre_free(it->second.extra);
+#endif
+                if (it->second.re)
+                    pcre_free(it->second.re);
+            }
+        }
+
+        const CompiledRule &get(const std::string &pattern) {
+            MutexLocker lock(_sync);
+            const std::map<std::string, CompiledRule>::iterator it = _rules.find(pattern);
+            if (it != _rules.end())
+                return it->second;
+
+            CompiledRule &rule = _rules[pattern];
+            const char *error = 0;
+            int erroffset = 0;
+            rule.re = pcre_compile(pattern.c_str(), 0, &error, &erroffset, NULL);
+            if (!rule.re) {
+                if (error)
+                    rule.error = error;
+                return rule;
+            }
+
+            // The pattern is matched against many files, so it is worth to
+            // study it and let pcre compile it to machine code if it can.
+#ifdef PCRE_STUDY_JIT_COMPILE
+            rule.extra = pcre_study(rule.re, PCRE_STUDY_JIT_COMPILE, &error);
+#else
+            rule.extra = pcre_study(rule.re, 0, &error);
+#endif
+            return rule;
+        }
+
+    private:
+        std::map<std::string, CompiledRule> _rules;
+        Mutex _sync;
+    };
+
+    RuleCache ruleCache;
+}
+#endif
+
+namespace {
+    /**
+     * @brief Keeps the messages that are reported while checking one
+     * configuration, so they can be reported later in the same order as
+     * if the configurations were checked one after another.
+     */
+    class MessageBuffer : public ErrorLogger {
+    public:
+        virtual void reportOut(const std::string &outmsg) {
+            _messages.push_back(Message(REPORT_OUT, outmsg, ErrorLogger::ErrorMessage()));
+        }
+
+        virtual void reportErr(const ErrorLogger::ErrorMessage &msg) {
+            _messages.push_back(Message(REPORT_ERROR, "", msg));
+        }
+
+        virtual void reportInfo(const ErrorLogger::ErrorMessage &msg) {
+            _messages.push_back(Message(REPORT_INFO, "", msg));
+        }
+
+        /** @brief Report the buffered messages to @p errorLogger */
+        void replay(ErrorLogger &errorLogger) const {
+            for (std::list<Message>::const_iterator it = _messages.begin(); it != _messages.end(); ++it) {
+                if (it->type == REPORT_OUT)
+                    errorLogger.reportOut(it->outmsg);
+                else if (it->type == REPORT_ERROR)
+                    errorLogger.reportErr(it->msg);
+                else
+                    errorLogger.reportInfo(it->msg);
+            }
+        }
+
+    private:
+        enum MessageType { REPORT_OUT, REPORT_ERROR, REPORT_INFO };
+
+        struct Message {
+            Message(MessageType t, const std::string &o, const ErrorLogger::ErrorMessage &m)
+                : type(t), outmsg(o), msg(m) {
+            }
+            MessageType type;
+            std::string outmsg;
+            ErrorLogger::ErrorMessage msg;
+        };
+
+        std::list<Message> _messages;
+    };
+
+    /** @brief Result of checking one configuration in checkConfigurations() */
+    struct ConfigResult {
+        MessageBuffer messages;
+        MessageBuffer internalErrors;
+
+        /** @brief message of the std::runtime_error that stopped the checking, if any */
+        std::string bailout;
+        bool failed;
+
+        ConfigResult() : failed(false) {
+        }
+    };
+
+    /** @brief Data shared by the threads that run the checks of a file (--check-jobs) */
+    struct CheckJobs {
+        const Tokenizer *tokenizer;
+        const Settings *settings;
+        bool simplified;
+        std::vector<Check *> checks;
+        std::vector<MessageBuffer> messages;
+        std::vector<bool> failed;
+        std::vector<InternalError> errors;
+        std::size_t next;
+        Mutex sync;
+    };
+
+    void checkThreadProc(void *data)
+    {
+        CheckJobs *jobs = static_cast<CheckJobs *>(data);
+
+        for (;;) {
+            std::size_t i;
+            {
+                MutexLocker lock(jobs->sync);
+                if (jobs->next >= jobs->checks.size())
+                    break;
+                i = jobs->next++;
+            }
+
+            if (jobs->settings->terminated())
+                continue;
+
+            Check *check = jobs->checks[i];
+            try {
+                if (jobs->simplified) {
+                    Timer timerSimpleChecks(check->name() + "::runSimplifiedChecks", jobs->settings->_showtime, &S_timerResults);
+                    check->runSimplifiedChecks(jobs->tokenizer, jobs->settings, &jobs->messages[i]);
+                } else {
+                    Timer timerRunChecks(check->name() + "::runChecks", jobs->settings->_showtime, &S_timerResults);
+                    check->runChecks(jobs->tokenizer, jobs->settings, &jobs->messages[i]);
+                }
+            } catch (const InternalError &e) {
+                jobs->failed[i] = true;
+                jobs->errors[i] = e;
+            }
+        }
+    }
+
+    /**
+     * @brief Run the checks of all registered Check classes in threads
+     * (--check-jobs). The token list and the symbol database are only
+     * read by the checks. The messages are reported in the order of
+     * Check::instances(), like when the checks are run one after another.
+     */
+    void runChecksInThreads(const Tokenizer &tokenizer, const Settings &settings, ErrorLogger &errorLogger, bool simplified)
+    {
+        CheckJobs jobs;
+        jobs.tokenizer = &tokenizer;
+        jobs.settings = &settings;
+        jobs.simplified = simplified;
+        jobs.checks.assign(Check::instances().begin(), Check::instances().end());
+        jobs.messages.resize(jobs.checks.size());
+        jobs.failed.resize(jobs.checks.size(), false);
+        jobs.errors.resize(jobs.checks.size(), InternalError(0, ""));
+        jobs.next = 0;
+
+        const unsigned int threads = static_cast<unsigned int>(std::min<std::size_t>(settings.checkJobs, jobs.checks.size()));
+        ThreadPool::run(threads, checkThreadProc, &jobs);
+
+        for (std::size_t i = 0; i < jobs.checks.size(); ++i) {
+            jobs.messages[i].replay(errorLogger);
+
+            // The checks after a failing check are not run in a serial run
+            if (jobs.failed[i])
+                throw jobs.errors[i];
+        }
+    }
+
+    /** @brief Records of the results that are stored in the cache (--cache-dir, --incremental) */
+    enum ResultRecord {
+        RESULT_ERROR = 'E', RESULT_INFO = 'I', RESULT_OUT = 'O',
+        INTERNAL_ERROR = 'e', INTERNAL_INFO = 'i', INTERNAL_OUT = 'o',
+        FUNCTION_USAGE = 'U', DEPENDENCY = 'D',
+        INPUT_FILE = 'H', TOO_MANY_CONFIGS = 'T', TOKENS = 'K', MISSING_INCLUDE = 'M'
+    };
+
+    /** @brief Passes the messages on and records them for the cache */
+    class ResultsRecorder : public ErrorLogger {
+    public:
+        ResultsRecorder(ErrorLogger &errorLogger, std::string &results, bool internal)
+            : _errorLogger(errorLogger), _results(results), _internal(internal) {
+        }
+
+        virtual void reportOut(const std::string &outmsg) {
+            ResultsCache::addRecord(_results, _internal ? INTERNAL_OUT : RESULT_OUT, outmsg);
+            _errorLogger.reportOut(outmsg);
+        }
+
+        virtual void reportErr(const ErrorLogger::ErrorMessage &msg) {
+            record(_internal ? INTERNAL_ERROR : RESULT_ERROR, msg);
+            _errorLogger.reportErr(msg);
+        }
+
+        virtual void reportInfo(const ErrorLogger::ErrorMessage &msg) {
+            record(_internal ? INTERNAL_INFO : RESULT_INFO, msg);
+            _errorLogger.reportInfo(msg);
+        }
+
+        virtual void reportProgress(const std::string &filename, const char stage[], const std::size_t value) {
+            _errorLogger.reportProgress(filename, stage, value);
+        }
+
+    private:
+        void record(ResultRecord type, const ErrorLogger::ErrorMessage &msg) {
+            std::string data;
+            msg.serializeBinary(data);
+            ResultsCache::addRecord(_results, static_cast<char>(type), data);
+        }
+
+        ErrorLogger &_errorLogger;
+        std::string &_results;
+        bool _internal;
+    };
+
+    /**
+     * @brief Passes on the messages, except those about header code that
+     * has been checked before and was changed for --check-headers-once
+     */
+    class CheckedHeaderFilter : public ErrorLogger {
+    public:
+        CheckedHeaderFilter(ErrorLogger &errorLogger, const std::list<Tokenizer::HeaderLines> &lines)
+            : _errorLogger(errorLogger), _lines(lines) {
+            // The file names as they are in the messages
+            for (std::list<Tokenizer::HeaderLines>::iterator it = _lines.begin(); it != _lines.end(); ++it) {
+                ErrorLogger::ErrorMessage::FileLocation loc;
+                loc.setfile(it->file);
+                it->file = loc.getfile(false);
+            }
+        }
+
+        virtual void reportOut(const std::string &outmsg) {
+            _errorLogger.reportOut(outmsg);
+        }
+
+        virtual void reportErr(const ErrorLogger::ErrorMessage &msg) {
+            if (!isAboutCheckedHeaders(msg))
+                _errorLogger.reportErr(msg);
+        }
+
+        virtual void reportInfo(const ErrorLogger::ErrorMessage &msg) {
+            if (!isAboutCheckedHeaders(msg))
+                _errorLogger.reportInfo(msg);
+        }
+
+        virtual void reportProgress(const std::string &filename, const char stage[], const std::size_t value) {
+            _errorLogger.reportProgress(filename, stage, value);
+        }
+
+    private:
+        bool isAboutCheckedHeaders(const ErrorLogger::ErrorMessage &msg) const {
+            if (msg._callStack.empty())
+                return false;
+            for (std::list<ErrorLogger::ErrorMessage::FileLocation>::const_iterator loc = msg._callStack.begin(); loc != msg._callStack.end(); ++loc) {
+                bool found = false;
+                for (std::list<Tokenizer::HeaderLines>::const_iterator it = _lines.begin(); it != _lines.end() && !found; ++it)
+                    found = loc->line >= it->first && loc->line <= it->last && loc->getfile(false) == it->file;
+                if (!found)
+                    return false;
+            }
+            return true;
+        }
+
+        ErrorLogger &_errorLogger;
+        std::list<Tokenizer::HeaderLines> _lines;
+    };
+
+    /** @brief Data shared by the threads that check the configurations of a file */
+    struct ConfigJobs {
+        CppCheck *cppcheck;
+        const std::string *filedata;
+        const std::vector<std::string> *configurations;
+        const std::string *filename;
+        std::vector<ConfigResult> results;
+        std::size_t next;
+        Mutex sync;
+    };
+}
+
 CppCheck::CppCheck(ErrorLogger &errorLogger, bool useGlobalSuppressions)
-    : _errorLogger(errorLogger), exitcode(0), _useGlobalSuppressions(useGlobalSuppressions), tooManyConfigs(false)
+    : _checkUnusedFunctions(0, 0, 0), _errorLogger(&errorLogger), exitcode(0), _useGlobalSuppressions(useGlobalSuppressions), tooManyConfigs(false),
+      _cacheHits(0), _cacheMisses(0), _incrementalResults(0), _incrementalMissingInclude(false), _incrementalComplete(true)
 {
 }
 
@@ -62,7 +374,16 @@ const char * CppCheck::extraVersion()
 
 unsigned int CppCheck::check(const std::string &path)
 {
-    return processFile(path);
+    // A file of a compilation database is checked with its own flags
+    const std::map<std::string, Settings::FileSettings>::const_iterator fs = _settings.fileSettings.find(path);
+    if (fs == _settings.fileSettings.end())
+        return processFile(path);
+
+    _settings.userDefines = fs->second.defines;
+    _settings.userUndefs = fs->second.undefs;
+    _settings._includePaths = fs->second.includePaths;
+    _settings.userIncludes = fs->second.userIncludes;
+    return processFile(fs->second.filename);
 }
 
 unsigned int CppCheck::check(const std::string &path, const std::string &content)
@@ -104,6 +425,7 @@ bool CppCheck::findError(std::string code, const char FileName[])
             // is still there.
             code = previousCode.substr(found+9);
             _errorList.clear();
+            _errorFingerprints.clear();
             checkFile(code, FileName);
         }
 
@@ -122,7 +444,7 @@ bool CppCheck::findError(std::string code, const char FileName[])
 
         // We have reduced the code as much as we can. Print out
         // the code and quit.
-        _errorLogger.reportOut(code);
+        _errorLogger->reportOut(code);
         break;
     }
 
@@ -143,11 +465,140 @@ unsigned int CppCheck::processFile(const std::string& filename)
     if (_settings._errorsOnly == false) {
         std::string fixedpath = Path::simplifyPath(filename.c_str());
         fixedpath = Path::toNativeSeparators(fixedpath);
-        _errorLogger.reportOut(std::string("Checking ") + fixedpath + std::string("..."));
+        _errorLogger->reportOut(std::string("Checking ") + fixedpath + std::string("..."));
+    }
+
+    if (_settings.incrementalDir.empty() || !_fileContent.empty() || _settings.checkConfiguration || _settings.debugFalsePositive)
+        preprocessAndCheck(filename);
+    else
+        checkIncremental(filename);
+
+    _errorList.clear();
+    _errorFingerprints.clear();
+    return _settings.checkConfiguration ? 0 : exitcode;
+}
+
+void CppCheck::checkIncremental(const std::string &filename)
+{
+    // Report the stored results if neither the file nor its headers have changed
+    const ResultsCache cache(_settings.incrementalDir);
+    std::ostringstream options;
+    for (std::list<std::string>::const_iterator it = _settings._includePaths.begin(); it != _settings._includePaths.end(); ++it)
+        options << *it << '\n';
+    for (std::list<std::string>::const_iterator it = _settings.userIncludes.begin(); it != _settings.userIncludes.end(); ++it)
+        options << *it << '\n';
+    for (std::set<std::string>::const_iterator it = _settings.userUndefs.begin(); it != _settings.userUndefs.end(); ++it)
+        options << *it << '\n';
+    options << _settings.userDefines << '\n'
+            << _settings._force << _settings._errorsOnly << _settings._inlineSuppressions << ' ' << _settings._maxConfigs << '\n'
+            << _settings.append();
+    const unsigned long long key = ResultsCache::key(options.str(), filename, "", _settings);
+
+    std::vector<std::pair<char, std::string> > records;
+    if (cache.load(key, records)) {
+        bool unchanged = true;
+        for (std::vector<std::pair<char, std::string> >::const_iterator it = records.begin(); unchanged && it != records.end(); ++it) {
+            if (it->first == INPUT_FILE) {
+                const std::string::size_type pos = it->second.find(' ');
+                unchanged = pos != std::string::npos && fileHash(it->second.substr(pos + 1)) == it->second.substr(0, pos);
+            }
+        }
+        if (unchanged) {
+            for (std::vector<std::pair<char, std::string> >::const_iterator it = records.begin(); it != records.end(); ++it) {
+                if (it->first == TOO_MANY_CONFIGS)
+                    tooManyConfigs = true;
+                else if (it->first == MISSING_INCLUDE)
+                    Preprocessor::missingIncludeFlag = true;
+            }
+            replayResults(records, *this, *this);
+            return;
+        }
+    }
+
+    // Check the file and record what is reported
+    const std::string hash = fileHash(filename);
+    std::string results;
+    ResultsRecorder recorder(*_errorLogger, results, false);
+    ErrorLogger * const errorLogger = _errorLogger;
+    const bool tooManyConfigsBefore = tooManyConfigs;
+    _errorLogger = &recorder;
+    _incrementalResults = &results;
+    _incrementalHeaders.clear();
+    _incrementalMissingFiles.clear();
+    _incrementalMissingInclude = false;
+    _incrementalComplete = true;
+    try {
+        preprocessAndCheck(filename);
+    } catch (...) {
+        _errorLogger = errorLogger;
+        _incrementalResults = 0;
+        throw;
+    }
+    _errorLogger = errorLogger;
+    _incrementalResults = 0;
+
+    // The results are incomplete if the checking was terminated
+    if (_settings.terminated() || hash.empty() || !_incrementalComplete)
+        return;
+
+    std::string data;
+    ResultsCache::addRecord(data, INPUT_FILE, hash + ' ' + filename);
+    for (std::set<std::string>::const_iterator it = _incrementalHeaders.begin(); it != _incrementalHeaders.end(); ++it)
+        ResultsCache::addRecord(data, INPUT_FILE, fileHash(*it) + ' ' + *it);
+    // A missing file has an empty hash, the file is checked again when it
+    // is created and an include is resolved to it
+    for (std::set<std::string>::const_iterator it = _incrementalMissingFiles.begin(); it != _incrementalMissingFiles.end(); ++it) {
+        if (_incrementalHeaders.find(*it) == _incrementalHeaders.end())
+            ResultsCache::addRecord(data, INPUT_FILE, fileHash(*it) + ' ' + *it);
+    }
+    if (tooManyConfigs && !tooManyConfigsBefore)
+        ResultsCache::addRecord(data, TOO_MANY_CONFIGS, "");
+    if (_incrementalMissingInclude)
+        ResultsCache::addRecord(data, MISSING_INCLUDE, "");
+    cache.save(key, data + results);
+}
+
+std::string CppCheck::fileHash(const std::string &filename)
+{
+    const std::map<std::string, std::string>::const_iterator it = _fileHashes.find(filename);
+    if (it != _fileHashes.end())
+        return it->second;
+
+    std::string hash;
+    std::ifstream fin(filename.c_str(), std::ios::in | std::ios::binary);
+    if (fin.is_open()) {
+        std::ostringstream content;
+        content << fin.rdbuf();
+        std::ostringstream ostr;
+        ostr << std::hex << ResultsCache::hash(content.str());
+        hash = ostr.str();
     }
+    _fileHashes[filename] = hash;
+    return hash;
+}
+
+void CppCheck::resultsIncomplete()
+{
+    MutexLocker lock(_checkFileSync);
+    _incrementalComplete = false;
+}
+
+void CppCheck::recordIncremental(char type, const std::string &data)
+{
+    if (_incrementalResults)
+        ResultsCache::addRecord(*_incrementalResults, type, data);
+}
 
+void CppCheck::preprocessAndCheck(const std::string &filename)
+{
     try {
         Preprocessor preprocessor(&_settings, this);
+        if (_settings._showtime != SHOWTIME_NONE)
+            preprocessor.setTimerResults(&S_timerResults);
+        if (_incrementalResults) {
+            preprocessor.setMissingFiles(&_incrementalMissingFiles);
+            preprocessor.setMissingInclude(&_incrementalMissingInclude);
+        }
         std::list<std::string> configurations;
         std::string filedata = "";
 
@@ -163,10 +614,23 @@ unsigned int CppCheck::processFile(const std::string& filename)
         }
 
         if (_settings.checkConfiguration) {
-            return 0;
+            return;
+        }
+
+        // The file is checked again for --incremental when one of the headers changes
+        if (_incrementalResults) {
+            std::string::size_type pos = 0;
+            while ((pos = filedata.find("#file \"", pos)) != std::string::npos) {
+                pos += 7;
+                const std::string::size_type end = filedata.find('"', pos);
+                if (end == std::string::npos)
+                    break;
+                _incrementalHeaders.insert(filedata.substr(pos, end - pos));
+            }
         }
 
-        if (!_settings.userDefines.empty()) {
+        // The configuration of the -D flags, or of the build (--project)
+        if (!_settings.userDefines.empty() || !_settings.fileSettings.empty()) {
             configurations.clear();
             configurations.push_back(_settings.userDefines);
         }
@@ -179,6 +643,17 @@ unsigned int CppCheck::processFile(const std::string& filename)
             }
         }
 
+        if (_settings.configJobs > 1 && !_settings.debugFalsePositive && configurations.size() > 1) {
+            // Check only a few configurations (default 12), after that bail out, unless --force
+            // was used.
+            std::vector<std::string> checkedConfigurations(configurations.begin(), configurations.end());
+            if (!_settings._force && checkedConfigurations.size() > _settings._maxConfigs)
+                checkedConfigurations.resize(_settings._maxConfigs);
+
+            checkConfigurations(filedata, checkedConfigurations, filename);
+            configurations.clear();
+        }
+
         unsigned int checkCount = 0;
         for (std::list<std::string>::const_iterator it = configurations.begin(); it != configurations.end(); ++it) {
             // Check only a few configurations (default 12), after that bail out, unless --force
@@ -192,7 +667,7 @@ unsigned int CppCheck::processFile(const std::string& filename)
             if (_settings._errorsOnly == false && it != configurations.begin()) {
                 std::string fixedpath = Path::simplifyPath(filename.c_str());
                 fixedpath = Path::toNativeSeparators(fixedpath);
-                _errorLogger.reportOut(std::string("Checking ") + fixedpath + ": " + cfg + std::string("..."));
+                _errorLogger->reportOut(std::string("Checking ") + fixedpath + ": " + cfg + std::string("..."));
             }
 
             Timer t("Preprocessor::getcode", _settings._showtime, &S_timerResults);
@@ -203,7 +678,7 @@ unsigned int CppCheck::processFile(const std::string& filename)
 
             if (_settings.debugFalsePositive) {
                 if (findError(codeWithoutCfg + appendCode, filename.c_str())) {
-                    return exitcode;
+                    return;
                 }
             } else {
                 checkFile(codeWithoutCfg + appendCode, filename.c_str());
@@ -212,27 +687,94 @@ unsigned int CppCheck::processFile(const std::string& filename)
     } catch (const std::runtime_error &e) {
         // Exception was thrown when checking this file..
         const std::string fixedpath = Path::toNativeSeparators(filename);
-        _errorLogger.reportOut("Bailing out from checking " + fixedpath + ": " + e.what());
+        _errorLogger->reportOut("Bailing out from checking " + fixedpath + ": " + e.what());
     }
 
     if (!_settings._errorsOnly)
         reportUnmatchedSuppressions(_settings.nomsg.getUnmatchedLocalSuppressions(filename));
+}
 
-    _errorList.clear();
-    return exitcode;
+
+
+void CppCheck::checkConfigurations(const std::string &filedata, const std::vector<std::string> &configurations, const std::string &filename)
+{
+    ConfigJobs jobs;
+    jobs.cppcheck = this;
+    jobs.filedata = &filedata;
+    jobs.configurations = &configurations;
+    jobs.filename = &filename;
+    jobs.results.resize(configurations.size());
+    jobs.next = 0;
+
+    const unsigned int threads = static_cast<unsigned int>(std::min<std::size_t>(_settings.configJobs, configurations.size()));
+    ThreadPool::run(threads, configThreadProc, &jobs);
+
+    // Report the results in the order of the configurations
+    for (std::size_t i = 0; i < configurations.size(); ++i) {
+        cfg = configurations[i];
+
+        // If only errors are printed, print filename after the check
+        if (_settings._errorsOnly == false && i > 0) {
+            std::string fixedpath = Path::simplifyPath(filename.c_str());
+            fixedpath = Path::toNativeSeparators(fixedpath);
+            _errorLogger->reportOut(std::string("Checking ") + fixedpath + ": " + cfg + std::string("..."));
+        }
+
+        const ConfigResult &result = jobs.results[i];
+        result.messages.replay(*this);
+        result.internalErrors.replay(*_errorLogger);
+        if (result.failed)
+            throw std::runtime_error(result.bailout);
+    }
 }
 
+void CppCheck::configThreadProc(void *data)
+{
+    ConfigJobs *jobs = static_cast<ConfigJobs *>(data);
+    CppCheck *cppcheck = jobs->cppcheck;
+
+    for (;;) {
+        std::size_t i;
+        {
+            MutexLocker lock(jobs->sync);
+            if (jobs->next >= jobs->configurations->size())
+                break;
+            i = jobs->next++;
+        }
+
+        const std::string &configuration = (*jobs->configurations)[i];
+        ConfigResult &result = jobs->results[i];
+        try {
+            Preprocessor preprocessor(&cppcheck->_settings, &result.messages);
+            preprocessor.setFile0(*jobs->filename);
 
+            Timer t("Preprocessor::getcode", cppcheck->_settings._showtime, &S_timerResults);
+            const std::string codeWithoutCfg = preprocessor.getcode(*jobs->filedata, configuration, *jobs->filename, cppcheck->_settings.userDefines.empty());
+            t.Stop();
+
+            cppcheck->checkFile(codeWithoutCfg + cppcheck->_settings.append(), jobs->filename->c_str(), configuration, result.messages, result.internalErrors);
+        } catch (const std::runtime_error &e) {
+            result.failed = true;
+            result.bailout = e.what();
+        }
+
+        // Don't check the remaining configurations if this one could not be checked
+        if (result.failed) {
+            MutexLocker lock(jobs->sync);
+            jobs->next = jobs->configurations->size();
+        }
+    }
+}
 
 void CppCheck::checkFunctionUsage()
 {
     // This generates false positives - especially for libraries
-    if (_settings.isEnabled("unusedFunction") && _settings._jobs == 1) {
+    if (_settings.isEnabled("unusedFunction")) {
         const bool verbose_orig = _settings._verbose;
         _settings._verbose = false;
 
         if (_settings._errorsOnly == false)
-            _errorLogger.reportOut("Checking usage of global functions..");
+            _errorLogger->reportOut("Checking usage of global functions..");
 
         _checkUnusedFunctions.check(this);
 
@@ -240,6 +782,11 @@ void CppCheck::checkFunctionUsage()
     }
 }
 
+void CppCheck::mergeFunctionUsage(const std::string &data)
+{
+    _checkUnusedFunctions.merge(data);
+}
+
 void CppCheck::analyseFile(std::istream &fin, const std::string &filename)
 {
     // Preprocess file..
@@ -255,8 +802,7 @@ void CppCheck::analyseFile(std::istream &fin, const std::string &filename)
 
     // Tokenize..
     Tokenizer tokenizer(&_settings, this);
-    std::istringstream istr(code);
-    tokenizer.tokenize(istr, filename.c_str(), "");
+    tokenizer.tokenize(code.data(), code.size(), filename.c_str(), "");
     tokenizer.simplifyTokenList();
 
     // Analyse the tokens..
@@ -278,88 +824,248 @@ void CppCheck::analyseFile(std::istream &fin, const std::string &filename)
 //---------------------------------------------------------------------------
 
 void CppCheck::checkFile(const std::string &code, const char FileName[])
+{
+    checkFile(code, FileName, cfg, *this, *_errorLogger);
+}
+
+void CppCheck::checkFile(const std::string &code, const char FileName[], const std::string &configuration, ErrorLogger &errorLogger, ErrorLogger &internalErrorLogger)
 {
     if (_settings.terminated() || _settings.checkConfiguration)
         return;
 
-    Tokenizer _tokenizer(&_settings, this);
+    if (_settings.cacheDir.empty()) {
+        if (!tokenizeAndCheck(code, FileName, configuration, errorLogger, internalErrorLogger, 0))
+            resultsIncomplete();
+        return;
+    }
+
+    // Use the results of a previous run if the code and settings are the same
+    const ResultsCache cache(_settings.cacheDir);
+    const unsigned long long key = ResultsCache::key(code, FileName, configuration, _settings);
+    std::vector<std::pair<char, std::string> > records;
+    if (cache.load(key, records)) {
+        {
+            MutexLocker lock(_checkFileSync);
+            ++_cacheHits;
+        }
+        replayResults(records, errorLogger, internalErrorLogger);
+        return;
+    }
+
+    std::string results;
+    ResultsRecorder recorder(errorLogger, results, false);
+    ResultsRecorder internalRecorder(internalErrorLogger, results, true);
+    const bool complete = tokenizeAndCheck(code, FileName, configuration, recorder, internalRecorder, &results);
+    {
+        MutexLocker lock(_checkFileSync);
+        ++_cacheMisses;
+    }
+
+    // The results are incomplete if the checking was terminated, or if the
+    // code of headers that were checked for other files was left out
+    if (!complete)
+        resultsIncomplete();
+    else if (!_settings.terminated())
+        cache.save(key, results);
+}
+
+bool CppCheck::tokenizeCached(Tokenizer &tokenizer, const std::string &code, const char FileName[], const std::string &configuration, std::string &messages, ErrorLogger &errorLogger)
+{
+    const ResultsCache cache(_settings.cacheDir);
+    const unsigned long long key = ResultsCache::tokensKey(code, FileName, configuration, _settings);
+    std::vector<std::pair<char, std::string> > records;
+    if (cache.load(key, records)) {
+        // The last record is the snapshot of the tokens, unless tokenize() failed
+        const bool tokenized = !records.empty() && records.back().first == TOKENS;
+        if (!tokenized || tokenizer.loadSnapshot(records.back().second.data(), records.back().second.size(), configuration)) {
+            replayResults(records, errorLogger, errorLogger);
+            return tokenized;
+        }
+    }
+
+    std::string snapshot;
+    const bool result = tokenizer.tokenize(code.data(), code.size(), FileName, configuration, &snapshot);
+    if (!_settings.terminated()) {
+        if (result)
+            ResultsCache::addRecord(messages, TOKENS, snapshot);
+        cache.save(key, messages);
+    }
+    return result;
+}
+
+void CppCheck::replayResults(const std::vector<std::pair<char, std::string> > &records, ErrorLogger &errorLogger, ErrorLogger &internalErrorLogger)
+{
+    for (std::vector<std::pair<char, std::string> >::const_iterator it = records.begin(); it != records.end(); ++it) {
+        const std::string &data = it->second;
+        switch (it->first) {
+        case RESULT_ERROR:
+        case RESULT_INFO:
+        case INTERNAL_ERROR:
+        case INTERNAL_INFO: {
+            ErrorLogger::ErrorMessage msg;
+            if (!msg.deserializeBinary(data.data(), data.size()))
+                break;
+            ErrorLogger &logger = (it->first == RESULT_ERROR || it->first == RESULT_INFO) ? errorLogger : internalErrorLogger;
+            if (it->first == RESULT_ERROR || it->first == INTERNAL_ERROR)
+                logger.reportErr(msg);
+            else
+                logger.reportInfo(msg);
+            break;
+        }
+        case RESULT_OUT:
+            errorLogger.reportOut(data);
+            break;
+        case INTERNAL_OUT:
+            internalErrorLogger.reportOut(data);
+            break;
+        case FUNCTION_USAGE: {
+            MutexLocker lock(_checkFileSync);
+            _checkUnusedFunctions.merge(data);
+            recordIncremental(FUNCTION_USAGE, data);
+            break;
+        }
+        case DEPENDENCY: {
+            MutexLocker lock(_checkFileSync);
+            _dependencies.insert(data);
+            recordIncremental(DEPENDENCY, data);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+bool CppCheck::tokenizeAndCheck(const std::string &code, const char FileName[], const std::string &configuration, ErrorLogger &errorLogger, ErrorLogger &internalErrorLogger, std::string *results)
+{
+    // The messages of the tokenizer are stored with the tokens in the cache
+    std::string tokenizerMessages;
+    ResultsRecorder tokenizerRecorder(errorLogger, tokenizerMessages, false);
+    Tokenizer _tokenizer(&_settings, results ? &tokenizerRecorder : &errorLogger);
     if (_settings._showtime != SHOWTIME_NONE)
         _tokenizer.setTimerResults(&S_timerResults);
+    bool complete = true;
     try {
         bool result;
 
         // Tokenize the file
-        std::istringstream istr(code);
-
         Timer timer("Tokenizer::tokenize", _settings._showtime, &S_timerResults);
-        result = _tokenizer.tokenize(istr, FileName, cfg);
+        if (results) {
+            result = tokenizeCached(_tokenizer, code, FileName, configuration, tokenizerMessages, errorLogger);
+        } else {
+            result = _tokenizer.tokenize(code.data(), code.size(), FileName, configuration);
+        }
         timer.Stop();
         if (!result) {
             // File had syntax errors, abort
-            return;
+            return complete;
         }
 
         // Update the _dependencies..
-        if (_tokenizer.list.getFiles().size() >= 2)
+        if (_tokenizer.list.getFiles().size() >= 2) {
+            MutexLocker lock(_checkFileSync);
             _dependencies.insert(_tokenizer.list.getFiles().begin()+1, _tokenizer.list.getFiles().end());
+            for (std::vector<std::string>::const_iterator it = _tokenizer.list.getFiles().begin()+1; it != _tokenizer.list.getFiles().end(); ++it) {
+                if (results)
+                    ResultsCache::addRecord(*results, DEPENDENCY, *it);
+                recordIncremental(DEPENDENCY, *it);
+            }
+        }
+
+        // The messages about header code that has been checked before, and
+        // was changed, are not reported again
+        complete = _tokenizer.checkedHeaderLines().empty();
+        CheckedHeaderFilter headerFilter(errorLogger, _tokenizer.checkedHeaderLines());
+        ErrorLogger &checkLogger = _tokenizer.checkedHeaderLines().empty() ? errorLogger : headerFilter;
 
         // call all "runChecks" in all registered Check classes
-        for (std::list<Check *>::iterator it = Check::instances().begin(); it != Check::instances().end(); ++it) {
+        if (_settings.checkJobs > 1) {
+            runChecksInThreads(_tokenizer, _settings, checkLogger, false);
             if (_settings.terminated())
-                return;
+                return complete;
+        } else {
+            for (std::list<Check *>::iterator it = Check::instances().begin(); it != Check::instances().end(); ++it) {
+                if (_settings.terminated())
+                    return complete;
 
-            Timer timerRunChecks((*it)->name() + "::runChecks", _settings._showtime, &S_timerResults);
-            (*it)->runChecks(&_tokenizer, &_settings, this);
+                Timer timerRunChecks((*it)->name() + "::runChecks", _settings._showtime, &S_timerResults);
+                (*it)->runChecks(&_tokenizer, &_settings, &checkLogger);
+            }
         }
 
-        if (_settings.isEnabled("unusedFunction") && _settings._jobs == 1)
-            _checkUnusedFunctions.parseTokens(_tokenizer);
+        if (_settings.isEnabled("unusedFunction")) {
+            if (results || _incrementalResults) {
+                // The function usage of this configuration is stored in the cache
+                CheckUnusedFunctions usage(0, 0, 0);
+                usage.parseTokens(_tokenizer);
+                const std::string data = usage.serialize();
+                if (results)
+                    ResultsCache::addRecord(*results, FUNCTION_USAGE, data);
+                MutexLocker lock(_checkFileSync);
+                _checkUnusedFunctions.merge(data);
+                recordIncremental(FUNCTION_USAGE, data);
+            } else {
+                MutexLocker lock(_checkFileSync);
+                _checkUnusedFunctions.parseTokens(_tokenizer);
+            }
+        }
 
         Timer timer3("Tokenizer::simplifyTokenList", _settings._showtime, &S_timerResults);
         result = _tokenizer.simplifyTokenList();
         timer3.Stop();
         if (!result)
-            return;
+            return complete;
 
         // call all "runSimplifiedChecks" in all registered Check classes
-        for (std::list<Check *>::iterator it = Check::instances().begin(); it != Check::instances().end(); ++it) {
+        if (_settings.checkJobs > 1) {
+            runChecksInThreads(_tokenizer, _settings, checkLogger, true);
             if (_settings.terminated())
-                return;
+                return complete;
+        } else {
+            for (std::list<Check *>::iterator it = Check::instances().begin(); it != Check::instances().end(); ++it) {
+                if (_settings.terminated())
+                    return complete;
 
-            Timer timerSimpleChecks((*it)->name() + "::runSimplifiedChecks", _settings._showtime, &S_timerResults);
-            (*it)->runSimplifiedChecks(&_tokenizer, &_settings, this);
+                Timer timerSimpleChecks((*it)->name() + "::runSimplifiedChecks", _settings._showtime, &S_timerResults);
+                (*it)->runSimplifiedChecks(&_tokenizer, &_settings, &checkLogger);
+            }
         }
 
 #ifdef HAVE_RULES
         // Are there extra rules?
         if (!_settings.rules.empty()) {
-            std::ostringstream ostr;
-            for (const Token *tok = _tokenizer.tokens(); tok; tok = tok->next())
-                ostr << " " << tok->str();
-            const std::string str(ostr.str());
+            // The token text, and where each token starts in it
+            std::string str;
+            std::vector<std::string::size_type> offsets;
+            std::vector<const Token *> offsetTokens;
+            for (const Token *tok = _tokenizer.tokens(); tok; tok = tok->next()) {
+                offsets.push_back(str.size());
+                offsetTokens.push_back(tok);
+                str += ' ';
+                str += tok->str();
+            }
+
             for (std::list<Settings::Rule>::const_iterator it = _settings.rules.begin(); it != _settings.rules.end(); ++it) {
                 const Settings::Rule &rule = *it;
                 if (rule.pattern.empty() || rule.id.empty() || rule.severity.empty())
                     continue;
 
-                const char *error = 0;
-                int erroffset = 0;
-                pcre *re = pcre_compile(rule.pattern.c_str(),0,&error,&erroffset,NULL);
-                if (!re && error) {
+                const CompiledRule &compiled = ruleCache.get(rule.pattern);
+                if (!compiled.re && !compiled.error.empty()) {
                     ErrorLogger::ErrorMessage errmsg(std::list<ErrorLogger::ErrorMessage::FileLocation>(),
                                                      Severity::error,
-                                                     error,
+                                                     compiled.error,
                                                      "pcre_compile",
                                                      false);
 
-                    reportErr(errmsg);
+                    checkLogger.reportErr(errmsg);
                 }
-                if (!re)
+                if (!compiled.re)
                     continue;
 
                 int pos = 0;
                 int ovector[30];
-                while (0 <= pcre_exec(re, NULL, str.c_str(), (int)str.size(), pos, 0, ovector, 30)) {
+                while (0 <= pcre_exec(compiled.re, compiled.extra, str.c_str(), (int)str.size(), pos, 0, ovector, 30)) {
                     unsigned int pos1 = (unsigned int)ovector[0];
                     unsigned int pos2 = (unsigned int)ovector[1];
 
@@ -371,14 +1077,11 @@ void CppCheck::checkFile(const std::string &code, const char FileName[])
                     loc.setfile(_tokenizer.getSourceFilePath());
                     loc.line = 0;
 
-                    unsigned int len = 0;
-                    for (const Token *tok = _tokenizer.tokens(); tok; tok = tok->next()) {
-                        len = len + 1 + tok->str().size();
-                        if (len > pos1) {
-                            loc.setfile(_tokenizer.list.getFiles().at(tok->fileIndex()));
-                            loc.line = tok->linenr();
-                            break;
-                        }
+                    if (pos1 < str.size()) {
+                        const std::size_t index = std::upper_bound(offsets.begin(), offsets.end(), pos1) - offsets.begin() - 1;
+                        const Token *tok = offsetTokens[index];
+                        loc.setfile(_tokenizer.list.getFiles().at(tok->fileIndex()));
+                        loc.line = tok->linenr();
                     }
 
                     const std::list<ErrorLogger::ErrorMessage::FileLocation> callStack(1, loc);
@@ -392,10 +1095,8 @@ void CppCheck::checkFile(const std::string &code, const char FileName[])
                     const ErrorLogger::ErrorMessage errmsg(callStack, Severity::fromString(rule.severity), summary, rule.id, false);
 
                     // Report error
-                    reportErr(errmsg);
+                    checkLogger.reportErr(errmsg);
                 }
-
-                pcre_free(re);
             }
         }
 #endif
@@ -419,8 +1120,9 @@ void CppCheck::checkFile(const std::string &code, const char FileName[])
                                                "cppcheckError",
                                                false);
 
-        _errorLogger.reportErr(errmsg);
+        internalErrorLogger.reportErr(errmsg);
     }
+    return complete;
 }
 
 Settings &CppCheck::settings()
@@ -472,17 +1174,19 @@ void CppCheck::tooManyConfigsError(const std::string &file, const std::size_t nu
 
 void CppCheck::reportErr(const ErrorLogger::ErrorMessage &msg)
 {
-    std::string errmsg = msg.toString(_settings._verbose);
-    if (errmsg.empty())
+    // Nothing to report
+    if (msg._callStack.empty() && msg._severity == Severity::none &&
+        (_settings._verbose ? msg.verboseMessage() : msg.shortMessage()).empty())
         return;
 
-    // Alert only about unique errors
-    if (std::find(_errorList.begin(), _errorList.end(), errmsg) != _errorList.end())
+    // Alert only about unique errors. The fingerprint is used so that
+    // duplicates are rejected without formatting the message.
+    if (!_errorFingerprints.insert(msg.fingerprint(_settings._verbose)).second)
         return;
 
     if (_settings.debugFalsePositive) {
         // Don't print out error
-        _errorList.push_back(errmsg);
+        _errorList.push_back(msg.toString(_settings._verbose));
         return;
     }
 
@@ -504,19 +1208,17 @@ void CppCheck::reportErr(const ErrorLogger::ErrorMessage &msg)
     if (!_settings.nofail.isSuppressed(msg._id, file, line))
         exitcode = 1;
 
-    _errorList.push_back(errmsg);
-
-    _errorLogger.reportErr(msg);
+    _errorLogger->reportErr(msg);
 }
 
 void CppCheck::reportOut(const std::string &outmsg)
 {
-    _errorLogger.reportOut(outmsg);
+    _errorLogger->reportOut(outmsg);
 }
 
 void CppCheck::reportProgress(const std::string &filename, const char stage[], const std::size_t value)
 {
-    _errorLogger.reportProgress(filename, stage, value);
+    _errorLogger->reportProgress(filename, stage, value);
 }
 
 void CppCheck::reportInfo(const ErrorLogger::ErrorMessage &msg)
@@ -536,7 +1238,7 @@ void CppCheck::reportInfo(const ErrorLogger::ErrorMessage &msg)
             return;
     }
 
-    _errorLogger.reportInfo(msg);
+    _errorLogger->reportInfo(msg);
 }
 
 void CppCheck::reportStatus(unsigned int /*fileindex*/, unsigned int /*filecount*/, std::size_t /*sizedone*/, std::size_t /*sizetotal*/)
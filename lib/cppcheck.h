@@ -23,10 +23,14 @@
 #include "settings.h"
 #include "errorlogger.h"
 #include "checkunusedfunctions.h"
+#include "mutex.h"
 
 #include <string>
 #include <list>
+#include <map>
+#include <set>
 #include <istream>
+#include <vector>
 
 /// @addtogroup Core
 /// @{
@@ -37,6 +41,8 @@
  * errors or places that could be improved.
  * Usage: See check() for more info.
  */
+class Tokenizer;
+
 class CPPCHECKLIB CppCheck : ErrorLogger {
 public:
     /**
@@ -84,6 +90,20 @@ public:
      */
     void checkFunctionUsage();
 
+    /**
+     * @brief Get the function usage collected by check(). Used when the
+     * files are checked by several instances (-j).
+     */
+    std::string serializeFunctionUsage() const {
+        return _checkUnusedFunctions.serialize();
+    }
+
+    /**
+     * @brief Add the function usage collected by another instance, see
+     * serializeFunctionUsage(). Call checkFunctionUsage() afterwards.
+     */
+    void mergeFunctionUsage(const std::string &data);
+
     /**
      * @brief Get reference to current settings.
      * @return a reference to current settings
@@ -133,14 +153,83 @@ public:
 
     void tooManyConfigsError(const std::string &file, const std::size_t numberOfConfigurations);
 
+    /** @brief Number of configurations whose results were read from the cache (--cache-dir) */
+    unsigned int cacheHits() const {
+        return _cacheHits;
+    }
+
+    /** @brief Number of configurations that were checked and stored in the cache (--cache-dir) */
+    unsigned int cacheMisses() const {
+        return _cacheMisses;
+    }
+
 private:
 
     /** @brief Process one file. */
     unsigned int processFile(const std::string& filename);
 
+    /** @brief Preprocess the file and check its configurations */
+    void preprocessAndCheck(const std::string &filename);
+
+    /**
+     * @brief Check a file for --incremental. The stored results of the
+     * file are reported if the file and its headers have not changed,
+     * otherwise the file is checked and its results are stored.
+     */
+    void checkIncremental(const std::string &filename);
+
+    /** @brief Hash of the content of a file, empty if the file can't be read */
+    std::string fileHash(const std::string &filename);
+
+    /** @brief The results of the file can't be stored for --incremental */
+    void resultsIncomplete();
+
+    /** @brief Add a record to the stored results of the file for --incremental, call with _checkFileSync locked */
+    void recordIncremental(char type, const std::string &data);
+
     /** @brief Check file */
     void checkFile(const std::string &code, const char FileName[]);
 
+    /**
+     * @brief Check file with the given configuration
+     * @param code preprocessed code
+     * @param FileName name of the file
+     * @param configuration the preprocessor configuration of @p code
+     * @param errorLogger the errors found in the code are reported here
+     * @param internalErrorLogger internal errors are reported here
+     */
+    void checkFile(const std::string &code, const char FileName[], const std::string &configuration, ErrorLogger &errorLogger, ErrorLogger &internalErrorLogger);
+
+    /**
+     * @brief Tokenize and check the code, see checkFile()
+     * @param results if given, the results that are stored in the cache are added to it
+     * @return false if the code of headers that were checked before was
+     * left out (--check-headers-once), the results can't be stored then
+     */
+    bool tokenizeAndCheck(const std::string &code, const char FileName[], const std::string &configuration, ErrorLogger &errorLogger, ErrorLogger &internalErrorLogger, std::string *results);
+
+    /**
+     * @brief Tokenize the code or load the tokens of a previous run from
+     * the cache. The tokens are stored apart from the results, so they are
+     * reused when the code is checked with other checks enabled.
+     * @param messages the messages that tokenize() reports, they are stored with the tokens
+     * @param errorLogger the messages from the cache are reported here
+     */
+    bool tokenizeCached(Tokenizer &tokenizer, const std::string &code, const char FileName[], const std::string &configuration, std::string &messages, ErrorLogger &errorLogger);
+
+    /** @brief Report the results of a configuration that were read from the cache */
+    void replayResults(const std::vector<std::pair<char, std::string> > &records, ErrorLogger &errorLogger, ErrorLogger &internalErrorLogger);
+
+    /**
+     * @brief Check the configurations of a file in parallel (--config-jobs).
+     * The messages are reported in the same order as if the configurations
+     * were checked one after another.
+     */
+    void checkConfigurations(const std::string &filedata, const std::vector<std::string> &configurations, const std::string &filename);
+
+    /** @brief Thread function used by checkConfigurations() */
+    static void configThreadProc(void *data);
+
     /**
      * @brief Errors and warnings are directed here.
      *
@@ -170,7 +259,12 @@ private:
      */
     static void replaceAll(std::string& code, const std::string &from, const std::string &to);
 
+    /** @brief Formatted errors, only collected for --debug-fp */
     std::list<std::string> _errorList;
+
+    /** @brief Fingerprints of the errors reported so far */
+    std::set<unsigned long long> _errorFingerprints;
+
     Settings _settings;
     std::string _fileContent;
     std::set<std::string> _dependencies;
@@ -183,7 +277,12 @@ private:
     virtual void reportInfo(const ErrorLogger::ErrorMessage &msg);
 
     CheckUnusedFunctions _checkUnusedFunctions;
-    ErrorLogger &_errorLogger;
+
+    /** @brief Where the messages are reported, a recorder while the results of a file are recorded for --incremental */
+    ErrorLogger *_errorLogger;
+
+    /** @brief Protects _dependencies and _checkUnusedFunctions when configurations are checked in parallel */
+    Mutex _checkFileSync;
 
     /** @brief Current preprocessor configuration */
     std::string cfg;
@@ -194,6 +293,28 @@ private:
 
     /** Are there too many configs? */
     bool tooManyConfigs;
+
+    /** @brief Cache statistics, see cacheHits() and cacheMisses() */
+    unsigned int _cacheHits;
+    unsigned int _cacheMisses;
+
+    /** @brief Stored results of the file that is checked for --incremental, 0 if they are not recorded */
+    std::string *_incrementalResults;
+
+    /** @brief Headers of the file that is checked for --incremental */
+    std::set<std::string> _incrementalHeaders;
+
+    /** @brief Paths where a header of the file was looked for and not found (--incremental) */
+    std::set<std::string> _incrementalMissingFiles;
+
+    /** @brief Was an include of the file missing (--incremental)? */
+    bool _incrementalMissingInclude;
+
+    /** @brief Can the results of the file be stored for --incremental? */
+    bool _incrementalComplete;
+
+    /** @brief Hashes of the files that were read for --incremental */
+    std::map<std::string, std::string> _fileHashes;
 };
 
 /// @}
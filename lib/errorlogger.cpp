@@ -22,6 +22,7 @@
 #include "tokenlist.h"
 
 #include <cassert>
+#include <cstring>
 #include <sstream>
 #include <vector>
 
@@ -108,6 +109,116 @@ std::string ErrorLogger::ErrorMessage::serialize() const
     return oss.str();
 }
 
+/** @brief Append an integer to binary serialized data */
+static void writeBinary(std::string &data, unsigned int value)
+{
+    data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+/** @brief Append a string to binary serialized data */
+static void writeBinary(std::string &data, const std::string &str)
+{
+    writeBinary(data, static_cast<unsigned int>(str.size()));
+    data.append(str);
+}
+
+/** @brief Read an integer from binary serialized data */
+static bool readBinary(const char *&data, const char *end, unsigned int &value)
+{
+    if (static_cast<std::size_t>(end - data) < sizeof(value))
+        return false;
+    std::memcpy(&value, data, sizeof(value));
+    data += sizeof(value);
+    return true;
+}
+
+/** @brief Read a string from binary serialized data */
+static bool readBinary(const char *&data, const char *end, std::string &str)
+{
+    unsigned int len = 0;
+    if (!readBinary(data, end, len) || static_cast<std::size_t>(end - data) < len)
+        return false;
+    str.assign(data, len);
+    data += len;
+    return true;
+}
+
+void ErrorLogger::ErrorMessage::serializeBinary(std::string &data) const
+{
+    writeBinary(data, _id);
+    writeBinary(data, static_cast<unsigned int>(_severity));
+    writeBinary(data, _inconclusive ? 1U : 0U);
+    writeBinary(data, _shortMessage);
+    writeBinary(data, _verboseMessage);
+    writeBinary(data, static_cast<unsigned int>(_callStack.size()));
+    for (std::list<ErrorLogger::ErrorMessage::FileLocation>::const_iterator loc = _callStack.begin(); loc != _callStack.end(); ++loc) {
+        writeBinary(data, loc->line);
+        writeBinary(data, loc->getfile(false));
+    }
+}
+
+bool ErrorLogger::ErrorMessage::deserializeBinary(const char *data, std::size_t size)
+{
+    const char *end = data + size;
+    unsigned int severity = 0;
+    unsigned int inconclusive = 0;
+    unsigned int stackSize = 0;
+    if (!readBinary(data, end, _id) ||
+        !readBinary(data, end, severity) ||
+        !readBinary(data, end, inconclusive) ||
+        !readBinary(data, end, _shortMessage) ||
+        !readBinary(data, end, _verboseMessage) ||
+        !readBinary(data, end, stackSize))
+        return false;
+
+    _severity = static_cast<Severity::SeverityType>(severity);
+    _inconclusive = (inconclusive != 0);
+
+    _callStack.clear();
+    for (unsigned int i = 0; i < stackSize; ++i) {
+        ErrorLogger::ErrorMessage::FileLocation loc;
+        std::string file;
+        if (!readBinary(data, end, loc.line) || !readBinary(data, end, file))
+            return false;
+        loc.setfile(file);
+        _callStack.push_back(loc);
+    }
+
+    return data == end;
+}
+
+/** @brief FNV-1a hash of @p size bytes, continuing from @p hash */
+static unsigned long long fnv1a(unsigned long long hash, const char *data, std::size_t size)
+{
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/** @brief FNV-1a hash of a string, the length is included so that "ab"+"c" and "a"+"bc" differ */
+static unsigned long long fnv1a(unsigned long long hash, const std::string &str)
+{
+    const unsigned int len = static_cast<unsigned int>(str.size());
+    hash = fnv1a(hash, reinterpret_cast<const char *>(&len), sizeof(len));
+    return fnv1a(hash, str.data(), str.size());
+}
+
+unsigned long long ErrorLogger::ErrorMessage::fingerprint(bool verbose) const
+{
+    unsigned long long hash = 14695981039346656037ULL;
+    hash = fnv1a(hash, _id);
+    hash = fnv1a(hash, Severity::toString(_severity));
+    hash = fnv1a(hash, _inconclusive ? "1" : "0");
+    hash = fnv1a(hash, verbose ? _verboseMessage : _shortMessage);
+    for (std::list<ErrorLogger::ErrorMessage::FileLocation>::const_iterator loc = _callStack.begin(); loc != _callStack.end(); ++loc) {
+        hash = fnv1a(hash, reinterpret_cast<const char *>(&loc->line), sizeof(loc->line));
+        hash = fnv1a(hash, loc->getfile(false));
+    }
+    return hash;
+}
+
 bool ErrorLogger::ErrorMessage::deserialize(const std::string &data)
 {
     _inconclusive = false;
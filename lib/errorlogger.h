@@ -219,6 +219,27 @@ public:
         std::string serialize() const;
         bool deserialize(const std::string &data);
 
+        /**
+         * Serialize the message into a compact binary format. Used to
+         * pass messages between processes.
+         * @param data the serialized message is appended to this string
+         */
+        void serializeBinary(std::string &data) const;
+
+        /**
+         * Read a message written by serializeBinary().
+         * @return false if the data is not a valid message
+         */
+        bool deserializeBinary(const char *data, std::size_t size);
+
+        /**
+         * Hash of the parts of the message that toString() shows. Messages
+         * that are shown the same way have the same fingerprint, so it can
+         * be used to find duplicates without formatting the messages.
+         * @param verbose use verbose message
+         */
+        unsigned long long fingerprint(bool verbose) const;
+
         std::list<FileLocation> _callStack;
         std::string _id;
 
@@ -32,10 +32,12 @@ HEADERS += $${BASEPATH}check.h \
            $${BASEPATH}mathlib.h \
            $${BASEPATH}path.h \
            $${BASEPATH}preprocessor.h \
+           $${BASEPATH}resultscache.h \
            $${BASEPATH}settings.h \
            $${BASEPATH}suppressions.h \
            $${BASEPATH}symboldatabase.h \
            $${BASEPATH}templatesimplifier.h \
+           $${BASEPATH}threadpool.h \
            $${BASEPATH}timer.h \
            $${BASEPATH}token.h \
            $${BASEPATH}tokenize.h \
@@ -71,10 +73,12 @@ SOURCES += $${BASEPATH}check64bit.cpp \
            $${BASEPATH}mathlib.cpp \
            $${BASEPATH}path.cpp \
            $${BASEPATH}preprocessor.cpp \
+           $${BASEPATH}resultscache.cpp \
            $${BASEPATH}settings.cpp \
            $${BASEPATH}suppressions.cpp \
            $${BASEPATH}symboldatabase.cpp \
            $${BASEPATH}templatesimplifier.cpp \
+           $${BASEPATH}threadpool.cpp \
            $${BASEPATH}timer.cpp \
            $${BASEPATH}token.cpp \
            $${BASEPATH}tokenize.cpp \
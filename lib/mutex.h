@@ -0,0 +1,115 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2013 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef MUTEX_H
+#define MUTEX_H
+//---------------------------------------------------------------------------
+
+#include "config.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+/// @addtogroup Core
+/// @{
+
+/**
+ * @brief Simple non-recursive mutex, used to protect data that is shared
+ * between checking threads.
+ */
+class CPPCHECKLIB Mutex {
+public:
+    Mutex() {
+#ifdef _WIN32
+        InitializeCriticalSection(&_mutex);
+#else
+        pthread_mutex_init(&_mutex, NULL);
+#endif
+    }
+
+    ~Mutex() {
+#ifdef _WIN32
+        DeleteCriticalSection(&_mutex);
+#else
+        pthread_mutex_destroy(&_mutex);
+#endif
+    }
+
+    void lock() {
+#ifdef _WIN32
+        EnterCriticalSection(&_mutex);
+#else
+        pthread_mutex_lock(&_mutex);
+#endif
+    }
+
+    void unlock() {
+#ifdef _WIN32
+        LeaveCriticalSection(&_mutex);
+#else
+        pthread_mutex_unlock(&_mutex);
+#endif
+    }
+
+private:
+#ifdef _WIN32
+    CRITICAL_SECTION _mutex;
+#else
+    pthread_mutex_t _mutex;
+#endif
+
+    /** disabled copy constructor */
+    Mutex(const Mutex &);
+
+    /** disabled assignment operator */
+    void operator=(const Mutex &);
+};
+
+/**
+ * @brief Locks the given mutex for the lifetime of the object.
+ */
+class CPPCHECKLIB MutexLocker {
+public:
+    explicit MutexLocker(Mutex &mutex) : _mutex(mutex) {
+        _mutex.lock();
+    }
+
+    ~MutexLocker() {
+        _mutex.unlock();
+    }
+
+private:
+    Mutex &_mutex;
+
+    /** disabled copy constructor */
+    MutexLocker(const MutexLocker &);
+
+    /** disabled assignment operator */
+    void operator=(const MutexLocker &);
+};
+
+/// @}
+//---------------------------------------------------------------------------
+#endif // MUTEX_H
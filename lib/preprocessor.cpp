@@ -23,21 +23,206 @@
 #include "path.h"
 #include "errorlogger.h"
 #include "settings.h"
+#include "mutex.h"
+#include "resultscache.h"
+#include "timer.h"
 
 #include <algorithm>
 #include <sstream>
 #include <fstream>
 #include <cstdlib>
 #include <cctype>
+#include <ctime>
 #include <vector>
 #include <set>
 #include <stack>
+#include <iterator>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 bool Preprocessor::missingIncludeFlag;
 
 char Preprocessor::macroChar = char(1);
 
-Preprocessor::Preprocessor(Settings *settings, ErrorLogger *errorLogger) : _settings(settings), _errorLogger(errorLogger)
+namespace {
+    /**
+     * Cleaned up code of the headers that have been read, shared by all
+     * Preprocessor instances (and checking threads) of the process. An
+     * entry is only used while the content of the header is unchanged.
+     *
+     * The modification time alone is not enough: a --server runs for long,
+     * and a header can be changed twice within the resolution of the time.
+     * So the size and modification time are only trusted when the header
+     * had not been modified for a while when it was read, a later change
+     * gets another time then. Otherwise the header is read and its
+     * content is compared.
+     */
+    class HeaderCache {
+    public:
+        /** Get the code without reading the header, if its time can be trusted */
+        bool get(const std::string &key, const struct stat &st, std::string &code) {
+            MutexLocker lock(_mutex);
+            const std::map<std::string, Entry>::const_iterator it = _entries.find(key);
+            if (it == _entries.end() || !it->second.settled ||
+                it->second.mtime != st.st_mtime || it->second.size != static_cast<std::string::size_type>(st.st_size))
+                return false;
+            code = it->second.code;
+            return true;
+        }
+
+        bool get(const std::string &key, const std::string &data, std::string &code) {
+            const unsigned long long hash = ResultsCache::hash(data);
+            MutexLocker lock(_mutex);
+            const std::map<std::string, Entry>::const_iterator it = _entries.find(key);
+            if (it == _entries.end() || it->second.hash != hash || it->second.size != data.size())
+                return false;
+            code = it->second.code;
+            return true;
+        }
+
+        /** @param st status of the header, 0 if unknown */
+        void put(const std::string &key, const struct stat *st, const std::string &data, const std::string &code) {
+            const unsigned long long hash = ResultsCache::hash(data);
+            MutexLocker lock(_mutex);
+            Entry &entry = _entries[key];
+            entry.hash = hash;
+            entry.size = data.size();
+            entry.mtime = st ? st->st_mtime : 0;
+            entry.settled = st && static_cast<std::string::size_type>(st->st_size) == data.size() &&
+                            st->st_mtime + 2 < std::time(0);
+            entry.code = code;
+        }
+
+        void clear() {
+            MutexLocker lock(_mutex);
+            _entries.clear();
+        }
+
+    private:
+        struct Entry {
+            unsigned long long hash;
+            std::string::size_type size;
+            time_t mtime;
+
+            /** the header was not modified for a while before it was read */
+            bool settled;
+
+            std::string code;
+        };
+
+        std::map<std::string, Entry> _entries;
+        Mutex _mutex;
+    };
+
+    HeaderCache headerCache;
+
+    /**
+     * What getcfgs() found in the code of a header that is included by the
+     * source file: the defined macros, the configurations and the state of
+     * the conditions after the header. Shared by all Preprocessor instances
+     * of the process.
+     */
+    struct HeaderConfigurations {
+        HeaderConfigurations() : lines(0), clocks(0) {
+        }
+
+        std::vector<std::string> defines;
+        std::vector<std::string> configurations;
+        std::list<std::string> deflist;
+        std::list<std::string> ndeflist;
+        unsigned int lines;
+        std::clock_t clocks;
+    };
+
+    /**
+     * The HeaderConfigurations of the headers. The key is a hash of the
+     * code of the header and a hash of the state of getcfgs() before the
+     * header: the open conditions and the macros with values that the
+     * conditions of the header use.
+     */
+    class ConfigurationCache {
+    public:
+        typedef std::pair<unsigned long long, unsigned long long> Key;
+
+        bool get(const Key &key, HeaderConfigurations &summary) {
+            MutexLocker lock(_mutex);
+            const std::map<Key, HeaderConfigurations>::const_iterator it = _entries.find(key);
+            if (it == _entries.end())
+                return false;
+            summary = it->second;
+            return true;
+        }
+
+        void put(const Key &key, const HeaderConfigurations &summary) {
+            MutexLocker lock(_mutex);
+            _entries[key] = summary;
+        }
+
+        void clear() {
+            MutexLocker lock(_mutex);
+            _entries.clear();
+        }
+
+    private:
+        std::map<Key, HeaderConfigurations> _entries;
+        Mutex _mutex;
+    };
+
+    ConfigurationCache configurationCache;
+
+    /** Passes the messages on to another ErrorLogger and counts them */
+    class MessageCounter : public ErrorLogger {
+    public:
+        explicit MessageCounter(ErrorLogger *errorLogger) : count(0), _errorLogger(errorLogger) {
+        }
+
+        virtual void reportOut(const std::string &outmsg) {
+            ++count;
+            if (_errorLogger)
+                _errorLogger->reportOut(outmsg);
+        }
+
+        virtual void reportErr(const ErrorLogger::ErrorMessage &msg) {
+            ++count;
+            if (_errorLogger)
+                _errorLogger->reportErr(msg);
+        }
+
+        virtual void reportInfo(const ErrorLogger::ErrorMessage &msg) {
+            ++count;
+            if (_errorLogger)
+                _errorLogger->reportInfo(msg);
+        }
+
+        virtual void reportProgress(const std::string &filename, const char stage[], const std::size_t value) {
+            if (_errorLogger)
+                _errorLogger->reportProgress(filename, stage, value);
+        }
+
+        unsigned int count;
+
+    private:
+        ErrorLogger *_errorLogger;
+    };
+
+    /** Replaces an ErrorLogger pointer while the object exists */
+    class ErrorLoggerReplacement {
+    public:
+        ErrorLoggerReplacement(ErrorLogger *&errorLogger, ErrorLogger *replacement) : _errorLogger(errorLogger), _original(errorLogger) {
+            _errorLogger = replacement;
+        }
+
+        ~ErrorLoggerReplacement() {
+            _errorLogger = _original;
+        }
+
+    private:
+        ErrorLogger *&_errorLogger;
+        ErrorLogger * const _original;
+    };
+}
+
+Preprocessor::Preprocessor(Settings *settings, ErrorLogger *errorLogger) : _settings(settings), _errorLogger(errorLogger), _readSideEffects(false), m_timerResults(0), _missingFiles(0), _missingInclude(0)
 {
 
 }
@@ -213,6 +398,42 @@ std::string Preprocessor::read(std::istream &istr, const std::string &filename)
     return result;
 }
 
+std::string Preprocessor::readHeader(std::istream &istr, const std::string &filename)
+{
+    // The settings that change the result of read()
+    std::string key(filename);
+    if (_settings) {
+        key += _settings->userDefines.empty() ? "|E" : "|-";
+        key += _settings->_inlineSuppressions ? "S" : "-";
+        key += (_settings->isEnabled("style") && _settings->experimental) ? "F" : "-";
+    }
+
+    struct stat st;
+    const bool haveStat = (stat(filename.c_str(), &st) == 0);
+    std::string code;
+    if (haveStat && headerCache.get(key, st, code))
+        return code;
+
+    const std::string data((std::istreambuf_iterator<char>(istr)), std::istreambuf_iterator<char>());
+    if (headerCache.get(key, data, code))
+        return code;
+
+    // Only cache headers that did not report errors or add suppressions,
+    // those must be handled again for every file that includes them.
+    _readSideEffects = false;
+    std::istringstream dataStream(data);
+    code = read(dataStream, filename);
+    if (!_readSideEffects)
+        headerCache.put(key, haveStat ? &st : 0, data, code);
+    return code;
+}
+
+void Preprocessor::clearHeaderCache()
+{
+    headerCache.clear();
+    configurationCache.clear();
+}
+
 std::string Preprocessor::preprocessCleanupDirectives(const std::string &processedFile)
 {
     std::ostringstream code;
@@ -354,6 +575,7 @@ std::string Preprocessor::removeComments(const std::string &str, const std::stri
                    << "Neither unicode nor extended ASCII are supported. "
                    << "(line=" << lineno << ", character code=" << std::hex << (int(ch) & 0xff) << ")";
             writeError(filename, lineno, _errorLogger, "syntaxError", errmsg.str());
+            _readSideEffects = true;
         }
 
         if ((str.compare(i, 7, "#error ") == 0 && (!_settings || _settings->userDefines.empty())) ||
@@ -472,6 +694,7 @@ std::string Preprocessor::removeComments(const std::string &str, const std::stri
             if (!suppressionIDs.empty()) {
                 if (_settings != NULL) {
                     // Add the suppressions.
+                    _readSideEffects = true;
                     for (std::size_t j = 0; j < suppressionIDs.size(); ++j) {
                         const std::string errmsg(_settings->nomsg.addSuppression(suppressionIDs[j], filename, lineno));
                         if (!errmsg.empty()) {
@@ -500,6 +723,7 @@ std::string Preprocessor::removeComments(const std::string &str, const std::stri
                 if (!suppressionIDs.empty()) {
                     if (_settings != NULL) {
                         // Add the suppressions.
+                        _readSideEffects = true;
                         for (std::size_t j = 0; j < suppressionIDs.size(); ++j) {
                             const std::string errmsg(_settings->nomsg.addSuppression(suppressionIDs[j], filename, lineno));
                             if (!errmsg.empty()) {
@@ -814,6 +1038,8 @@ void Preprocessor::preprocess(std::istream &srcCodeStream, std::string &processe
 
             fin.open(cur.c_str());
             if (!fin.is_open()) {
+                if (_missingFiles)
+                    _missingFiles->insert(cur);
                 missingInclude(cur,
                                1,
                                cur,
@@ -821,7 +1047,7 @@ void Preprocessor::preprocess(std::istream &srcCodeStream, std::string &processe
                               );
                 continue;
             }
-            std::string fileData = read(fin, filename);
+            std::string fileData = readHeader(fin, cur);
 
             fin.close();
 
@@ -1002,8 +1228,7 @@ static Token *simplifyVarMapExpandValue(Token *tok, const std::map<std::string,
     const std::map<std::string, std::string>::const_iterator it = variables.find(tok->str());
     if (it != variables.end()) {
         TokenList tokenList(NULL);
-        std::istringstream istr(it->second);
-        if (tokenList.createTokens(istr)) {
+        if (tokenList.createTokens(it->second.data(), it->second.size())) {
             // expand token list
             for (Token *tok2 = tokenList.front(); tok2; tok2 = tok2->next()) {
                 if (tok2->isName()) {
@@ -1033,8 +1258,7 @@ static void simplifyVarMap(std::map<std::string, std::string> &variables)
 {
     for (std::map<std::string, std::string>::iterator i = variables.begin(); i != variables.end(); ++i) {
         TokenList tokenList(NULL);
-        std::istringstream istr(i->second);
-        if (tokenList.createTokens(istr)) {
+        if (tokenList.createTokens(i->second.data(), i->second.size())) {
             for (Token *tok = tokenList.front(); tok; tok = tok->next()) {
                 if (tok->isName()) {
                     std::set<std::string> seenVariables;
@@ -1050,6 +1274,76 @@ static void simplifyVarMap(std::map<std::string, std::string> &variables)
     }
 }
 
+/**
+ * Find the end of a header in the code of getcfgs()
+ * @param filedata the code
+ * @param start position after the "#file" line of the header
+ * @param codeEnd set to the position of the matching "#endfile" line
+ * @return position after the "#endfile" line, std::string::npos if there is none
+ */
+static std::string::size_type findEndOfHeader(const std::string &filedata, std::string::size_type start, std::string::size_type &codeEnd)
+{
+    int filelevel = 1;
+    std::string::size_type pos = start;
+    while (pos < filedata.size()) {
+        std::string::size_type next = filedata.find('\n', pos);
+        next = (next == std::string::npos) ? filedata.size() : next + 1;
+        if (filedata.compare(pos, 6, "#file ") == 0)
+            ++filelevel;
+        else if (filedata.compare(pos, next - pos, "#endfile\n") == 0 || filedata.compare(pos, next - pos, "#endfile") == 0) {
+            if (--filelevel == 0) {
+                codeEnd = pos;
+                return next;
+            }
+        }
+        pos = next;
+    }
+    return std::string::npos;
+}
+
+/** @brief Hash of the state of getcfgs() that the configurations in the header @p code depend on */
+static unsigned long long getcfgsStateHash(const std::string &code, const std::set<std::string> &defines, const std::list<std::string> &deflist, const std::list<std::string> &ndeflist)
+{
+    // The names in the conditions of the header
+    std::set<std::string> names;
+    std::string::size_type pos = 0;
+    while (pos < code.size()) {
+        std::string::size_type next = code.find('\n', pos);
+        if (next == std::string::npos)
+            next = code.size();
+        if (code.compare(pos, 3, "#if") == 0 || code.compare(pos, 5, "#elif") == 0) {
+            for (std::string::size_type i = pos + 1; i < next; ++i) {
+                if (std::isalpha(static_cast<unsigned char>(code[i])) || code[i] == '_') {
+                    std::string::size_type end = i;
+                    while (end < next && (std::isalnum(static_cast<unsigned char>(code[end])) || code[end] == '_'))
+                        ++end;
+                    names.insert(code.substr(i, end - i));
+                    i = end;
+                } else if (std::isdigit(static_cast<unsigned char>(code[i]))) {
+                    while (i + 1 < next && (std::isalnum(static_cast<unsigned char>(code[i + 1])) || code[i + 1] == '_'))
+                        ++i;
+                }
+            }
+        }
+        pos = next + 1;
+    }
+
+    // Only the macros with values are used to simplify the conditions
+    std::string state;
+    for (std::set<std::string>::const_iterator it = defines.begin(); it != defines.end(); ++it) {
+        const std::string::size_type eq = it->find_first_of("=(");
+        if (eq != std::string::npos && (*it)[eq] == '=' && names.find(it->substr(0, eq)) != names.end())
+            state += *it + '\n';
+    }
+    state += '\0';
+    for (std::list<std::string>::const_iterator it = deflist.begin(); it != deflist.end(); ++it)
+        state += *it + '\n';
+    state += '\0';
+    for (std::list<std::string>::const_iterator it = ndeflist.begin(); it != ndeflist.end(); ++it)
+        state += *it + '\n';
+    return ResultsCache::hash(state);
+}
+
 std::list<std::string> Preprocessor::getcfgs(const std::string &filedata, const std::string &filename)
 {
     std::list<std::string> ret;
@@ -1066,6 +1360,18 @@ std::list<std::string> Preprocessor::getcfgs(const std::string &filedata, const
 
     bool includeguard = false;
 
+    // The headers that the source file includes are summarized, the
+    // summary is used when the same header is included in the same state.
+    // Headers with messages are not summarized.
+    MessageCounter messages(_errorLogger);
+    const ErrorLoggerReplacement replacement(_errorLogger, &messages);
+    unsigned int headerMessages = 0;
+    bool recording = false;
+    HeaderConfigurations headerSummary;
+    ConfigurationCache::Key headerKey;
+    unsigned int headerLinenr = 0;
+    std::clock_t headerStart = 0;
+
     unsigned int linenr = 0;
     std::istringstream istr(filedata);
     std::string line;
@@ -1081,6 +1387,37 @@ std::list<std::string> Preprocessor::getcfgs(const std::string &filedata, const
         if (line.compare(0, 6, "#file ") == 0) {
             includeguard = true;
             ++filelevel;
+
+            const std::streamoff start = istr.tellg();
+            std::string::size_type codeEnd = 0;
+            const std::string::size_type end = (filelevel == 1 && start >= 0) ? findEndOfHeader(filedata, static_cast<std::string::size_type>(start), codeEnd) : std::string::npos;
+            if (end != std::string::npos) {
+                const std::string code(filedata, static_cast<std::string::size_type>(start), codeEnd - static_cast<std::string::size_type>(start));
+                headerKey = ConfigurationCache::Key(ResultsCache::hash(code), getcfgsStateHash(code, defines, deflist, ndeflist));
+                HeaderConfigurations summary;
+                if (configurationCache.get(headerKey, summary)) {
+                    defines.insert(summary.defines.begin(), summary.defines.end());
+                    for (std::vector<std::string>::const_iterator it = summary.configurations.begin(); it != summary.configurations.end(); ++it) {
+                        if (std::find(ret.begin(), ret.end(), *it) == ret.end())
+                            ret.push_back(*it);
+                    }
+                    deflist = summary.deflist;
+                    ndeflist = summary.ndeflist;
+                    linenr += summary.lines;
+                    includeguard = false;
+                    filelevel = 0;
+                    istr.seekg(static_cast<std::streamoff>(end));
+                    if (m_timerResults)
+                        m_timerResults->AddResults("Preprocessor::getcfgs (saved by header summaries)", summary.clocks);
+                    continue;
+                }
+
+                recording = true;
+                headerSummary = HeaderConfigurations();
+                headerLinenr = linenr;
+                headerMessages = messages.count;
+                headerStart = std::clock();
+            }
             continue;
         }
 
@@ -1088,6 +1425,16 @@ std::list<std::string> Preprocessor::getcfgs(const std::string &filedata, const
             includeguard = false;
             if (filelevel > 0)
                 --filelevel;
+            if (recording && filelevel == 0) {
+                recording = false;
+                if (messages.count == headerMessages) {
+                    headerSummary.deflist = deflist;
+                    headerSummary.ndeflist = ndeflist;
+                    headerSummary.lines = linenr - headerLinenr;
+                    headerSummary.clocks = std::clock() - headerStart;
+                    configurationCache.put(headerKey, headerSummary);
+                }
+            }
             continue;
         }
 
@@ -1108,12 +1455,13 @@ std::list<std::string> Preprocessor::getcfgs(const std::string &filedata, const
             }
             if (!valid)
                 line.clear();
-            else if (line.find(" ", 8) == std::string::npos)
-                defines.insert(line.substr(8));
             else {
                 std::string s = line.substr(8);
-                s[s.find(" ")] = '=';
+                if (s.find(" ") != std::string::npos)
+                    s[s.find(" ")] = '=';
                 defines.insert(s);
+                if (recording)
+                    headerSummary.defines.push_back(s);
             }
         }
 
@@ -1261,6 +1609,8 @@ std::list<std::string> Preprocessor::getcfgs(const std::string &filedata, const
                 deflist.back() = "!";
             }
 
+            if (recording)
+                headerSummary.configurations.push_back(def);
             if (std::find(ret.begin(), ret.end(), def) == ret.end()) {
                 ret.push_back(def);
             }
@@ -1890,13 +2240,16 @@ Preprocessor::HeaderTypes Preprocessor::getHeaderFileName(std::string &str)
  * @param fin file input stream (in/out)
  * @return if file is opened then true is returned
  */
-static bool openHeader(std::string &filename, const std::list<std::string> &includePaths, const std::string &filePath, std::ifstream &fin)
+static bool openHeader(std::string &filename, const std::list<std::string> &includePaths, const std::string &filePath, std::ifstream &fin, std::set<std::string> *missingFiles)
 {
     fin.open((filePath + filename).c_str());
     if (fin.is_open()) {
         filename = filePath + filename;
         return true;
     }
+    fin.clear();
+    if (missingFiles)
+        missingFiles->insert(filePath + filename);
 
     std::list<std::string> includePaths2(includePaths);
     includePaths2.push_front("");
@@ -1909,6 +2262,8 @@ static bool openHeader(std::string &filename, const std::list<std::string> &incl
             return true;
         }
         fin.clear();
+        if (missingFiles)
+            missingFiles->insert(nativePath + filename);
     }
 
     return false;
@@ -2084,7 +2439,7 @@ std::string Preprocessor::handleIncludes(const std::string &code, const std::str
                 if (headerType == UserHeader)
                     filepath = path;
                 std::ifstream fin;
-                if (!openHeader(filename, includePaths, filepath, fin)) {
+                if (!openHeader(filename, includePaths, filepath, fin, _missingFiles)) {
                     missingInclude(Path::toNativeSeparators(filePath),
                                    linenr,
                                    filename,
@@ -2103,7 +2458,7 @@ std::string Preprocessor::handleIncludes(const std::string &code, const std::str
                 includes.push_back(filename);
 
                 ostr << "#file \"" << filename << "\"\n"
-                     << handleIncludes(read(fin, filename), filename, includePaths, defs, includes) << std::endl
+                     << handleIncludes(readHeader(fin, filename), filename, includePaths, defs, includes) << std::endl
                      << "#endfile\n";
                 continue;
             }
@@ -2161,7 +2516,7 @@ void Preprocessor::handleIncludes(std::string &code, const std::string &filePath
         if (headerType == UserHeader && !paths.empty())
             filepath = paths.back();
         std::ifstream fin;
-        const bool fileOpened(openHeader(filename, includePaths, filepath, fin));
+        const bool fileOpened(openHeader(filename, includePaths, filepath, fin, _missingFiles));
 
         if (fileOpened) {
             filename = Path::simplifyPath(filename.c_str());
@@ -2175,7 +2530,7 @@ void Preprocessor::handleIncludes(std::string &code, const std::string &filePath
             }
 
             handledFiles.insert(tempFile);
-            processedFile = Preprocessor::read(fin, filename);
+            processedFile = readHeader(fin, filename);
             fin.close();
         }
 
@@ -2224,6 +2579,8 @@ void Preprocessor::missingInclude(const std::string &filename, unsigned int line
     const std::string msgtype = (headerType==SystemHeader)?"missingIncludeSystem":"missingInclude";
     if (!_settings->nomsg.isSuppressed(msgtype, Path::fromNativeSeparators(filename), linenr)) {
         missingIncludeFlag = true;
+        if (_missingInclude)
+            *_missingInclude = true;
         if (_errorLogger && _settings->checkConfiguration) {
 
             std::list<ErrorLogger::ErrorMessage::FileLocation> locationList;
@@ -2438,8 +2795,7 @@ public:
         tokenizer.setSettings(&settings);
 
         // Tokenize the macro to make it easier to handle
-        std::istringstream istr(macro);
-        tokenizer.list.createTokens(istr);
+        tokenizer.list.createTokens(macro.data(), macro.size());
 
         // macro name..
         if (tokens() && tokens()->isName())
@@ -22,6 +22,7 @@
 //---------------------------------------------------------------------------
 
 #include <map>
+#include <set>
 #include <istream>
 #include <string>
 #include <list>
@@ -29,6 +30,7 @@
 
 class ErrorLogger;
 class Settings;
+class TimerResults;
 
 /// @addtogroup Core
 /// @{
@@ -55,6 +57,28 @@ public:
 
     Preprocessor(Settings *settings = 0, ErrorLogger *errorLogger = 0);
 
+    /** The time that getcfgs() saves by reusing header summaries is added here (--showtime) */
+    void setTimerResults(TimerResults *tr) {
+        m_timerResults = tr;
+    }
+
+    /**
+     * The paths where an included file was looked for and not found are
+     * added here. The result of preprocessing changes when one of them is
+     * created (--incremental).
+     */
+    void setMissingFiles(std::set<std::string> *missingFiles) {
+        _missingFiles = missingFiles;
+    }
+
+    /**
+     * This is set to true when an include is missing, like
+     * missingIncludeFlag but only for this preprocessor (--incremental).
+     */
+    void setMissingInclude(bool *missingInclude) {
+        _missingInclude = missingInclude;
+    }
+
     static bool missingIncludeFlag;
 
     /**
@@ -243,11 +267,29 @@ public:
         file0 = f;
     }
 
+    /**
+     * Forget the headers that have been read. Headers are cached across
+     * files. A cached header is used while a hash of its content is the
+     * same, its size and modification time are enough when it had not been
+     * modified for a while when it was read.
+     * The configurations that getcfgs() found in headers are forgotten too.
+     */
+    static void clearHeaderCache();
+
 private:
     void missingInclude(const std::string &filename, unsigned int linenr, const std::string &header, HeaderTypes headerType);
 
     void error(const std::string &filename, unsigned int linenr, const std::string &msg);
 
+    /**
+     * Read a header like read(), but reuse the result when the same
+     * unchanged header has been read before by any Preprocessor.
+     * @param istr The opened header
+     * @param filename Path of the header
+     * @return cleaned up code of the header
+     */
+    std::string readHeader(std::istream &istr, const std::string &filename);
+
     /**
      * Search includes from code and append code from the included
      * file
@@ -267,6 +309,15 @@ private:
 
     /** filename for cpp/c file - useful when reporting errors */
     std::string file0;
+
+    /** set when read() reports errors or adds suppressions */
+    bool _readSideEffects;
+
+    TimerResults *m_timerResults;
+
+    std::set<std::string> *_missingFiles;
+
+    bool *_missingInclude;
 };
 
 /// @}
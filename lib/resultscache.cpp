@@ -0,0 +1,203 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2013 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "resultscache.h"
+#include "cppcheck.h"
+#include "settings.h"
+#include "mutex.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+/** @brief First line of a results file, change the version when the format changes */
+static const char Header[] = "cppcheck results 2\n";
+
+/** @brief FNV-1a hash of @p str, continuing from @p hash */
+static unsigned long long fnv1a(unsigned long long hash, const std::string &str)
+{
+    // Hash the length too so that the strings can't be confused with each other
+    const std::size_t len = str.size();
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(&len);
+    for (std::size_t i = 0; i < sizeof(len); ++i) {
+        hash ^= p[i];
+        hash *= 1099511628211ULL;
+    }
+    for (std::size_t i = 0; i < str.size(); ++i) {
+        hash ^= static_cast<unsigned char>(str[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+ResultsCache::ResultsCache(const std::string &dir)
+    : _dir(dir)
+{
+    if (!_dir.empty() && _dir[_dir.size() - 1] != '/' && _dir[_dir.size() - 1] != '\\')
+        _dir += '/';
+}
+
+/** @brief Write the settings that change the tokens, and the file names in the messages */
+static void writeTokenizerSettings(std::ostream &ostr, const Settings &settings)
+{
+    ostr << CppCheck::version() << ' ' << CppCheck::extraVersion() << '\n'
+         << settings.debug << settings.debugwarnings << settings.inconclusive << settings.experimental
+         << ' ' << static_cast<int>(settings.enforcedLang)
+         << ' ' << static_cast<int>(settings.standards.c) << static_cast<int>(settings.standards.cpp) << settings.standards.posix
+         << ' ' << static_cast<int>(settings.platformType)
+         << ' ' << settings.sizeof_bool << ' ' << settings.sizeof_short << ' ' << settings.sizeof_int
+         << ' ' << settings.sizeof_long << ' ' << settings.sizeof_long_long << ' ' << settings.sizeof_float
+         << ' ' << settings.sizeof_double << ' ' << settings.sizeof_long_double << ' ' << settings.sizeof_wchar_t
+         << ' ' << settings.sizeof_size_t << ' ' << settings.sizeof_pointer << '\n';
+    for (std::vector<std::string>::const_iterator it = settings._basePaths.begin(); it != settings._basePaths.end(); ++it)
+        ostr << *it << '\n';
+    ostr << '\n';
+}
+
+unsigned long long ResultsCache::key(const std::string &code, const std::string &filename, const std::string &configuration, const Settings &settings)
+{
+    // The settings that change what is reported for the code
+    std::ostringstream ostr;
+    writeTokenizerSettings(ostr, settings);
+    for (std::set<std::string>::const_iterator it = settings.enabled().begin(); it != settings.enabled().end(); ++it)
+        ostr << *it << ',';
+    ostr << '\n' << settings.checkHeadersOnce << '\n';
+    for (std::list<Settings::Rule>::const_iterator it = settings.rules.begin(); it != settings.rules.end(); ++it)
+        ostr << it->pattern << '\n' << it->id << '\n' << it->severity << '\n' << it->summary << '\n';
+
+    unsigned long long hash = 14695981039346656037ULL;
+    hash = fnv1a(hash, ostr.str());
+    hash = fnv1a(hash, filename);
+    hash = fnv1a(hash, configuration);
+    hash = fnv1a(hash, code);
+    return hash;
+}
+
+unsigned long long ResultsCache::tokensKey(const std::string &code, const std::string &filename, const std::string &configuration, const Settings &settings)
+{
+    // The tokenizer only reports some messages when their ids are enabled
+    std::ostringstream ostr;
+    ostr << "tokens\n";
+    writeTokenizerSettings(ostr, settings);
+    ostr << settings.isEnabled("style") << settings.isEnabled("portability") << settings.isEnabled("information") << '\n';
+
+    unsigned long long hash = 14695981039346656037ULL;
+    hash = fnv1a(hash, ostr.str());
+    hash = fnv1a(hash, filename);
+    hash = fnv1a(hash, configuration);
+    hash = fnv1a(hash, code);
+    return hash;
+}
+
+unsigned long long ResultsCache::hash(const std::string &data)
+{
+    return fnv1a(14695981039346656037ULL, data);
+}
+
+std::string ResultsCache::filename(unsigned long long key) const
+{
+    std::ostringstream ostr;
+    ostr << _dir << std::hex << std::setw(16) << std::setfill('0') << key << ".results";
+    return ostr.str();
+}
+
+bool ResultsCache::load(unsigned long long key, std::vector<std::pair<char, std::string> > &records) const
+{
+    std::ifstream fin(filename(key).c_str(), std::ios::in | std::ios::binary);
+    if (!fin.is_open())
+        return false;
+
+    std::ostringstream ostr;
+    ostr << fin.rdbuf();
+    const std::string data = ostr.str();
+
+    const std::size_t headerSize = sizeof(Header) - 1;
+    if (data.compare(0, headerSize, Header) != 0)
+        return false;
+    return getRecords(data.substr(headerSize), records);
+}
+
+bool ResultsCache::save(unsigned long long key, const std::string &data) const
+{
+    // Config threads and other processes might save the same results at the same time
+    static Mutex counterSync;
+    static unsigned int counter = 0;
+    unsigned int id;
+    {
+        MutexLocker lock(counterSync);
+        id = counter++;
+    }
+
+    const std::string name = filename(key);
+    std::ostringstream tmpname;
+    tmpname << name << '.' << getpid() << '.' << id << ".tmp";
+
+    {
+        std::ofstream fout(tmpname.str().c_str(), std::ios::out | std::ios::binary);
+        if (!fout.is_open())
+            return false;
+        fout << Header << data;
+        if (!fout.flush()) {
+            fout.close();
+            std::remove(tmpname.str().c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(tmpname.str().c_str(), name.c_str()) != 0) {
+        // On Windows the rename fails if the results were saved by someone else
+        std::remove(tmpname.str().c_str());
+        return false;
+    }
+    return true;
+}
+
+void ResultsCache::addRecord(std::string &data, char type, const std::string &record)
+{
+    const unsigned int len = static_cast<unsigned int>(record.size());
+    data += type;
+    data.append(reinterpret_cast<const char *>(&len), sizeof(len));
+    data += record;
+}
+
+bool ResultsCache::getRecords(const std::string &data, std::vector<std::pair<char, std::string> > &records)
+{
+    records.clear();
+    const std::size_t headerSize = 1 + sizeof(unsigned int);
+    std::size_t pos = 0;
+    while (pos < data.size()) {
+        if (data.size() - pos < headerSize)
+            return false;
+        unsigned int len = 0;
+        std::memcpy(&len, data.data() + pos + 1, sizeof(len));
+        if (data.size() - pos - headerSize < len)
+            return false;
+        records.push_back(std::make_pair(data[pos], data.substr(pos + headerSize, len)));
+        pos += headerSize + len;
+    }
+    return true;
+}
@@ -0,0 +1,96 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2013 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef RESULTSCACHE_H
+#define RESULTSCACHE_H
+//---------------------------------------------------------------------------
+
+#include "config.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+class Settings;
+
+/// @addtogroup Core
+/// @{
+
+/**
+ * @brief Stores the results of checking a file in a directory (--cache-dir,
+ * --incremental).
+ *
+ * The results of each configuration of a file are kept in a file of their
+ * own. The name of the file is a hash of the preprocessed code, the file
+ * name, the configuration and the settings that change the results, so
+ * results are only found again when none of them has changed. The results
+ * are a sequence of records, each is a type character and data.
+ */
+class CPPCHECKLIB ResultsCache {
+public:
+    explicit ResultsCache(const std::string &dir);
+
+    /**
+     * @brief Key of the results of a configuration of a file
+     * @param code the preprocessed code, with the appended code
+     * @param filename name of the checked file
+     * @param configuration the preprocessor configuration
+     * @param settings the settings
+     */
+    static unsigned long long key(const std::string &code, const std::string &filename, const std::string &configuration, const Settings &settings);
+
+    /**
+     * @brief Key of the tokens of a configuration of a file, see
+     * Tokenizer::loadSnapshot(). Only the settings that change the tokens
+     * or the messages of the tokenizer are part of the key.
+     */
+    static unsigned long long tokensKey(const std::string &code, const std::string &filename, const std::string &configuration, const Settings &settings);
+
+    /** @brief Hash of the content of a file */
+    static unsigned long long hash(const std::string &data);
+
+    /**
+     * @brief Read the results stored with @p key
+     * @return false if there are no (valid) results
+     */
+    bool load(unsigned long long key, std::vector<std::pair<char, std::string> > &records) const;
+
+    /**
+     * @brief Store results, see addRecord(). The results are written to a
+     * temporary file that is renamed, so other processes never read a
+     * partially written file.
+     * @return false if the results could not be written
+     */
+    bool save(unsigned long long key, const std::string &data) const;
+
+    /** @brief Append a record to the results that are saved */
+    static void addRecord(std::string &data, char type, const std::string &record);
+
+    /** @brief Split the results into records. @return false if the data is invalid */
+    static bool getRecords(const std::string &data, std::vector<std::pair<char, std::string> > &records);
+
+private:
+    /** @brief Name of the file that has the results of @p key */
+    std::string filename(unsigned long long key) const;
+
+    std::string _dir;
+};
+
+/// @}
+//---------------------------------------------------------------------------
+#endif // RESULTSCACHE_H
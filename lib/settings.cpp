@@ -34,12 +34,19 @@ Settings::Settings()
       _relativePaths(false),
       _xml(false), _xml_version(1),
       _jobs(1),
+      executor(Process),
+      configJobs(1),
+      checkJobs(1),
+      jobServer(false),
+      maxMemory(0),
+      shardIndex(1), shardCount(1),
       _exitCode(0),
       _showtime(0),
       _maxConfigs(12),
       enforcedLang(None),
       reportProgress(false),
-      checkConfiguration(false)
+      checkConfiguration(false),
+      checkHeadersOnce(false)
 {
     // This assumes the code you are checking is for the same architecture this is compiled on.
 #if defined(_WIN64)
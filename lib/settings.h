@@ -23,6 +23,7 @@
 #include <vector>
 #include <string>
 #include <set>
+#include <map>
 #include "config.h"
 #include "suppressions.h"
 #include "standards.h"
@@ -108,6 +109,77 @@ public:
         time. Default is 1. (-j N) */
     unsigned int _jobs;
 
+    enum Executor {
+        Process, Thread
+    };
+
+    /** @brief How the -j jobs are run (--executor=process|thread). With
+        'process' each job is a separate process, with 'thread' all jobs
+        are threads in the cppcheck process. */
+    Executor executor;
+
+    /** @brief How many preprocessor configurations of a file are checked
+        at the same time by threads. Default is 1. (--config-jobs=N) */
+    unsigned int configJobs;
+
+    /** @brief How many Check classes are run at the same time by threads
+        on the token list of a file. Default is 1. (--check-jobs=N) */
+    unsigned int checkJobs;
+
+    /** @brief File with the time it took to check each file in the
+        previous run. Used to start the slowest files first with -j.
+        (--timings-file=<file>) */
+    std::string timingsFile;
+
+    /** @brief Share the job slots of GNU make: a file is only started
+        by a -j job when the make jobserver in MAKEFLAGS gives a free
+        slot. (--jobserver) */
+    bool jobServer;
+
+    /** @brief Memory budget in bytes of the -j jobs, 0 if there is no
+        budget. A new file is not started while the jobs are near the
+        budget. (--max-memory=<size>) */
+    unsigned long long maxMemory;
+
+    /** @brief Directory where the results of each configuration of a
+        file are kept. A configuration whose preprocessed code and settings
+        have not changed is not checked again. (--cache-dir=<dir>) */
+    std::string cacheDir;
+
+    /** @brief Directory where the results of each file are kept together
+        with the hashes of the file and the headers it includes. A file is
+        only checked again when it or one of its headers has changed.
+        (--incremental=<dir>) */
+    std::string incrementalDir;
+
+    /** @brief Unix domain socket where cppcheck waits for requests to
+        check files, instead of checking the files given on the command
+        line. (--server=<socket>) */
+    std::string serverSocket;
+
+    /** @brief The preprocessor flags of a file in a compilation database */
+    class CPPCHECKLIB FileSettings {
+    public:
+        std::string filename;
+        std::string defines;
+        std::set<std::string> undefs;
+        std::list<std::string> includePaths;
+        std::list<std::string> userIncludes;
+    };
+
+    /** @brief The files of a compilation database with the flags they are
+        compiled with. The key is the job name that is given to
+        CppCheck::check(), the file name with " (2)" etc. appended when the
+        file is compiled with different flags more than once. Only the
+        configuration of the flags is checked. (--project=<file>) */
+    std::map<std::string, FileSettings> fileSettings;
+
+    /** @brief Check only the part shardIndex (1..shardCount) of the files.
+        The files are split by size in the same way on every machine, so
+        that each machine can check one part. (--shard=<i>/<N>) */
+    unsigned int shardIndex;
+    unsigned int shardCount;
+
     /** @brief If errors are found, this value is returned from main().
         Default value is 0. */
     int _exitCode;
@@ -149,6 +221,11 @@ public:
      */
     std::string addEnabled(const std::string &str);
 
+    /** @brief The ids of the enabled extra checks, see isEnabled() */
+    const std::set<std::string> &enabled() const {
+        return _enabled;
+    }
+
     enum Language {
         None, C, CPP
     };
@@ -196,6 +273,12 @@ public:
     /** Is the 'configuration checking' wanted? */
     bool checkConfiguration;
 
+    /** @brief Check the code of each header once. The function bodies in
+        headers whose code has been checked before in this process are
+        removed, unless other code uses them, and the messages about these
+        headers are not reported again. (--check-headers-once) */
+    bool checkHeadersOnce;
+
     /** Struct contains standards settings */
     Standards standards;
 
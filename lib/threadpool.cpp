@@ -0,0 +1,98 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2013 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "threadpool.h"
+
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+namespace {
+    struct ThreadData {
+        ThreadPool::Worker worker;
+        void *data;
+    };
+}
+
+#ifdef _WIN32
+static unsigned __stdcall threadProc(void *arg)
+{
+    const ThreadData *threadData = static_cast<const ThreadData *>(arg);
+    threadData->worker(threadData->data);
+    return 0;
+}
+#else
+extern "C" {
+    static void *threadProc(void *arg)
+    {
+        const ThreadData *threadData = static_cast<const ThreadData *>(arg);
+        threadData->worker(threadData->data);
+        return NULL;
+    }
+}
+#endif
+
+unsigned int ThreadPool::run(unsigned int threads, Worker worker, void *data)
+{
+    ThreadData threadData;
+    threadData.worker = worker;
+    threadData.data = data;
+
+#ifdef _WIN32
+    std::vector<HANDLE> handles;
+    for (unsigned int i = 0; i < threads; ++i) {
+        const HANDLE handle = (HANDLE)_beginthreadex(NULL, 0, threadProc, &threadData, 0, NULL);
+        if (!handle)
+            break;
+        handles.push_back(handle);
+    }
+
+    for (std::size_t i = 0; i < handles.size(); ++i) {
+        WaitForSingleObject(handles[i], INFINITE);
+        CloseHandle(handles[i]);
+    }
+
+    const std::size_t started = handles.size();
+#else
+    std::vector<pthread_t> handles;
+    for (unsigned int i = 0; i < threads; ++i) {
+        pthread_t handle;
+        if (pthread_create(&handle, NULL, threadProc, &threadData) != 0)
+            break;
+        handles.push_back(handle);
+    }
+
+    for (std::size_t i = 0; i < handles.size(); ++i)
+        pthread_join(handles[i], NULL);
+
+    const std::size_t started = handles.size();
+#endif
+
+    // No threads could be created => do the work in this thread
+    if (started == 0 && threads > 0) {
+        worker(data);
+        return 1;
+    }
+
+    return static_cast<unsigned int>(started);
+}
@@ -0,0 +1,54 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2013 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+//---------------------------------------------------------------------------
+
+#include "config.h"
+
+/// @addtogroup Core
+/// @{
+
+/**
+ * @brief Runs a worker function in a fixed number of threads.
+ *
+ * The workers are expected to fetch their work items from a shared,
+ * mutex protected queue until it is empty. Because of that the worker
+ * is simply run in the calling thread if no threads can be created.
+ */
+class CPPCHECKLIB ThreadPool {
+public:
+    /** Worker function. It is called once in each thread. */
+    typedef void (*Worker)(void *data);
+
+    /**
+     * @brief Start @p threads threads running @p worker and wait until
+     * all of them have finished.
+     * @param threads number of threads to start
+     * @param worker worker function
+     * @param data argument given to the worker function
+     * @return number of threads that were started
+     */
+    static unsigned int run(unsigned int threads, Worker worker, void *data);
+};
+
+/// @}
+//---------------------------------------------------------------------------
+#endif // THREADPOOL_H
@@ -24,7 +24,6 @@
     - sort list by time
     - do not sort the results alphabetically
     - rename "file" to "single"
-    - synchronise map access in multithreaded mode or disable timing
     - add unit tests
         - for --showtime (needs input file)
         - for Timer* classes
@@ -33,6 +32,7 @@
 
 void TimerResults::ShowResults() const
 {
+    MutexLocker lock(_resultsSync);
     TimerResultsData overallData;
 
     std::map<std::string, struct TimerResultsData>::const_iterator I = _results.begin();
@@ -50,14 +50,24 @@ void TimerResults::ShowResults() const
 
     const double secOverall = overallData.seconds();
     std::cout << "Overall time: " << secOverall << "s" << std::endl;
+
+    for (std::map<std::string, unsigned long long>::const_iterator it = _counts.begin(); it != _counts.end(); ++it)
+        std::cout << it->first << ": " << it->second << std::endl;
 }
 
 void TimerResults::AddResults(const std::string& str, std::clock_t clocks)
 {
+    MutexLocker lock(_resultsSync);
     _results[str]._clocks += clocks;
     _results[str]._numberOfResults++;
 }
 
+void TimerResults::AddCount(const std::string& str, unsigned long long count)
+{
+    MutexLocker lock(_resultsSync);
+    _counts[str] += count;
+}
+
 Timer::Timer(const std::string& str, unsigned int showtimeMode, TimerResultsIntf* timerResults)
     : _str(str)
     , _timerResults(timerResults)
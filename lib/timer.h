@@ -23,6 +23,7 @@
 #include <map>
 #include <ctime>
 #include "config.h"
+#include "mutex.h"
 
 enum {
     SHOWTIME_NONE = 0,
@@ -61,8 +62,15 @@ public:
     void ShowResults() const;
     virtual void AddResults(const std::string& str, std::clock_t clocks);
 
+    /** @brief Add to a counter that is shown after the times */
+    void AddCount(const std::string& str, unsigned long long count);
+
 private:
     std::map<std::string, struct TimerResultsData> _results;
+    std::map<std::string, unsigned long long> _counts;
+
+    /** results are added from all checking threads */
+    mutable Mutex _resultsSync;
 };
 
 class CPPCHECKLIB Timer {
@@ -17,8 +17,10 @@
  */
 
 #include "token.h"
+#include "tokenlist.h"
 #include "errorlogger.h"
 #include "check.h"
+#include "mutex.h"
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
@@ -27,15 +29,265 @@
 #include <cctype>
 #include <sstream>
 #include <map>
+#include <vector>
+#include <algorithm>
+
+namespace {
+    /** @brief Type of a token with the string s, without a link or varId */
+    Token::Type stringType(const std::string &s)
+    {
+        if (s.empty())
+            return Token::eNone;
+        if (s == "true" || s == "false")
+            return Token::eBoolean;
+        if (s[0] == '_' || std::isalpha(s[0]))
+            return Token::eName;
+        if (std::isdigit(s[0]) || (s.length() > 1 && s[0] == '-' && std::isdigit(s[1])))
+            return Token::eNumber;
+        if (s.length() > 1 && s[0] == '"' && s[s.length()-1] == '"')
+            return Token::eString;
+        if (s.length() > 1 && s[0] == '\'' && s[s.length()-1] == '\'')
+            return Token::eChar;
+        if (s == "="   ||
+            s == "+="  ||
+            s == "-="  ||
+            s == "*="  ||
+            s == "/="  ||
+            s == "%="  ||
+            s == "&="  ||
+            s == "^="  ||
+            s == "|="  ||
+            s == "<<=" ||
+            s == ">>=")
+            return Token::eAssignmentOp;
+        if (s.size() == 1 && s.find_first_of(",[]()?:") != std::string::npos)
+            return Token::eExtendedOp;
+        if (s=="<<" || s==">>" || (s.size()==1 && s.find_first_of("+-*/%") != std::string::npos))
+            return Token::eArithmeticalOp;
+        if (s.size() == 1 && s.find_first_of("&|^~") != std::string::npos)
+            return Token::eBitOp;
+        if (s == "&&" ||
+            s == "||" ||
+            s == "!")
+            return Token::eLogicalOp;
+        // A comparison, unless the token has a link (see update_property_info())
+        if (s == "==" ||
+            s == "!=" ||
+            s == "<"  ||
+            s == "<=" ||
+            s == ">"  ||
+            s == ">=")
+            return Token::eComparisonOp;
+        if (s == "++" ||
+            s == "--")
+            return Token::eIncDecOp;
+        if (s == "{" || s == "}")
+            return Token::eBracket;
+        return Token::eOther;
+    }
+
+    bool isStandardTypeString(const std::string &s)
+    {
+        static const char * const stdtype[] = {"int", "char", "bool", "long", "short", "float", "double", "wchar_t", "size_t", 0};
+        for (int i = 0; stdtype[i]; i++) {
+            if (s == stdtype[i])
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief The interned token strings, a hash table that grows. The
+     * tokens point to the symbols. The symbols that only tokens use are
+     * freed by reset().
+     */
+    class SymbolTable {
+    public:
+        SymbolTable() : _buckets(4096, static_cast<Token::Symbol *>(0)), _size(0), _count(0), _generation(0) {
+            // These get the same ids in every run
+            static const char * const fixed[] = {
+                "", "(", ")", "{", "}", "[", "]", ";", ",", ".", "::", "->",
+                "=", "==", "!=", "<", ">", "<=", ">=", "+", "-", "*", "/", "%",
+                "&", "|", "^", "~", "!", "&&", "||", "++", "--", "+=", "-=",
+                "*=", "/=", "%=", "&=", "|=", "^=", "<<", ">>", "<<=", ">>=",
+                "?", ":", "#", "0", "1",
+                "if", "else", "for", "while", "do", "switch", "case", "default",
+                "break", "continue", "return", "goto", "void", "char", "short",
+                "int", "long", "float", "double", "bool", "signed", "unsigned",
+                "const", "static", "extern", "struct", "class", "union", "enum",
+                "typedef", "sizeof", "new", "delete", "this", "true", "false",
+                "NULL", "public", "private", "protected", "virtual", "operator",
+                "template", "typename", "namespace", "using", "throw", "try",
+                "catch", "inline", "volatile", "std", "size_t", "wchar_t", 0
+            };
+            for (int i = 0; fixed[i]; ++i)
+                intern(fixed[i], hash(fixed[i]), true);
+        }
+
+        /**
+         * @param permanent the symbol is kept by reset(), the compiled
+         * patterns and Token::intern() need that
+         */
+        const Token::Symbol *intern(const std::string &s, std::size_t h, bool permanent) {
+            MutexLocker lock(_sync);
+            for (Token::Symbol *symbol = _buckets[h & (_buckets.size() - 1)]; symbol; symbol = symbol->nextInBucket) {
+                if (symbol->str == s) {
+                    if (permanent)
+                        symbol->permanent = true;
+                    return symbol;
+                }
+            }
+
+            Token::Symbol *symbol = new Token::Symbol;
+            symbol->str = s;
+            symbol->id = _count++;
+            symbol->type = stringType(s);
+            symbol->isStandardType = s.size() >= 3U && isStandardTypeString(s);
+            symbol->needsMultiCompare = s.empty() || s.find_first_of("| ") != std::string::npos;
+            symbol->permanent = permanent;
+            std::vector<Token::Symbol *>::reference bucket = _buckets[h & (_buckets.size() - 1)];
+            symbol->nextInBucket = bucket;
+            bucket = symbol;
+
+            if (++_size > _buckets.size())
+                grow();
+            return symbol;
+        }
+
+        /** Free the symbols that are not permanent, see Token::resetSymbols() */
+        void reset() {
+            MutexLocker lock(_sync);
+            for (std::vector<Token::Symbol *>::iterator it = _buckets.begin(); it != _buckets.end(); ++it) {
+                Token::Symbol **link = &*it;
+                while (*link) {
+                    Token::Symbol * const symbol = *link;
+                    if (symbol->permanent) {
+                        link = &symbol->nextInBucket;
+                    } else {
+                        *link = symbol->nextInBucket;
+                        delete symbol;
+                        --_size;
+                    }
+                }
+            }
+            ++_generation;
+        }
+
+        /** Number of resets, the front caches of the threads are cleared when it changes */
+        unsigned int generation() const {
+            return _generation;
+        }
+
+        static std::size_t hash(const std::string &s) {
+            // FNV-1a
+            std::size_t h = 2166136261U;
+            for (std::string::const_iterator it = s.begin(); it != s.end(); ++it)
+                h = (h ^ static_cast<unsigned char>(*it)) * 16777619U;
+            return h;
+        }
+
+    private:
+        void grow() {
+            std::vector<Token::Symbol *> buckets(_buckets.size() * 2, static_cast<Token::Symbol *>(0));
+            for (std::vector<Token::Symbol *>::const_iterator it = _buckets.begin(); it != _buckets.end(); ++it) {
+                Token::Symbol *symbol = *it;
+                while (symbol) {
+                    Token::Symbol * const next = symbol->nextInBucket;
+                    std::vector<Token::Symbol *>::reference bucket = buckets[hash(symbol->str) & (buckets.size() - 1)];
+                    symbol->nextInBucket = bucket;
+                    bucket = symbol;
+                    symbol = next;
+                }
+            }
+            _buckets.swap(buckets);
+        }
+
+        std::vector<Token::Symbol *> _buckets;
+
+        /** number of symbols in the table */
+        std::size_t _size;
+
+        /** number of symbols that have been created, the next id */
+        unsigned int _count;
+
+        unsigned int _generation;
+
+        /** the tokens of the checking threads are interned in one table */
+        Mutex _sync;
+    };
+
+    SymbolTable &symbolTable()
+    {
+        static SymbolTable table;
+        return table;
+    }
+
+    /** A permanent symbol, for the compiled patterns and Token::intern() */
+    const Token::Symbol *symbolOf(const std::string &s)
+    {
+        return symbolTable().intern(s, SymbolTable::hash(s), true);
+    }
+
+#if defined(_MSC_VER)
+#define CPPCHECK_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__)
+#define CPPCHECK_THREAD_LOCAL __thread
+#endif
+
+#ifdef CPPCHECK_THREAD_LOCAL
+    /**
+     * The symbols that the thread has looked up recently, by their hash.
+     * Most token strings are found here without taking the lock of the
+     * table.
+     */
+    enum { frontCacheSize = 1024 };
+    CPPCHECK_THREAD_LOCAL const Token::Symbol *frontCache[frontCacheSize];
+    CPPCHECK_THREAD_LOCAL unsigned int frontCacheGeneration;
+#endif
+
+    /** The symbol of the string of a token */
+    const Token::Symbol *tokenSymbol(const std::string &s)
+    {
+        SymbolTable &table = symbolTable();
+        const std::size_t h = SymbolTable::hash(s);
+#ifdef CPPCHECK_THREAD_LOCAL
+        if (frontCacheGeneration != table.generation()) {
+            std::fill(frontCache, frontCache + frontCacheSize, static_cast<const Token::Symbol *>(0));
+            frontCacheGeneration = table.generation();
+        }
+        const Token::Symbol *&entry = frontCache[h & (frontCacheSize - 1)];
+        if (!entry || entry->str != s)
+            entry = table.intern(s, h, false);
+        return entry;
+#else
+        return table.intern(s, h, false);
+#endif
+    }
+
+    // The table is created before main(), before there are threads
+    const Token::Symbol * const emptySymbol = symbolOf("");
+    const Token::Symbol * const deleteSymbol = symbolOf("delete");
+}
+
+const std::string &Token::intern(const std::string &s)
+{
+    return symbolOf(s)->str;
+}
+
+void Token::resetSymbols()
+{
+    symbolTable().reset();
+}
 
 Token::Token(Token **t) :
     tokensBack(t),
+    _allocator(0),
     _next(0),
     _previous(0),
     _link(0),
     _scope(0),
     _function(0), // Initialize whole union
-    _str(""),
+    _symbol(emptySymbol),
     _varId(0),
     _fileIndex(0),
     _linenr(0),
@@ -61,58 +313,25 @@ Token::~Token()
 
 void Token::update_property_info()
 {
-    if (!_str.empty()) {
-        if (_str == "true" || _str == "false")
-            _type = eBoolean;
-        else if (_str[0] == '_' || std::isalpha(_str[0])) { // Name
-            if (_varId)
-                _type = eVariable;
-            else if (_type != eVariable && _type != eFunction && _type != eType)
-                _type = eName;
-        } else if (std::isdigit(_str[0]) || (_str.length() > 1 && _str[0] == '-' && std::isdigit(_str[1])))
-            _type = eNumber;
-        else if (_str.length() > 1 && _str[0] == '"' && _str[_str.length()-1] == '"')
-            _type = eString;
-        else if (_str.length() > 1 && _str[0] == '\'' && _str[_str.length()-1] == '\'')
-            _type = eChar;
-        else if (_str == "="   ||
-                 _str == "+="  ||
-                 _str == "-="  ||
-                 _str == "*="  ||
-                 _str == "/="  ||
-                 _str == "%="  ||
-                 _str == "&="  ||
-                 _str == "^="  ||
-                 _str == "|="  ||
-                 _str == "<<=" ||
-                 _str == ">>=")
-            _type = eAssignmentOp;
-        else if (_str.size() == 1 && _str.find_first_of(",[]()?:") != std::string::npos)
-            _type = eExtendedOp;
-        else if (_str=="<<" || _str==">>" || (_str.size()==1 && _str.find_first_of("+-*/%") != std::string::npos))
-            _type = eArithmeticalOp;
-        else if (_str.size() == 1 && _str.find_first_of("&|^~") != std::string::npos)
-            _type = eBitOp;
-        else if (_str == "&&" ||
-                 _str == "||" ||
-                 _str == "!")
-            _type = eLogicalOp;
-        else if ((_str == "==" ||
-                  _str == "!=" ||
-                  _str == "<"  ||
-                  _str == "<=" ||
-                  _str == ">"  ||
-                  _str == ">=") && !_link)
+    // The type of the string is known when it is interned, only names and
+    // the comparison operators depend on the varId and link
+    switch (_symbol->type) {
+    case eName:
+        if (_varId)
+            _type = eVariable;
+        else if (_type != eVariable && _type != eFunction && _type != eType)
+            _type = eName;
+        break;
+    case eComparisonOp:
+        if (!_link)
             _type = eComparisonOp;
-        else if (_str == "++" ||
-                 _str == "--")
-            _type = eIncDecOp;
-        else if (_str.size() == 1 && (_str.find_first_of("{}") != std::string::npos || (_link && _str.find_first_of("<>") != std::string::npos)))
-            _type = eBracket;
+        else if (_symbol->str.size() == 1U)
+            _type = eBracket;  // < > of a template
         else
             _type = eOther;
-    } else {
-        _type = eNone;
+        break;
+    default:
+        _type = _symbol->type;
     }
 
     update_property_isStandardType();
@@ -120,19 +339,9 @@ void Token::update_property_info()
 
 void Token::update_property_isStandardType()
 {
-    _isStandardType = false;
-
-    if (_str.size() < 3)
-        return;
-
-    static const char * const stdtype[] = {"int", "char", "bool", "long", "short", "float", "double", "wchar_t", "size_t", 0};
-    for (int i = 0; stdtype[i]; i++) {
-        if (_str == stdtype[i]) {
-            _isStandardType = true;
-            _type = eType;
-            break;
-        }
-    }
+    _isStandardType = _symbol->isStandardType;
+    if (_isStandardType)
+        _type = eType;
 }
 
 
@@ -140,8 +349,9 @@ bool Token::isUpperCaseName() const
 {
     if (!isName())
         return false;
-    for (unsigned int i = 0; i < _str.length(); ++i) {
-        if (std::islower(_str[i]))
+    const std::string &s = _symbol->str;
+    for (unsigned int i = 0; i < s.length(); ++i) {
+        if (std::islower(s[i]))
             return false;
     }
     return true;
@@ -149,7 +359,7 @@ bool Token::isUpperCaseName() const
 
 void Token::str(const std::string &s)
 {
-    _str = s;
+    _symbol = tokenSymbol(s);
     _varId = 0;
 
     update_property_info();
@@ -157,8 +367,9 @@ void Token::str(const std::string &s)
 
 void Token::concatStr(std::string const& b)
 {
-    _str.erase(_str.length() - 1);
-    _str.append(b.begin() + 1, b.end());
+    std::string s(_symbol->str, 0, _symbol->str.length() - 1);
+    s.append(b.begin() + 1, b.end());
+    _symbol = tokenSymbol(s);
 
     update_property_info();
 }
@@ -166,7 +377,7 @@ void Token::concatStr(std::string const& b)
 std::string Token::strValue() const
 {
     assert(_type == eString);
-    return _str.substr(1, _str.length() - 2);
+    return _symbol->str.substr(1, _symbol->str.length() - 2);
 }
 
 void Token::deleteNext(unsigned long index)
@@ -174,7 +385,7 @@ void Token::deleteNext(unsigned long index)
     while (_next && index--) {
         Token *n = _next;
         _next = n->next();
-        delete n;
+        TokenAllocator::deleteToken(n);
     }
 
     if (_next)
@@ -186,7 +397,7 @@ void Token::deleteNext(unsigned long index)
 void Token::deleteThis()
 {
     if (_next) { // Copy next to this and delete next
-        _str = _next->_str;
+        _symbol = _next->_symbol;
         _type = _next->_type;
         _isUnsigned = _next->_isUnsigned;
         _isSigned = _next->_isSigned;
@@ -207,7 +418,7 @@ void Token::deleteThis()
 
         deleteNext();
     } else if (_previous && _previous->_previous) { // Copy previous to this and delete previous
-        _str = _previous->_str;
+        _symbol = _previous->_symbol;
         _type = _previous->_type;
         _isUnsigned = _previous->_isUnsigned;
         _isSigned = _previous->_isSigned;
@@ -230,7 +441,7 @@ void Token::deleteThis()
         _previous = _previous->_previous;
         _previous->_next = this;
 
-        delete toDelete;
+        TokenAllocator::deleteToken(toDelete);
     } else {
         // We are the last token in the list, we can't delete
         // ourselves, so just make us empty
@@ -268,7 +479,7 @@ void Token::replace(Token *replaceThis, Token *start, Token *end)
         tok->_progressValue = replaceThis->_progressValue;
 
     // Delete old token, which is replaced
-    delete replaceThis;
+    TokenAllocator::deleteToken(replaceThis);
 }
 
 const Token *Token::tokAt(int index) const
@@ -299,7 +510,7 @@ const std::string &Token::strAt(int index) const
     static const std::string empty_str;
 
     const Token *tok = this->tokAt(index);
-    return tok ? tok->_str : empty_str;
+    return tok ? tok->_symbol->str : empty_str;
 }
 
 static int multiComparePercent(const Token *tok, const char * * haystack_p,
@@ -453,7 +664,7 @@ bool Token::simpleMatch(const Token *tok, const char pattern[])
     while (*current) {
         std::size_t length = static_cast<std::size_t>(next - current);
 
-        if (!tok || length != tok->_str.length() || std::strncmp(current, tok->_str.c_str(), length))
+        if (!tok || length != tok->_symbol->str.length() || std::strncmp(current, tok->_symbol->str.c_str(), length))
             return false;
 
         current = next;
@@ -526,7 +737,7 @@ int Token::firstWordLen(const char *str)
     ismulticomp = false;                        \
 }
 
-bool Token::Match(const Token *tok, const char pattern[], unsigned int varid)
+bool Token::interpretMatch(const Token *tok, const char pattern[], unsigned int varid)
 {
     const char *p = pattern;
     bool ismulticomp = false;
@@ -706,7 +917,7 @@ bool Token::Match(const Token *tok, const char pattern[], unsigned int varid)
 
         // Parse multi options, such as void|int|char (accept token which is one of these 3)
         else if (chrInFirstWord(p, '|') && (p[0] != '|' || firstWordLen(p) > 2)) {
-            int res = multiCompare(tok, p, tok->_str.c_str());
+            int res = multiCompare(tok, p, tok->_symbol->str.c_str());
             if (res == 0) {
                 // Empty alternative matches, use the same token on next round
                 while (*p && *p != ' ')
@@ -727,7 +938,7 @@ bool Token::Match(const Token *tok, const char pattern[], unsigned int varid)
                 ++p;
         }
 
-        else if (!firstWordEquals(p, tok->_str.c_str())) {
+        else if (!firstWordEquals(p, tok->_symbol->str.c_str())) {
             return false;
         }
 
@@ -741,6 +952,472 @@ bool Token::Match(const Token *tok, const char pattern[], unsigned int varid)
     return true;
 }
 
+/**
+ * @brief A Match() pattern compiled into steps, one or more for each
+ * word of the pattern. The strings are resolved to interned symbols, so
+ * a step compares pointers instead of characters.
+ *
+ * The programs are cached by the address of the pattern and are never
+ * freed. Match() only compiles string literals. findmatch() also gets
+ * patterns that are built at runtime, so it compares the pattern to the
+ * text of the program first.
+ */
+class Token::MatchProgram {
+public:
+    /**
+     * @brief The cached program for the pattern at this address
+     * @return the program, or 0 if the cache is full
+     */
+    static const MatchProgram *get(const char pattern[]);
+
+    /** Same as interpretMatch() with the pattern of the program */
+    bool match(const Token *tok, unsigned int varid) const;
+
+    bool isCompiledFrom(const char pattern[]) const {
+        return std::strcmp(pattern, _text.c_str()) == 0;
+    }
+
+    /**
+     * A cheap isCompiledFrom() for Match(): compares the length and the
+     * first and last characters of the pattern in an array of @p size
+     * chars.
+     */
+    bool fits(const char pattern[], std::size_t size) const {
+        const std::size_t len = _text.size();
+        return len < size && pattern[len] == '\0' &&
+               (len == 0 || (pattern[0] == _text[0] && pattern[len - 1] == _text[len - 1]));
+    }
+
+private:
+    explicit MatchProgram(const char pattern[]);
+
+    enum Opcode {
+        opLiteral, opNot, opCharClass, opMulti, opRawMulti,
+        opName, opType, opNumber, opChar, opConstOp, opComparisonOp,
+        opString, opBoolean, opOp, opAny, opVarId, opAbort
+    };
+
+    /** What to do when a %cmd% step does not match the token */
+    enum Failure {
+        failReject,     ///< the pattern does not match
+        failSkip,       ///< "%cmd%|", the next word is compared to the same token
+        failNext        ///< "%cmd%|alternative", try the next step
+    };
+
+    struct Step {
+        Step() : opcode(opLiteral), failure(failReject), symbol(0), matchOp(false), matchConstOp(false),
+            emptyAlternative(false), closingBracket(false), begin(0), matchesNoToken(false), nextWord(0) {
+        }
+
+        Opcode opcode;
+        Failure failure;
+
+        /** opLiteral, opNot: the string */
+        const Symbol *symbol;
+
+        /** opMulti: the alternatives that are strings, %op% and %cop% and if there is an empty one */
+        std::vector<const Symbol *> alternatives;
+        bool matchOp;
+        bool matchConstOp;
+        bool emptyAlternative;
+
+        /** opCharClass: the characters */
+        std::string text;
+
+        /** opCharClass: "]" is one of the characters */
+        bool closingBracket;
+
+        /**
+         * opMulti, opRawMulti: offset of the word in the pattern, for
+         * multiCompare(). It can read past the end of the word when the
+         * string of the token contains a space.
+         */
+        std::size_t begin;
+
+        /** The word starts with "!!", it matches when there are no more tokens */
+        bool matchesNoToken;
+
+        /** Index of the first step of the next word */
+        std::size_t nextWord;
+    };
+
+    void compileWord(const char *p, const char *end);
+    void compilePercent(const char *p, const char *end);
+    void compileMulti(const std::string &word, std::size_t begin);
+
+    /** Make the program visible to the other threads after it is complete */
+    static void publish(const MatchProgram * volatile &slot, const MatchProgram *program);
+
+    /** Read a slot, the program is complete if publish() wrote it */
+    static const MatchProgram *acquire(const MatchProgram * volatile &slot);
+
+    const char *_address;
+    const std::string _text;
+    std::vector<Step> _steps;
+
+    /**
+     * The cache, a hash table with linear probing. A slot is written only
+     * once, under the mutex, so it can be read without locking.
+     */
+    enum { cacheSize = 1 << 14, cacheLimit = cacheSize / 4 * 3 };
+    static const MatchProgram * volatile _cache[cacheSize];
+    static unsigned int _cacheCount;
+    static Mutex _cacheSync;
+};
+
+const Token::MatchProgram * volatile Token::MatchProgram::_cache[Token::MatchProgram::cacheSize];
+unsigned int Token::MatchProgram::_cacheCount = 0;
+Mutex Token::MatchProgram::_cacheSync;
+
+void Token::MatchProgram::publish(const MatchProgram * volatile &slot, const MatchProgram *program)
+{
+#if defined(_MSC_VER)
+    MemoryBarrier();
+    slot = program;
+#elif defined(__GNUC__)
+    __atomic_store_n(&slot, program, __ATOMIC_RELEASE);
+#else
+    slot = program;
+#endif
+}
+
+const Token::MatchProgram *Token::MatchProgram::acquire(const MatchProgram * volatile &slot)
+{
+#if defined(_MSC_VER)
+    const MatchProgram * const program = slot;
+    MemoryBarrier();
+    return program;
+#elif defined(__GNUC__)
+    return __atomic_load_n(&slot, __ATOMIC_ACQUIRE);
+#else
+    return slot;
+#endif
+}
+
+const Token::MatchProgram *Token::MatchProgram::get(const char pattern[])
+{
+    std::size_t slot = (reinterpret_cast<std::size_t>(pattern) >> 2) * 2654435761U;
+    for (;; ++slot) {
+        const MatchProgram * const program = acquire(_cache[slot & (cacheSize - 1)]);
+        if (!program)
+            break;
+        if (program->_address == pattern)
+            return program;
+    }
+
+    MutexLocker lock(_cacheSync);
+
+    // Another thread may have compiled it after the lookup
+    while (_cache[slot & (cacheSize - 1)]) {
+        if (_cache[slot & (cacheSize - 1)]->_address == pattern)
+            return _cache[slot & (cacheSize - 1)];
+        ++slot;
+    }
+    if (_cacheCount >= cacheLimit)
+        return 0;
+
+    const MatchProgram * const program = new MatchProgram(pattern);
+    publish(_cache[slot & (cacheSize - 1)], program);
+    ++_cacheCount;
+    return program;
+}
+
+Token::MatchProgram::MatchProgram(const char pattern[]) :
+    _address(pattern),
+    _text(pattern)
+{
+    const char *p = _text.c_str();
+    for (;;) {
+        while (*p == ' ')
+            ++p;
+        if (*p == '\0')
+            break;
+
+        const char *end = p;
+        while (*end && *end != ' ')
+            ++end;
+
+        const std::size_t first = _steps.size();
+        compileWord(p, end);
+        _steps[first].matchesNoToken = (p[0] == '!' && p[1] == '!' && p[2] != '\0');
+        for (std::size_t i = first; i < _steps.size(); ++i)
+            _steps[i].nextWord = _steps.size();
+
+        p = end;
+    }
+}
+
+void Token::MatchProgram::compileWord(const char *p, const char *end)
+{
+    if (*p == '%') {
+        compilePercent(p, end);
+        return;
+    }
+
+    // The same order of checks as in interpretMatch()
+    const std::string word(p, end);
+    Step step;
+    if (word[0] == '[' && word.find(']') != std::string::npos) {
+        step.opcode = opCharClass;
+        unsigned int closingBrackets = 0;
+        for (std::string::size_type i = 1; i < word.size(); ++i) {
+            if (word[i] == ']')
+                ++closingBrackets;
+            else
+                step.text += word[i];
+        }
+        step.closingBracket = closingBrackets > 1;
+    } else if (word.find('|') != std::string::npos && (word[0] != '|' || word.size() > 2)) {
+        compileMulti(word, static_cast<std::size_t>(p - _text.c_str()));
+        return;
+    } else if (word.compare(0, 2, "!!") == 0 && p[2] != '\0') {
+        step.opcode = opNot;
+        step.symbol = symbolOf(word.substr(2));
+    } else {
+        step.symbol = symbolOf(word);
+    }
+    _steps.push_back(step);
+}
+
+void Token::MatchProgram::compilePercent(const char *p, const char *end)
+{
+    Step step;
+    const char *next;
+    ++p;
+    switch (p[0]) {
+    case '\0':
+    case ' ':
+    case '|':
+        step.symbol = symbolOf("%");
+        next = p;
+        break;
+    case 'v':
+        if (p[3] == '%') {
+            step.opcode = opName;
+            next = p + 4;
+        } else {
+            // %varid% has no alternatives
+            step.opcode = opVarId;
+            _steps.push_back(step);
+            return;
+        }
+        break;
+    case 't':
+        step.opcode = opType;
+        next = p + 5;
+        break;
+    case 'a':
+        // %any% matches, the alternatives are ignored
+        step.opcode = opAny;
+        _steps.push_back(step);
+        return;
+    case 'n':
+        step.opcode = opNumber;
+        next = p + 4;
+        break;
+    case 'c':
+        ++p;
+        if (p[0] == 'h') {
+            step.opcode = opChar;
+            next = p + 4;
+        } else if (p[1] == 'p') {
+            step.opcode = opConstOp;
+            next = p + 3;
+        } else {
+            step.opcode = opComparisonOp;
+            next = p + 4;
+        }
+        break;
+    case 's':
+        step.opcode = opString;
+        next = p + 4;
+        break;
+    case 'b':
+        step.opcode = opBoolean;
+        next = p + 5;
+        break;
+    case 'o':
+        ++p;
+        if (p[1] == '%') {
+            if (p[0] == 'p')
+                step.opcode = opOp;
+            else
+                step.symbol = symbolOf("|");
+            next = p + 2;
+        } else {
+            step.symbol = symbolOf("||");
+            next = p + 4;
+        }
+        break;
+    default:
+        // unknown %cmd%, abort when it is used like interpretMatch() does
+        step.opcode = opAbort;
+        _steps.push_back(step);
+        return;
+    }
+
+    if (next < end && *next == '|') {
+        ++next;
+        step.failure = (next < end) ? failNext : failSkip;
+    }
+    _steps.push_back(step);
+    if (step.failure == failNext)
+        compileWord(next, end);
+}
+
+void Token::MatchProgram::compileMulti(const std::string &word, std::size_t begin)
+{
+    Step step;
+    step.opcode = opMulti;
+    step.begin = begin;
+
+    std::string::size_type start = 0;
+    bool afterPercent = false;
+    for (;;) {
+        const std::string::size_type bar = word.find('|', start);
+        const std::string alternative = word.substr(start, bar - start);
+        if (alternative.empty()) {
+            step.emptyAlternative = true;
+            afterPercent = false;
+        } else if (alternative[0] == '%' && alternative.size() > 1 && !afterPercent) {
+            // multiCompare() compares the alternative after a %cmd% as a string
+            afterPercent = true;
+            if (alternative == "%op%")
+                step.matchOp = true;
+            else if (alternative == "%cop%")
+                step.matchConstOp = true;
+            else if (alternative != "%or%" && alternative != "%oror%")
+                step.opcode = opRawMulti;
+            // %or% and %oror% only match strings that need multiCompare()
+        } else {
+            step.alternatives.push_back(symbolOf(alternative));
+            afterPercent = false;
+        }
+
+        if (bar == std::string::npos)
+            break;
+        start = bar + 1;
+    }
+    _steps.push_back(step);
+}
+
+bool Token::MatchProgram::match(const Token *tok, unsigned int varid) const
+{
+    std::size_t word = 0;
+    while (word < _steps.size()) {
+        const Step *step = &_steps[word];
+        if (!tok) {
+            // If we have no tokens, pattern "!!else" should return true
+            if (!step->matchesNoToken)
+                return false;
+            word = step->nextWord;
+            continue;
+        }
+
+        // 1: the token matches, 0: compare the next word to the same token, -1: no match
+        int res;
+        for (;;) {
+            switch (step->opcode) {
+            case opLiteral:
+                res = (tok->_symbol == step->symbol) ? 1 : -1;
+                break;
+            case opNot:
+                res = (tok->_symbol == step->symbol) ? -1 : 1;
+                break;
+            case opCharClass:
+                if (tok->_symbol->str.length() != 1)
+                    res = -1;
+                else if (tok->_symbol->str[0] == ']')
+                    res = step->closingBracket ? 1 : -1;
+                else
+                    res = (step->text.find(tok->_symbol->str[0]) != std::string::npos) ? 1 : -1;
+                break;
+            case opMulti:
+                if (tok->_symbol->needsMultiCompare)
+                    res = multiCompare(tok, _text.c_str() + step->begin, tok->_symbol->str.c_str());
+                else if ((step->matchOp && tok->isOp()) ||
+                         (step->matchConstOp && tok->isConstOp()) ||
+                         std::find(step->alternatives.begin(), step->alternatives.end(), tok->_symbol) != step->alternatives.end())
+                    res = 1;
+                else
+                    res = step->emptyAlternative ? 0 : -1;
+                break;
+            case opRawMulti:
+                res = multiCompare(tok, _text.c_str() + step->begin, tok->_symbol->str.c_str());
+                break;
+            case opName:
+                res = tok->isName() ? 1 : -1;
+                break;
+            case opType:
+                res = (tok->isName() && tok->varId() == 0 && tok->_symbol != deleteSymbol) ? 1 : -1;
+                break;
+            case opNumber:
+                res = tok->isNumber() ? 1 : -1;
+                break;
+            case opChar:
+                res = (tok->type() == eChar) ? 1 : -1;
+                break;
+            case opConstOp:
+                res = tok->isConstOp() ? 1 : -1;
+                break;
+            case opComparisonOp:
+                res = tok->isComparisonOp() ? 1 : -1;
+                break;
+            case opString:
+                res = (tok->type() == eString) ? 1 : -1;
+                break;
+            case opBoolean:
+                res = tok->isBoolean() ? 1 : -1;
+                break;
+            case opOp:
+                res = tok->isOp() ? 1 : -1;
+                break;
+            case opAny:
+                res = 1;
+                break;
+            case opVarId:
+                if (varid == 0)
+                    throw InternalError(tok, "Internal error. Token::Match called with varid 0. Please report this to Cppcheck developers");
+                res = (tok->varId() == varid) ? 1 : -1;
+                break;
+            default:
+                std::abort();
+            }
+
+            if (res != -1 || step->failure == failReject)
+                break;
+            if (step->failure == failSkip) {
+                res = 0;
+                break;
+            }
+            ++step;
+        }
+
+        if (res == -1)
+            return false;
+        if (res == 1)
+            tok = tok->next();
+        word = step->nextWord;
+    }
+    return true;
+}
+
+bool Token::compiledMatch(const Token *tok, const char pattern[], std::size_t size, unsigned int varid)
+{
+    const MatchProgram * const program = MatchProgram::get(pattern);
+
+    // The programs are cached by the address of the pattern. A pattern in
+    // a local array can get the address of another pattern, so release
+    // builds compare it to the program too.
+    if (program && program->fits(pattern, size)) {
+        assert(program->isCompiledFrom(pattern));
+        return program->match(tok, varid);
+    }
+
+    // The cache is full or the address was reused
+    return interpretMatch(tok, pattern, varid);
+}
+
 std::size_t Token::getStrLength(const Token *tok)
 {
     assert(tok != NULL);
@@ -831,7 +1508,7 @@ Token* Token::nextArgument() const
 
 bool Token::findClosingBracket(const Token*& closing) const
 {
-    if (_str == "<") {
+    if (_symbol->str == "<") {
         unsigned int depth = 0;
         for (closing = this; closing != NULL; closing = closing->next()) {
             if (closing->str() == "{" || closing->str() == "[" || closing->str() == "(")
@@ -877,17 +1554,23 @@ const Token *Token::findsimplematch(const Token *tok, const char pattern[], cons
 
 const Token *Token::findmatch(const Token *tok, const char pattern[], unsigned int varId)
 {
-    for (; tok; tok = tok->next()) {
-        if (Token::Match(tok, pattern, varId))
-            return tok;
-    }
-    return 0;
+    return findmatch(tok, pattern, 0, varId);
 }
 
 const Token *Token::findmatch(const Token *tok, const char pattern[], const Token *end, unsigned int varId)
 {
+    // Compare the pattern to the program once, not for every token
+    const MatchProgram * const program = MatchProgram::get(pattern);
+    if (program && program->isCompiledFrom(pattern)) {
+        for (; tok && tok != end; tok = tok->next()) {
+            if (program->match(tok, varId))
+                return tok;
+        }
+        return 0;
+    }
+
     for (; tok && tok != end; tok = tok->next()) {
-        if (Token::Match(tok, pattern, varId))
+        if (Token::interpretMatch(tok, pattern, varId))
             return tok;
     }
     return 0;
@@ -901,10 +1584,10 @@ void Token::insertToken(const std::string &tokenStr, bool prepend)
     if (prepend && !this->previous())
         return;
 
-    if (_str.empty())
+    if (_symbol->str.empty())
         newToken = this;
     else
-        newToken = new Token(tokensBack);
+        newToken = _allocator ? _allocator->create(tokensBack) : new Token(tokensBack);
     newToken->str(tokenStr);
     newToken->_linenr = _linenr;
     newToken->_fileIndex = _fileIndex;
@@ -976,14 +1659,15 @@ void Token::stringify(std::ostream& os, bool varid, bool attributes) const
         if (isLong())
             os << "long ";
     }
-    if (_str[0] != '\"' || _str.find("\0") == std::string::npos)
-        os << _str;
+    const std::string &s = _symbol->str;
+    if (s[0] != '\"' || s.find("\0") == std::string::npos)
+        os << s;
     else {
-        for (std::size_t i = 0U; i < _str.size(); ++i) {
-            if (_str[i] == '\0')
+        for (std::size_t i = 0U; i < s.size(); ++i) {
+            if (s[i] == '\0')
                 os << "\\0";
             else
-                os << _str[i];
+                os << s[i];
         }
     }
     if (varid && _varId != 0)
@@ -1086,20 +1770,20 @@ void Token::astHandleParentheses()
 {
     // Assumptions:
     // * code is valid
-    // * _str is one of: ( ) ]
+    // * str() is one of: ( ) ]
 
     Token *innerTop;
     if (Token::Match(this, ")|]"))
         innerTop = _previous;
-    else if (_next && _next->_str == ")")
+    else if (_next && _next->_symbol->str == ")")
         return;
-    else  // _str = "("
+    else  // str() = "("
         innerTop = _next;
     while (innerTop->_astParent)
         innerTop = innerTop->_astParent;
 
     if (_astParent) {
-        if (_str == "(" && _astParent->_astOperand2 != NULL)
+        if (_symbol->str == "(" && _astParent->_astOperand2 != NULL)
             _astParent->_astOperand2 = innerTop;
         else
             _astParent->_astOperand1 = innerTop;
@@ -19,6 +19,7 @@
 #ifndef TokenH
 #define TokenH
 
+#include <cstddef>
 #include <string>
 #include <vector>
 #include <ostream>
@@ -27,6 +28,7 @@
 class Scope;
 class Function;
 class Variable;
+class TokenAllocator;
 
 /// @addtogroup Core
 /// @{
@@ -45,6 +47,10 @@ class CPPCHECKLIB Token {
 private:
     Token **tokensBack;
 
+    /** The allocator of the token list, 0 if the token was created with new */
+    TokenAllocator *_allocator;
+    friend class TokenAllocator;
+
     // Not implemented..
     Token();
     Token(const Token &);
@@ -60,9 +66,59 @@ public:
         eNone
     };
 
+    /**
+     * @brief An interned token string. All tokens with the same string
+     * share one Symbol, so comparing the strings of two tokens is
+     * comparing two pointers.
+     */
+    struct Symbol {
+        std::string str;
+
+        /**
+         * Number of the string. The common keywords and operators are
+         * interned first, so their numbers are the same in every run.
+         */
+        unsigned int id;
+
+        /** Type of a token with this string, without a link or varId */
+        Type type;
+
+        bool isStandardType;
+
+        /**
+         * The string is empty or contains '|' or ' ', so multiCompare()
+         * must compare it character by character to a pattern.
+         */
+        bool needsMultiCompare;
+
+        /**
+         * The symbol is used by a compiled pattern or was returned by
+         * intern(), resetSymbols() does not free it
+         */
+        bool permanent;
+
+        /** Next symbol in the same bucket of the symbol table */
+        Symbol *nextInBucket;
+    };
+
     explicit Token(Token **tokensBack);
     ~Token();
 
+    /**
+     * @brief The interned copy of a string. A token has this string if
+     * and only if &tok->str() == &Token::intern(s). The strings returned
+     * by intern() are not freed by resetSymbols().
+     */
+    static const std::string &intern(const std::string &s);
+
+    /**
+     * @brief Free the interned strings that only tokens have used. There
+     * must be no tokens, and no other thread may create tokens during the
+     * call. The executors call this between files, and the server between
+     * its requests.
+     */
+    static void resetSymbols();
+
     void str(const std::string &s);
 
     /**
@@ -72,7 +128,15 @@ public:
     void concatStr(std::string const& b);
 
     const std::string &str() const {
-        return _str;
+        return _symbol->str;
+    }
+
+    /**
+     * @brief Number of the string, the same for all tokens with the same
+     * string. The unit tests use it to tell the symbols apart.
+     */
+    unsigned int strId() const {
+        return _symbol->id;
     }
 
     /**
@@ -162,6 +226,13 @@ public:
      * "const" or "void" and token after that is '{'. If even one of the tokens does not
      * match its pattern, false is returned.
      *
+     * A string literal pattern is compiled the first time it is used, and
+     * the compiled program is cached by the address of the literal. Other
+     * patterns are interpreted, see DynamicPattern. A const array that is
+     * given as pattern should be static: the address of a local array is
+     * reused for other data, and a pattern that does not fit the cached
+     * program is interpreted.
+     *
      * @param tok List of tokens to be compared to the pattern
      * @param pattern The pattern against which the tokens are compared,
      * e.g. "const" or ") const|volatile| {".
@@ -170,7 +241,39 @@ public:
      * @return true if given token matches with given pattern
      *         false if given token does not match with given pattern
      */
-    static bool Match(const Token *tok, const char pattern[], unsigned int varid = 0);
+    template<std::size_t N>
+    static bool Match(const Token *tok, const char (&pattern)[N], unsigned int varid = 0) {
+        return compiledMatch(tok, pattern, N, varid);
+    }
+
+    /**
+     * @brief A pattern that is not a string literal, e.g. from
+     * std::string::c_str(). The text at its address can change, so it
+     * is not compiled.
+     */
+    class DynamicPattern {
+    public:
+        DynamicPattern(const char pattern[]) : str(pattern) {
+        }
+        const char *str;
+    };
+
+    /** Match() for a pattern that is built at runtime */
+    static bool Match(const Token *tok, const DynamicPattern &pattern, unsigned int varid = 0) {
+        return interpretMatch(tok, pattern.str, varid);
+    }
+
+    /** Match() for a pattern in a char array, it can change */
+    template<std::size_t N>
+    static bool Match(const Token *tok, char (&pattern)[N], unsigned int varid = 0) {
+        return interpretMatch(tok, pattern, varid);
+    }
+
+    /**
+     * Same as Match(), but the pattern is parsed character by character
+     * on every call instead of being compiled.
+     */
+    static bool interpretMatch(const Token *tok, const char pattern[], unsigned int varid = 0);
 
     /**
      * Return length of C-string.
@@ -430,7 +533,7 @@ public:
      */
     void link(Token *linkToToken) {
         _link = linkToToken;
-        if (_str == "<" || _str == ">")
+        if (_symbol->type == eComparisonOp && _symbol->str.size() == 1U)
             update_property_info();
     }
 
@@ -586,6 +689,12 @@ private:
      */
     static int firstWordLen(const char *str);
 
+    /** A compiled Match() pattern */
+    class MatchProgram;
+    friend class MatchProgram;
+
+    /** Match() with the cached program of a string literal, @p size is the size of the array */
+    static bool compiledMatch(const Token *tok, const char pattern[], std::size_t size, unsigned int varid);
 
     Token *_next;
     Token *_previous;
@@ -598,7 +707,7 @@ private:
         const Variable *_variable;
     };
 
-    std::string _str;
+    const Symbol *_symbol;
     unsigned int _varId;
     unsigned int _fileIndex;
     unsigned int _linenr;
@@ -619,7 +728,7 @@ private:
     bool _isExpandedMacro;
 
     /** Updates internal property cache like _isName or _isBoolean.
-        Called after any _str() modification. */
+        Called after any str() modification. */
     void update_property_info();
 
     /** Update internal property cache about isStandardType() */
@@ -654,7 +763,7 @@ public:
             ret = _astOperand1->astString();
         if (_astOperand2)
             ret += _astOperand2->astString();
-        return ret+_str;
+        return ret+_symbol->str;
     }
 };
 
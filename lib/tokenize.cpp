@@ -26,9 +26,12 @@
 #include "symboldatabase.h"
 #include "templatesimplifier.h"
 #include "timer.h"
+#include "mutex.h"
+#include "resultscache.h"
 
 #include <cstring>
 #include <sstream>
+#include <iterator>
 #include <cassert>
 #include <cctype>
 #include <stack>
@@ -41,6 +44,7 @@ Tokenizer::Tokenizer() :
     _errorLogger(0),
     _symbolDatabase(0),
     _varId(0),
+    _unnamedCount(0),
     _codeWithTemplates(false), //is there any templates?
     m_timerResults(NULL)
 {
@@ -52,6 +56,7 @@ Tokenizer::Tokenizer(const Settings *settings, ErrorLogger *errorLogger) :
     _errorLogger(errorLogger),
     _symbolDatabase(0),
     _varId(0),
+    _unnamedCount(0),
     _codeWithTemplates(false), //is there any templates?
     m_timerResults(NULL)
 {
@@ -62,6 +67,13 @@ Tokenizer::Tokenizer(const Settings *settings, ErrorLogger *errorLogger) :
 Tokenizer::~Tokenizer()
 {
     delete _symbolDatabase;
+
+    if (m_timerResults) {
+        const TokenAllocator &allocator = list.allocator();
+        m_timerResults->AddCount("TokenAllocator: tokens created", allocator.created());
+        m_timerResults->AddCount("TokenAllocator: tokens in the memory of deleted tokens", allocator.reused());
+        m_timerResults->AddCount("TokenAllocator: slabs", allocator.slabs());
+    }
 }
 
 
@@ -367,7 +379,7 @@ struct Space {
     bool isNamespace;
 };
 
-static Token *splitDefinitionFromTypedef(Token *tok)
+static Token *splitDefinitionFromTypedef(Token *tok, unsigned int *unnamedCount)
 {
     Token *tok1;
     std::string name;
@@ -386,8 +398,7 @@ static Token *splitDefinitionFromTypedef(Token *tok)
             if (Token::Match(tok1->next(), "%type%"))
                 name = tok1->next()->str();
             else { // create a unique name
-                static unsigned int count = 0;
-                name = "Unnamed" + MathLib::longToString(count++);
+                name = "Unnamed" + MathLib::longToString((*unnamedCount)++);
             }
             tok->next()->insertToken(name);
         } else
@@ -549,7 +560,7 @@ void Tokenizer::simplifyTypedef()
         // use typedef name for unnamed struct, union, enum or class
         if (Token::Match(tok->next(), "const| struct|enum|union|class %type% {") ||
             Token::Match(tok->next(), "const| struct|enum|union|class {")) {
-            Token *tok1 = splitDefinitionFromTypedef(tok);
+            Token *tok1 = splitDefinitionFromTypedef(tok, &_unnamedCount);
             if (!tok1)
                 continue;
             tok = tok1;
@@ -558,7 +569,7 @@ void Tokenizer::simplifyTypedef()
             while (tok1 && tok1->str() != ";" && tok1->str() != "{")
                 tok1 = tok1->next();
             if (tok1 && tok1->str() == "{") {
-                tok1 = splitDefinitionFromTypedef(tok);
+                tok1 = splitDefinitionFromTypedef(tok, &_unnamedCount);
                 if (!tok1)
                     continue;
                 tok = tok1;
@@ -1554,7 +1565,18 @@ void Tokenizer::simplifyMulAndParens()
 
 bool Tokenizer::tokenize(std::istream &code,
                          const char FileName[],
-                         const std::string &configuration)
+                         const std::string &configuration,
+                         std::string *snapshot)
+{
+    const std::string buffer((std::istreambuf_iterator<char>(code)), std::istreambuf_iterator<char>());
+    return tokenize(buffer.data(), buffer.size(), FileName, configuration, snapshot);
+}
+
+bool Tokenizer::tokenize(const char code[],
+                         std::size_t size,
+                         const char FileName[],
+                         const std::string &configuration,
+                         std::string *snapshot)
 {
     // make sure settings specified
     assert(_settings);
@@ -1564,7 +1586,7 @@ bool Tokenizer::tokenize(std::istream &code,
 
     _configuration = configuration;
 
-    if (!list.createTokens(code, Path::getRelativePath(Path::simplifyPath(FileName), _settings->_basePaths))) {
+    if (!list.createTokens(code, size, Path::getRelativePath(Path::simplifyPath(FileName), _settings->_basePaths))) {
         cppcheckError(0);
         return false;
     }
@@ -1967,8 +1989,57 @@ bool Tokenizer::tokenize(std::istream &code,
     if (!validate())
         return false;
 
+    // The snapshot is taken before the symbol database changes the tokens.
+    // The members that tokenize() sets are saved before the tokens.
+    if (snapshot) {
+        snapshot->append(reinterpret_cast<const char *>(&_varId), sizeof(_varId));
+        snapshot->append(reinterpret_cast<const char *>(&_unnamedCount), sizeof(_unnamedCount));
+        *snapshot += _codeWithTemplates ? '1' : '0';
+        list.serialize(*snapshot);
+    }
+
+    if (_settings->checkHeadersOnce)
+        removeCheckedHeaderCode();
+
+    createSymbolDatabase();
+    splitRValueReferences();
+
+    return true;
+}
+
+bool Tokenizer::loadSnapshot(const char data[], std::size_t size, const std::string &configuration)
+{
+    // make sure settings specified
+    assert(_settings);
+
+    // Fill the map _typeSize..
+    fillTypeSizes();
+
+    _configuration = configuration;
+
+    const std::size_t stateSize = sizeof(_varId) + sizeof(_unnamedCount) + 1;
+    if (size < stateSize)
+        return false;
+    std::memcpy(&_varId, data, sizeof(_varId));
+    std::memcpy(&_unnamedCount, data + sizeof(_varId), sizeof(_unnamedCount));
+    const char codeWithTemplates = data[stateSize - 1];
+    if (codeWithTemplates != '0' && codeWithTemplates != '1')
+        return false;
+    _codeWithTemplates = (codeWithTemplates == '1');
+    if (!list.deserialize(data + stateSize, size - stateSize) || !list.front())
+        return false;
+
+    if (_settings->checkHeadersOnce)
+        removeCheckedHeaderCode();
+
     createSymbolDatabase();
+    splitRValueReferences();
+
+    return true;
+}
 
+void Tokenizer::splitRValueReferences()
+{
     // Use symbol database to identify rvalue references. Split && to & &. This is safe, since it doesn't delete any tokens (which might be referenced by symbol database)
     for (std::size_t i = 0; i < _symbolDatabase->getVariableListSize(); i++) {
         const Variable* var = _symbolDatabase->getVariableFromVarId(i);
@@ -1977,8 +2048,213 @@ bool Tokenizer::tokenize(std::istream &code,
             const_cast<Token*>(var->typeEndToken())->insertToken("&");
         }
     }
+}
 
-    return true;
+namespace {
+    /**
+     * Fingerprints of the header code that has been checked
+     * (--check-headers-once), shared by all Tokenizer instances (and
+     * checking threads) of the process
+     */
+    class CheckedHeaderCode {
+    public:
+        /** @return true if the fingerprint has been added before */
+        bool add(unsigned long long fingerprint) {
+            MutexLocker lock(_mutex);
+            return !_fingerprints.insert(fingerprint).second;
+        }
+
+        void clear() {
+            MutexLocker lock(_mutex);
+            _fingerprints.clear();
+        }
+
+    private:
+        std::set<unsigned long long> _fingerprints;
+        Mutex _mutex;
+    };
+
+    CheckedHeaderCode checkedHeaderCode;
+
+    /** A function body that removeCheckedHeaderCode() might remove */
+    struct FunctionBody {
+        Token *start;       // the '{' or the ':' of the initializer list
+        Token *end;         // the '}'
+        std::string name;
+        std::string className;
+        unsigned int firstLine;  // first line of the function or its class
+        unsigned int lastLine;   // last line of the function or its class
+        bool used;
+    };
+}
+
+/**
+ * If @p tok is the '{' of a function body, get the function name and
+ * the first token after the parameter list. Functions that are defined
+ * outside their class are not handled.
+ */
+static Token *functionBodyStart(Token *tok, const Token *&nameToken)
+{
+    Token *prev = tok->previous();
+
+    // Initializer list of a constructor: ") : a ( 0 ) , b ( 1 ) {"
+    Token *start = tok;
+    while (Token::Match(prev, ")|}") && Token::Match(prev->link()->tokAt(-2), ":|, %var% (|{")) {
+        start = prev->link()->tokAt(-2);
+        prev = start->previous();
+        if (start->str() == ":")
+            break;
+    }
+    if (start->str() == ",")
+        return 0;
+
+    while (Token::Match(prev, "const|volatile|override|final|noexcept"))
+        prev = prev->previous();
+    if (Token::simpleMatch(prev, ")") && Token::simpleMatch(prev->link()->previous(), "throw ("))
+        prev = prev->link()->tokAt(-2);
+    if (!prev || prev->str() != ")" || !prev->link()->previous())
+        return 0;
+
+    nameToken = prev->link()->previous();
+    if (!nameToken->isName() || Token::Match(nameToken, "if|for|while|switch|catch|sizeof|return|throw"))
+        return 0;
+    const Token *qualifier = nameToken->previous();
+    if (qualifier && qualifier->str() == "~")
+        qualifier = qualifier->previous();
+    if (qualifier && qualifier->str() == "::")
+        return 0;
+    return start;
+}
+
+/** If @p scope is the '{' of a class, struct or union, get its keyword */
+static const Token *classKeyword(const Token *scope)
+{
+    for (const Token *tok = scope->previous(); tok; tok = tok->previous()) {
+        if (Token::Match(tok, "class|struct|union"))
+            return tok;
+        if (Token::Match(tok, "[;{}()=]"))
+            return 0;
+        if (tok->str() == ">" && tok->link())
+            tok = tok->link();
+    }
+    return 0;
+}
+
+void Tokenizer::removeCheckedHeaderCode()
+{
+    // Fingerprint of the code of each header
+    const std::vector<std::string> &files = list.getFiles();
+    std::vector<std::string> code(files.size());
+    for (const Token *tok = list.front(); tok; tok = tok->next()) {
+        if (tok->fileIndex() == 0 || tok->fileIndex() >= files.size())
+            continue;
+        std::string &c = code[tok->fileIndex()];
+        const unsigned int linenr = tok->linenr();
+        c.append(reinterpret_cast<const char *>(&linenr), sizeof(linenr));
+        c += tok->str();
+        c += ' ';
+    }
+    // Code that was checked with other settings is checked again
+    std::ostringstream settingsKey;
+    settingsKey << std::hex << ResultsCache::key("", "", "", *_settings) << '\n';
+    std::vector<bool> checked(files.size(), false);
+    bool anyChecked = false;
+    for (std::size_t i = 1; i < files.size(); ++i) {
+        if (!code[i].empty() && checkedHeaderCode.add(ResultsCache::hash(settingsKey.str() + files[i] + '\n' + code[i])))
+            checked[i] = anyChecked = true;
+    }
+    if (!anyChecked)
+        return;
+
+    // The function bodies in the checked headers, and the names used by the other code
+    std::vector<FunctionBody> bodies;
+    std::set<std::string> usedNames;
+    std::stack<const Token *> scopes;
+    for (Token *tok = list.front(); tok; tok = tok->next()) {
+        const bool checkedFile = tok->fileIndex() < files.size() && checked[tok->fileIndex()];
+        if (!checkedFile && tok->isName())
+            usedNames.insert(tok->str());
+        if (tok->str() == "}" && !scopes.empty() && scopes.top() == tok->link()) {
+            scopes.pop();
+            continue;
+        }
+        if (tok->str() != "{" || !tok->link())
+            continue;
+
+        const Token *nameToken = 0;
+        Token * const start = functionBodyStart(tok, nameToken);
+        if (!start) {
+            scopes.push(tok);
+            continue;
+        }
+
+        if (checkedFile && tok->link()->fileIndex() == tok->fileIndex() && nameToken->fileIndex() == tok->fileIndex()) {
+            FunctionBody body;
+            body.start = start;
+            body.end = tok->link();
+            body.name = nameToken->str();
+            body.firstLine = nameToken->linenr();
+            body.lastLine = body.end->linenr();
+            body.used = false;
+            const Token *keyword = scopes.empty() ? 0 : classKeyword(scopes.top());
+            if (keyword && keyword->next()->isName()) {
+                body.className = keyword->next()->str();
+                if (keyword->fileIndex() == tok->fileIndex() && scopes.top()->link()->fileIndex() == tok->fileIndex()) {
+                    body.firstLine = keyword->linenr();
+                    body.lastLine = scopes.top()->link()->linenr();
+                } else {
+                    body.used = true;
+                }
+            }
+            bodies.push_back(body);
+        } else if (!checkedFile) {
+            for (const Token *tok2 = tok; tok2 != tok->link(); tok2 = tok2->next()) {
+                if (tok2->isName())
+                    usedNames.insert(tok2->str());
+            }
+        }
+        tok = tok->link();
+    }
+
+    // The bodies of the functions and classes that other code uses are
+    // kept, so that checks that look into them still work
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (std::vector<FunctionBody>::iterator it = bodies.begin(); it != bodies.end(); ++it) {
+            if (it->used ||
+                (usedNames.find(it->name) == usedNames.end() &&
+                 (it->className.empty() || usedNames.find(it->className) == usedNames.end())))
+                continue;
+            it->used = changed = true;
+            for (const Token *tok = it->start; tok != it->end; tok = tok->next()) {
+                if (tok->isName())
+                    usedNames.insert(tok->str());
+            }
+        }
+    }
+
+    // The other functions are declared only
+    for (std::vector<FunctionBody>::iterator it = bodies.begin(); it != bodies.end(); ++it) {
+        if (it->used)
+            continue;
+        HeaderLines lines;
+        lines.file = files[it->end->fileIndex()];
+        lines.first = it->firstLine;
+        lines.last = it->lastLine;
+        if (_checkedHeaderLines.empty() || _checkedHeaderLines.back().file != lines.file ||
+            _checkedHeaderLines.back().first != lines.first || _checkedHeaderLines.back().last != lines.last)
+            _checkedHeaderLines.push_back(lines);
+
+        Token::eraseTokens(it->start->previous(), it->end);
+        it->end->str(";");
+        it->end->link(0);
+    }
+}
+
+void Tokenizer::clearCheckedHeaders()
+{
+    checkedHeaderCode.clear();
 }
 //---------------------------------------------------------------------------
 
@@ -1989,12 +2265,9 @@ bool Tokenizer::tokenizeCondition(const std::string &code)
     // Fill the map _typeSize..
     fillTypeSizes();
 
-    {
-        std::istringstream istr(code);
-        if (!list.createTokens(istr, "")) {
-            cppcheckError(0);
-            return false;
-        }
+    if (!list.createTokens(code.data(), code.size(), "")) {
+        cppcheckError(0);
+        return false;
     }
 
     // Combine strings
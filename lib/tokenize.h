@@ -84,11 +84,58 @@ public:
      *
      * @param FileName The filename
      * @param configuration E.g. "A" for code where "#ifdef A" is true
+     * @param snapshot if given, a binary snapshot of the tokens is written
+     * here, see loadSnapshot()
      * @return false if source code contains syntax errors
      */
     bool tokenize(std::istream &code,
                   const char FileName[],
-                  const std::string &configuration = "");
+                  const std::string &configuration = "",
+                  std::string *snapshot = 0);
+
+    /**
+     * Tokenize code in a buffer, see tokenize() above. The buffer is
+     * not copied.
+     * @param code the code
+     * @param size length of the code
+     */
+    bool tokenize(const char code[],
+                  std::size_t size,
+                  const char FileName[],
+                  const std::string &configuration = "",
+                  std::string *snapshot = 0);
+
+    /**
+     * Load the tokens from a snapshot written by tokenize() instead of
+     * tokenizing the code again. Afterwards the tokens and the symbol
+     * database are the same as after tokenize(). The messages that were
+     * reported by tokenize() are not reported again.
+     * @param data the snapshot, for instance in a memory mapped file
+     * @param size size of the snapshot in bytes
+     * @param configuration E.g. "A" for code where "#ifdef A" is true
+     * @return false if the snapshot is invalid
+     */
+    bool loadSnapshot(const char data[], std::size_t size, const std::string &configuration = "");
+
+    /** Lines in a header, see checkedHeaderLines() */
+    struct HeaderLines {
+        std::string file;
+        unsigned int first;
+        unsigned int last;
+    };
+
+    /**
+     * With --check-headers-once, tokenize() removes the function bodies
+     * that the other code doesn't use from the headers whose code has
+     * been checked before by another Tokenizer of the process. These are
+     * the lines of the functions, or of their classes, that have changed.
+     */
+    const std::list<HeaderLines> &checkedHeaderLines() const {
+        return _checkedHeaderLines;
+    }
+
+    /** Forget which header code has been checked, see checkedHeaderLines() */
+    static void clearCheckedHeaders();
 
     /**
      * tokenize condition and run simple simplifications on it
@@ -97,6 +144,12 @@ public:
      */
     bool tokenizeCondition(const std::string &code);
 
+    /** Split '&&' of rvalue references into '& &', see tokenize() */
+    void splitRValueReferences();
+
+    /** Remove the unused function bodies of the headers that have been checked before, see checkedHeaderLines() */
+    void removeCheckedHeaderCode();
+
     /** Set variable id */
     void setVarId();
 
@@ -772,12 +825,18 @@ private:
     /** variable count */
     unsigned int _varId;
 
+    /** number of unnamed structs etc that got a name "UnnamedN" */
+    unsigned int _unnamedCount;
+
     /**
      * was there any templates? templates that are "unused" are
      * removed from the token list
      */
     bool _codeWithTemplates;
 
+    /** lines of the headers whose code has been removed, see checkedHeaderLines() */
+    std::list<HeaderLines> _checkedHeaderLines;
+
     /**
      * TimerResults
      */
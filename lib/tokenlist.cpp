@@ -27,10 +27,81 @@
 
 #include <cstring>
 #include <sstream>
+#include <iterator>
+#include <algorithm>
 #include <cctype>
 #include <stack>
+#include <map>
+#include <new>
 
 
+/** Number of tokens in a slab */
+static const std::size_t tokensPerSlab = 1024;
+
+TokenAllocator::TokenAllocator()
+    : _used(tokensPerSlab), _free(0), _created(0), _reused(0), _slabCount(0)
+{
+}
+
+TokenAllocator::~TokenAllocator()
+{
+    release(0);
+}
+
+Token *TokenAllocator::create(Token **tokensBack)
+{
+    void *memory;
+    if (_free) {
+        memory = _free;
+        _free = *static_cast<void **>(_free);
+        ++_reused;
+    } else {
+        if (_used == tokensPerSlab) {
+            _slabs.push_back(static_cast<char *>(::operator new(tokensPerSlab * sizeof(Token))));
+            _used = 0;
+            ++_slabCount;
+        }
+        memory = _slabs.back() + _used * sizeof(Token);
+        ++_used;
+    }
+    ++_created;
+
+    Token *tok = new (memory) Token(tokensBack);
+    tok->_allocator = this;
+    return tok;
+}
+
+void TokenAllocator::deleteToken(Token *tok)
+{
+    TokenAllocator * const allocator = tok->_allocator;
+    if (!allocator) {
+        delete tok;
+        return;
+    }
+
+    tok->~Token();
+    *reinterpret_cast<void **>(tok) = allocator->_free;
+    allocator->_free = tok;
+}
+
+void TokenAllocator::release(Token *front)
+{
+    while (front) {
+        Token *next = front->next();
+        if (front->_allocator == this)
+            front->~Token();
+        else
+            deleteToken(front);
+        front = next;
+    }
+
+    for (std::vector<char *>::const_iterator it = _slabs.begin(); it != _slabs.end(); ++it)
+        ::operator delete(*it);
+    _slabs.clear();
+    _used = tokensPerSlab;
+    _free = 0;
+}
+
 TokenList::TokenList(const Settings* settings) :
     _front(0),
     _back(0),
@@ -48,7 +119,7 @@ TokenList::~TokenList()
 // Deallocate lists..
 void TokenList::deallocateTokens()
 {
-    deleteTokens(_front);
+    _allocator.release(_front);
     _front = 0;
     _back = 0;
     _files.clear();
@@ -58,7 +129,7 @@ void TokenList::deleteTokens(Token *tok)
 {
     while (tok) {
         Token *next = tok->next();
-        delete tok;
+        TokenAllocator::deleteToken(tok);
         tok = next;
     }
 }
@@ -88,22 +159,23 @@ void TokenList::addtoken(const char str[], const unsigned int lineno, const unsi
         return;
     }
 
-    // Replace hexadecimal value with decimal
-    std::ostringstream str2;
-    if (MathLib::isHex(str) || MathLib::isOct(str) || MathLib::isBin(str)) {
-        str2 << MathLib::toLongNumber(str);
+    // Replace hexadecimal value with decimal. Such numbers start with 0.
+    const char *digits = (str[0] == '-' || str[0] == '+') ? str + 1 : str;
+    std::string str2(str);
+    if (*digits == '0' && (MathLib::isHex(str2) || MathLib::isOct(str2) || MathLib::isBin(str2))) {
+        std::ostringstream number;
+        number << MathLib::toLongNumber(str2);
+        str2 = number.str();
     } else if (std::strncmp(str, "_Bool", 5) == 0) {
-        str2 << "bool";
-    } else {
-        str2 << str;
+        str2 = "bool";
     }
 
     if (_back) {
-        _back->insertToken(str2.str());
+        _back->insertToken(str2);
     } else {
-        _front = new Token(&_back);
+        _front = _allocator.create(&_back);
         _back = _front;
-        _back->str(str2.str());
+        _back->str(str2);
     }
 
     _back->linenr(lineno);
@@ -118,7 +190,7 @@ void TokenList::addtoken(const Token * tok, const unsigned int lineno, const uns
     if (_back) {
         _back->insertToken(tok->str());
     } else {
-        _front = new Token(&_back);
+        _front = _allocator.create(&_back);
         _back = _front;
         _back->str(tok->str());
     }
@@ -169,6 +241,58 @@ void TokenList::insertTokens(Token *dest, const Token *src, unsigned int n)
 //---------------------------------------------------------------------------
 
 bool TokenList::createTokens(std::istream &code, const std::string& file0)
+{
+    const std::string buffer((std::istreambuf_iterator<char>(code)), std::istreambuf_iterator<char>());
+    return createTokens(buffer.data(), buffer.size(), file0);
+}
+
+namespace {
+    /** The character classes of createTokens() */
+    class CharClasses {
+    public:
+        enum Class {
+            separator = 1,  /**< ends the current token */
+            doubled = 2,    /**< "++", "--", ">>" .. are one token */
+            sign = 4,       /**< sign of an exponent "4.2e+10" */
+            digit = 8,
+            quote = 16
+        };
+
+        CharClasses() {
+            std::memset(_classes, 0, sizeof(_classes));
+            add("+-*/%&|^?!=<>[](){};:,.~\n ", separator, true);
+            add("+-<>=:&|", doubled, true);
+            add("+-", sign, true);
+            add("0123456789", digit, false);
+            add("\'\"", quote, false);
+        }
+
+        bool is(char c, Class cls) const {
+            return (_classes[static_cast<unsigned char>(c)] & cls) != 0;
+        }
+
+        /** Characters that are appended to the current token as they are */
+        bool isPlain(char c) const {
+            return (_classes[static_cast<unsigned char>(c)] & (separator | quote)) == 0 &&
+                   c != Preprocessor::macroChar;
+        }
+
+    private:
+        /** With nullTerminator the sets match '\0' like std::strchr does */
+        void add(const char chars[], Class cls, bool nullTerminator) {
+            for (const char *c = chars; *c; ++c)
+                _classes[static_cast<unsigned char>(*c)] |= cls;
+            if (nullTerminator)
+                _classes[0] |= cls;
+        }
+
+        unsigned int _classes[256];
+    };
+
+    const CharClasses charClasses;
+}
+
+bool TokenList::createTokens(const char code[], std::size_t size, const std::string& file0)
 {
     _files.push_back(file0);
 
@@ -193,11 +317,23 @@ bool TokenList::createTokens(std::istream &code, const std::string& file0)
 
     bool expandedMacro = false;
 
-    // Read one byte at a time from code and create tokens
-    for (char ch = (char)code.get(); code.good(); ch = (char)code.get()) {
+    // Scan the code and create tokens
+    const char * const end = code + size;
+    for (const char *p = code; p < end; ++p) {
+        char ch = *p;
+
+        // Most characters are just appended to the current token
+        if (charClasses.isPlain(ch)) {
+            const char *first = p;
+            while (p + 1 < end && charClasses.isPlain(p[1]))
+                ++p;
+            CurrentToken.append(first, p + 1);
+            continue;
+        }
+
         if (ch == Preprocessor::macroChar) {
-            while (code.peek() == Preprocessor::macroChar)
-                code.get();
+            while (p + 1 < end && p[1] == Preprocessor::macroChar)
+                ++p;
             ch = ' ';
             expandedMacro = true;
         } else if (ch == '\n') {
@@ -206,25 +342,15 @@ bool TokenList::createTokens(std::istream &code, const std::string& file0)
 
         // char/string..
         // multiline strings are not handled. The preprocessor should handle that for us.
-        else if (ch == '\'' || ch == '\"') {
-            std::string line;
-
-            // read char
+        else if (charClasses.is(ch, CharClasses::quote)) {
+            // Special sequence '\.'
             bool special = false;
-            char c = ch;
-            do {
-                // Append token..
-                line += c;
-
-                // Special sequence '\.'
-                if (special)
-                    special = false;
-                else
-                    special = (c == '\\');
-
-                // Get next character
-                c = (char)code.get();
-            } while (code.good() && (special || c != ch));
+            const char *last = p + 1;
+            while (last < end && (special || *last != ch)) {
+                special = !special && *last == '\\';
+                ++last;
+            }
+            std::string line(p, last);
             line += ch;
 
             // Handle #file "file.h"
@@ -266,32 +392,36 @@ bool TokenList::createTokens(std::istream &code, const std::string& file0)
 
             CurrentToken.clear();
 
+            // Unterminated string
+            if (last == end)
+                break;
+            p = last;
             continue;
         }
 
         if (ch == '.' &&
             CurrentToken.length() > 0 &&
-            std::isdigit(CurrentToken[0])) {
+            charClasses.is(CurrentToken[0], CharClasses::digit)) {
             // Don't separate doubles "5.4"
-        } else if (std::strchr("+-", ch) &&
+        } else if (charClasses.is(ch, CharClasses::sign) &&
                    CurrentToken.length() > 0 &&
-                   std::isdigit(CurrentToken[0]) &&
+                   charClasses.is(CurrentToken[0], CharClasses::digit) &&
                    (CurrentToken[CurrentToken.length()-1] == 'e' ||
                     CurrentToken[CurrentToken.length()-1] == 'E') &&
                    !MathLib::isHex(CurrentToken)) {
             // Don't separate doubles "4.2e+10"
-        } else if (CurrentToken.empty() && ch == '.' && std::isdigit(code.peek())) {
+        } else if (CurrentToken.empty() && ch == '.' && p + 1 < end && charClasses.is(p[1], CharClasses::digit)) {
             // tokenize .125 into 0.125
             CurrentToken = "0";
-        } else if (std::strchr("+-*/%&|^?!=<>[](){};:,.~\n ", ch)) {
+        } else if (charClasses.is(ch, CharClasses::separator)) {
             if (CurrentToken == "#file") {
                 // Handle this where strings are handled
                 continue;
             } else if (CurrentToken == "#line") {
                 // Read to end of line
-                std::string line;
-
-                std::getline(code, line);
+                const char *eol = std::find(p + 1, end, '\n');
+                const std::string line(p + 1, eol);
+                p = (eol == end) ? end - 1 : eol;
 
                 // Update the current line number
                 unsigned int row;
@@ -330,8 +460,8 @@ bool TokenList::createTokens(std::istream &code, const std::string& file0)
 
             CurrentToken += ch;
             // Add "++", "--", ">>" or ... token
-            if (std::strchr("+-<>=:&|", ch) && (code.peek() == ch))
-                CurrentToken += (char)code.get();
+            if (charClasses.is(ch, CharClasses::doubled) && p + 1 < end && p[1] == ch)
+                CurrentToken += *++p;
             addtoken(CurrentToken.c_str(), lineno, FileIndex);
             _back->setExpandedMacro(expandedMacro);
             CurrentToken.clear();
@@ -431,3 +561,159 @@ std::string TokenList::fileLine(const Token *tok) const
 {
     return ErrorLogger::ErrorMessage::FileLocation(tok, this).stringify();
 }
+
+//---------------------------------------------------------------------------
+// Binary snapshot of the token list
+//---------------------------------------------------------------------------
+
+namespace {
+    /** @brief First bytes of a serialized token list, change when the format changes */
+    const char SnapshotMagic[8] = { 'C', 'P', 'P', 'T', 'O', 'K', '0', '1' };
+
+    /** @brief Token flags in a serialized token */
+    enum SnapshotFlag {
+        FLAG_UNSIGNED = 1 << 8, FLAG_SIGNED = 1 << 9, FLAG_POINTER_COMPARE = 1 << 10,
+        FLAG_LONG = 1 << 11, FLAG_UNUSED = 1 << 12, FLAG_EXPANDED_MACRO = 1 << 13
+    };
+
+    /** @brief Number of 32 bit fields of a serialized token */
+    const std::size_t TokenFields = 7;
+
+    void appendUInt(std::string &data, unsigned int value)
+    {
+        data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    unsigned int readUInt(const char *data)
+    {
+        unsigned int value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+}
+
+void TokenList::serialize(std::string &data) const
+{
+    std::map<const Token *, unsigned int> index;
+    unsigned int tokenCount = 0;
+    for (const Token *tok = _front; tok; tok = tok->next())
+        index[tok] = tokenCount++;
+
+    std::string strings;
+    std::string records;
+    for (std::vector<std::string>::const_iterator it = _files.begin(); it != _files.end(); ++it) {
+        appendUInt(records, static_cast<unsigned int>(strings.size()));
+        appendUInt(records, static_cast<unsigned int>(it->size()));
+        strings += *it;
+    }
+    for (const Token *tok = _front; tok; tok = tok->next()) {
+        unsigned int flags = static_cast<unsigned int>(tok->type());
+        if (tok->isUnsigned())
+            flags |= FLAG_UNSIGNED;
+        if (tok->isSigned())
+            flags |= FLAG_SIGNED;
+        if (tok->isPointerCompare())
+            flags |= FLAG_POINTER_COMPARE;
+        if (tok->isLong())
+            flags |= FLAG_LONG;
+        if (tok->isUnused())
+            flags |= FLAG_UNUSED;
+        if (tok->isExpandedMacro())
+            flags |= FLAG_EXPANDED_MACRO;
+
+        appendUInt(records, static_cast<unsigned int>(strings.size()));
+        appendUInt(records, static_cast<unsigned int>(tok->str().size()));
+        appendUInt(records, tok->varId());
+        appendUInt(records, tok->fileIndex());
+        appendUInt(records, tok->linenr());
+        appendUInt(records, tok->link() ? index[tok->link()] + 1 : 0);
+        appendUInt(records, flags);
+        strings += tok->str();
+    }
+
+    data.append(SnapshotMagic, sizeof(SnapshotMagic));
+    appendUInt(data, static_cast<unsigned int>(_files.size()));
+    appendUInt(data, tokenCount);
+    appendUInt(data, static_cast<unsigned int>(strings.size()));
+    data += records;
+    data += strings;
+}
+
+bool TokenList::deserialize(const char data[], std::size_t size)
+{
+    deallocateTokens();
+
+    const std::size_t u = sizeof(unsigned int);
+    const std::size_t headerSize = sizeof(SnapshotMagic) + 3 * u;
+    if (size < headerSize || std::memcmp(data, SnapshotMagic, sizeof(SnapshotMagic)) != 0)
+        return false;
+    const std::size_t fileCount = readUInt(data + sizeof(SnapshotMagic));
+    const std::size_t tokenCount = readUInt(data + sizeof(SnapshotMagic) + u);
+    const std::size_t stringsSize = readUInt(data + sizeof(SnapshotMagic) + 2 * u);
+    if ((size - headerSize) / u < 2 * fileCount + TokenFields * tokenCount ||
+        size != headerSize + (2 * fileCount + TokenFields * tokenCount) * u + stringsSize)
+        return false;
+
+    const char *record = data + headerSize;
+    const char * const strings = data + size - stringsSize;
+    for (std::size_t i = 0; i < fileCount; ++i, record += 2 * u) {
+        const std::size_t offset = readUInt(record);
+        const std::size_t length = readUInt(record + u);
+        if (offset > stringsSize || length > stringsSize - offset) {
+            _files.clear();
+            return false;
+        }
+        _files.push_back(std::string(strings + offset, length));
+    }
+
+    // Create the tokens, the links are set when all tokens exist
+    std::vector<Token *> tokens;
+    std::vector<unsigned int> links;
+    std::vector<unsigned int> types;
+    tokens.reserve(tokenCount);
+    links.reserve(tokenCount);
+    types.reserve(tokenCount);
+    for (std::size_t i = 0; i < tokenCount; ++i, record += TokenFields * u) {
+        const std::size_t offset = readUInt(record);
+        const std::size_t length = readUInt(record + u);
+        const unsigned int fileIndex = readUInt(record + 3 * u);
+        const unsigned int link = readUInt(record + 5 * u);
+        const unsigned int flags = readUInt(record + 6 * u);
+        if (offset > stringsSize || length == 0 || length > stringsSize - offset ||
+            fileIndex >= fileCount || link > tokenCount || (flags & 0xff) > Token::eNone) {
+            deallocateTokens();
+            return false;
+        }
+
+        const std::string str(strings + offset, length);
+        if (_back) {
+            _back->insertToken(str);
+        } else {
+            _front = _allocator.create(&_back);
+            _back = _front;
+            _back->str(str);
+        }
+        _back->fileIndex(fileIndex);
+        _back->linenr(readUInt(record + 4 * u));
+        _back->varId(readUInt(record + 2 * u));
+        _back->isUnsigned((flags & FLAG_UNSIGNED) != 0);
+        _back->isSigned((flags & FLAG_SIGNED) != 0);
+        _back->isPointerCompare((flags & FLAG_POINTER_COMPARE) != 0);
+        _back->isLong((flags & FLAG_LONG) != 0);
+        _back->isUnused((flags & FLAG_UNUSED) != 0);
+        _back->setExpandedMacro((flags & FLAG_EXPANDED_MACRO) != 0);
+        tokens.push_back(_back);
+        links.push_back(link);
+        types.push_back(flags & 0xff);
+    }
+
+    for (std::size_t i = 0; i < tokens.size(); ++i) {
+        if (links[i])
+            tokens[i]->link(tokens[links[i] - 1]);
+        tokens[i]->type(static_cast<Token::Type>(types[i]));
+    }
+
+    if (_front)
+        _front->assignProgressValues();
+    return true;
+}
@@ -22,6 +22,7 @@
 #define tokenlistH
 //---------------------------------------------------------------------------
 
+#include <cstddef>
 #include <string>
 #include <vector>
 #include "config.h"
@@ -32,6 +33,69 @@ class Settings;
 /// @addtogroup Core
 /// @{
 
+/**
+ * @brief Allocates the tokens of a token list in slabs.
+ *
+ * The tokens that are appended one after the other are next to each other
+ * in memory. A deleted token is put on a free list and its memory is used
+ * for the next new token. All slabs are freed at once when the list is
+ * deallocated.
+ */
+class CPPCHECKLIB TokenAllocator {
+public:
+    TokenAllocator();
+    ~TokenAllocator();
+
+    /** @brief Create a token in the slabs */
+    Token *create(Token **tokensBack);
+
+    /**
+     * @brief Delete a token. The tokens of an allocator are put on its
+     * free list, other tokens are deleted with delete.
+     */
+    static void deleteToken(Token *tok);
+
+    /**
+     * @brief Free all slabs. The destructor of the tokens in the list
+     * @p front is called first, the other tokens must be deleted already.
+     */
+    void release(Token *front);
+
+    /** @brief Number of tokens created */
+    unsigned long long created() const {
+        return _created;
+    }
+
+    /** @brief Number of tokens that got the memory of a deleted token */
+    unsigned long long reused() const {
+        return _reused;
+    }
+
+    /** @brief Number of slabs that were allocated */
+    unsigned long long slabs() const {
+        return _slabCount;
+    }
+
+private:
+    /** Disable copy constructor, no implementation */
+    TokenAllocator(const TokenAllocator &);
+
+    /** Disable assignment operator, no implementation */
+    TokenAllocator &operator=(const TokenAllocator &);
+
+    std::vector<char *> _slabs;
+
+    /** Number of tokens that are used in the last slab */
+    std::size_t _used;
+
+    /** Deleted tokens, the memory of a token holds the next one */
+    void *_free;
+
+    unsigned long long _created;
+    unsigned long long _reused;
+    unsigned long long _slabCount;
+};
+
 class CPPCHECKLIB TokenList {
 public:
     TokenList(const Settings* settings);
@@ -63,6 +127,15 @@ public:
      */
     bool createTokens(std::istream &code, const std::string& file0 = "");
 
+    /**
+     * Create tokens from code in a buffer, for example a string or a
+     * mapped file. The code is scanned in place, it is not copied.
+     * @param code the code, it does not need to be null terminated
+     * @param size length of the code
+     * @param file0 source file name
+     */
+    bool createTokens(const char code[], std::size_t size, const std::string& file0 = "");
+
     /** Deallocate list */
     void deallocateTokens();
 
@@ -107,6 +180,22 @@ public:
 
     void createAst();
 
+    /**
+     * @brief Write the tokens and the file names to @p data in a binary
+     * format, see deserialize(). The data is a header, fixed size records
+     * for the files and the tokens, and a table with their strings, so it
+     * can be read directly from a memory mapped file. The numbers have the
+     * byte order of the host.
+     */
+    void serialize(std::string &data) const;
+
+    /**
+     * @brief Replace the tokens and the file names with those in @p data,
+     * see serialize().
+     * @return false if the data is invalid, the list is empty then
+     */
+    bool deserialize(const char data[], std::size_t size);
+
 private:
     /** Disable copy constructor, no implementation */
     TokenList(const TokenList &);
@@ -116,10 +205,17 @@ private:
 
 public:
 
+    /** @brief The allocator of the tokens */
+    const TokenAllocator &allocator() const {
+        return _allocator;
+    }
+
 private: /// private
     /** Token list */
     Token *_front, *_back;
 
+    TokenAllocator _allocator;
+
     /** filenames for the tokenized source code (source + included) */
     std::vector<std::string> _files;
 
@@ -16,15 +16,23 @@ BASEPATH = .
 include($$PWD/testfiles.pri)
 
 # cli/*
-SOURCES += ../cli/cmdlineparser.cpp \
+SOURCES += ../cli/analysisserver.cpp \
+           ../cli/cmdlineparser.cpp \
+           ../cli/compiledatabase.cpp \
            ../cli/cppcheckexecutor.cpp \
            ../cli/filelister.cpp \
+           ../cli/filescheduler.cpp \
+           ../cli/jobserver.cpp \
            ../cli/pathmatch.cpp \
            ../cli/threadexecutor.cpp
 
-HEADERS += ../cli/cmdlineparser.h \
+HEADERS += ../cli/analysisserver.h \
+           ../cli/cmdlineparser.h \
+           ../cli/compiledatabase.h \
            ../cli/cppcheckexecutor.h \
            ../cli/filelister.h \
+           ../cli/filescheduler.h \
+           ../cli/jobserver.h \
            ../cli/pathmatch.h \
            ../cli/threadexecutor.h
 
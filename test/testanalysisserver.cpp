@@ -0,0 +1,187 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2013 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "testsuite.h"
+#include "analysisserver.h"
+#include "settings.h"
+#include <cstdio>
+#include <fstream>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+class TestAnalysisServer : public TestFixture {
+public:
+    TestAnalysisServer() : TestFixture("TestAnalysisServer")
+    { }
+
+private:
+    void run() {
+        TEST_CASE(parseRequest);
+        TEST_CASE(parseRequestCrLf);
+        TEST_CASE(parseEmptyRequest);
+#ifndef _WIN32
+        TEST_CASE(check);
+        TEST_CASE(checkXml);
+        TEST_CASE(checkHeadersOnce);
+        TEST_CASE(invalidOption);
+        TEST_CASE(unknownRequest);
+        TEST_CASE(shutdown);
+        TEST_CASE(stalledClient);
+#endif
+    }
+
+    void parseRequest() const {
+        std::string command;
+        std::vector<std::string> args;
+        ASSERT_EQUALS(true, AnalysisServer::parseRequest("check\n--enable=style\nsrc/main.cpp\n\nignored\n", command, args));
+        ASSERT_EQUALS("check", command);
+        ASSERT_EQUALS(2U, args.size());
+        ASSERT_EQUALS("--enable=style", args[0]);
+        ASSERT_EQUALS("src/main.cpp", args[1]);
+    }
+
+    void parseRequestCrLf() const {
+        std::string command;
+        std::vector<std::string> args;
+        ASSERT_EQUALS(true, AnalysisServer::parseRequest("check\r\nmain.cpp\r\n\r\n", command, args));
+        ASSERT_EQUALS("check", command);
+        ASSERT_EQUALS(1U, args.size());
+        ASSERT_EQUALS("main.cpp", args[0]);
+    }
+
+    void parseEmptyRequest() const {
+        std::string command;
+        std::vector<std::string> args;
+        ASSERT_EQUALS(false, AnalysisServer::parseRequest("", command, args));
+        ASSERT_EQUALS(false, AnalysisServer::parseRequest("\ncheck\n", command, args));
+    }
+
+#ifndef _WIN32
+    /** Send a request to the server and return the response */
+    static std::string request(const std::string &data, bool *more = 0) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+            return "socketpair failed";
+        if (write(fds[0], data.data(), data.size()) != static_cast<ssize_t>(data.size()))
+            return "write failed";
+        ::shutdown(fds[0], SHUT_WR);
+
+        Settings settings;
+        AnalysisServer server(settings);
+        const bool ret = server.handleConnection(fds[1]);
+        if (more)
+            *more = ret;
+        close(fds[1]);
+
+        std::string response;
+        char buf[1024];
+        ssize_t n;
+        while ((n = read(fds[0], buf, sizeof(buf))) > 0)
+            response.append(buf, static_cast<std::size_t>(n));
+        close(fds[0]);
+        return response;
+    }
+
+    void check() {
+        {
+            std::ofstream fout("testanalysisserver.c");
+            fout << "void f() { char *p = malloc(10); }\n";
+        }
+        ASSERT_EQUALS("[testanalysisserver.c:1]: (error) Memory leak: p\n",
+                      request("check\ntestanalysisserver.c\n\n"));
+        ASSERT_EQUALS("testanalysisserver.c:1:memleak\n",
+                      request("check\n--template={file}:{line}:{id}\ntestanalysisserver.c\n\n"));
+        std::remove("testanalysisserver.c");
+    }
+
+    void checkXml() {
+        {
+            std::ofstream fout("testanalysisserver.c");
+            fout << "void f() { char *p = malloc(10); }\n";
+        }
+        const std::string response = request("check\n--xml-version=2\ntestanalysisserver.c\n\n");
+        ASSERT_EQUALS(0U, response.find("<?xml"));
+        ASSERT(response.find("id=\"memleak\"") != std::string::npos);
+        ASSERT(response.find("</results>") != std::string::npos);
+        std::remove("testanalysisserver.c");
+    }
+
+    void checkHeadersOnce() {
+        // The messages of the header are reported for every request
+        {
+            std::ofstream fout("testanalysisserver.h");
+            fout << "void g() { char *p = malloc(10); }\n";
+        }
+        {
+            std::ofstream fout("testanalysisserver.c");
+            fout << "#include \"testanalysisserver.h\"\n";
+        }
+        const std::string expected("[testanalysisserver.h:1]: (error) Memory leak: p\n");
+        ASSERT_EQUALS(expected, request("check\n--check-headers-once\ntestanalysisserver.c\n\n"));
+        ASSERT_EQUALS(expected, request("check\n--check-headers-once\ntestanalysisserver.c\n\n"));
+        std::remove("testanalysisserver.c");
+        std::remove("testanalysisserver.h");
+    }
+
+    void invalidOption() {
+        ASSERT_EQUALS("cppcheck: error: unrecognized command line option: \"--foo\".\n",
+                      request("check\n--foo\nmain.cpp\n\n"));
+        ASSERT_EQUALS("cppcheck: error: could not find or open any of the paths given.\n",
+                      request("check\nno-such-file.c\n\n"));
+    }
+
+    void unknownRequest() {
+        bool more = false;
+        ASSERT_EQUALS("cppcheck: error: unknown request 'foo'.\n", request("foo\n\n", &more));
+        ASSERT_EQUALS(true, more);
+    }
+
+    void shutdown() {
+        bool more = true;
+        ASSERT_EQUALS("", request("shutdown\n\n", &more));
+        ASSERT_EQUALS(false, more);
+    }
+
+    void stalledClient() {
+        // The client never finishes its request and keeps the connection open
+        int fds[2];
+        ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+        ASSERT(write(fds[0], "check\n", 6) == 6);
+
+        Settings settings;
+        AnalysisServer server(settings);
+        server.setRequestTimeout(100);
+        ASSERT_EQUALS(true, server.handleConnection(fds[1]));
+        close(fds[1]);
+
+        std::string response;
+        char buf[1024];
+        ssize_t n;
+        while ((n = read(fds[0], buf, sizeof(buf))) > 0)
+            response.append(buf, static_cast<std::size_t>(n));
+        close(fds[0]);
+        ASSERT_EQUALS("cppcheck: error: no request received in time.\n", response);
+    }
+#endif
+};
+
+REGISTER_TEST(TestAnalysisServer)
@@ -20,6 +20,8 @@
 #include "cmdlineparser.h"
 #include "settings.h"
 #include "redirect.h"
+#include <cstdio>
+#include <fstream>
 
 class TestCmdlineParser : public TestFixture {
 public:
@@ -83,9 +85,31 @@ private:
         TEST_CASE(jobs);
         TEST_CASE(jobsMissingCount);
         TEST_CASE(jobsInvalid);
+        TEST_CASE(executorThread);
+        TEST_CASE(executorInvalid);
+        TEST_CASE(timingsFile);
+        TEST_CASE(configJobs);
+        TEST_CASE(configJobsInvalid);
+        TEST_CASE(checkJobs);
+        TEST_CASE(checkJobsInvalid);
+        TEST_CASE(timingsFileMissingName);
+        TEST_CASE(cacheDir);
+        TEST_CASE(cacheDirMissingName);
+        TEST_CASE(incremental);
+        TEST_CASE(incrementalMissingName);
+        TEST_CASE(server);
+        TEST_CASE(serverWithFiles);
+        TEST_CASE(checkHeadersOnce);
+        TEST_CASE(shard);
+        TEST_CASE(shardInvalid);
+        TEST_CASE(project);
+        TEST_CASE(projectWithFiles);
+        TEST_CASE(projectMissingFile);
         TEST_CASE(maxConfigs);
         TEST_CASE(maxConfigsMissingCount);
         TEST_CASE(maxConfigsInvalid);
+        TEST_CASE(maxMemory);
+        TEST_CASE(maxMemoryInvalid);
         TEST_CASE(maxConfigsTooSmall);
         TEST_CASE(reportProgressTest); // "Test" suffix to avoid hiding the parent's reportProgress
         TEST_CASE(stdposix);
@@ -674,6 +698,194 @@ private:
         ASSERT_EQUALS(false, parser.ParseFromArgs(4, argv));
     }
 
+    void executorThread() {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "-j2", "--executor=thread", "file.cpp"};
+        settings.executor = Settings::Process;
+        CmdLineParser parser(&settings);
+        ASSERT(parser.ParseFromArgs(4, argv));
+        ASSERT_EQUALS(Settings::Thread, settings.executor);
+    }
+
+    void executorInvalid() {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--executor=fiber", "file.cpp"};
+        CmdLineParser parser(&settings);
+        ASSERT_EQUALS(false, parser.ParseFromArgs(3, argv));
+    }
+
+    void configJobs() {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--config-jobs=4", "file.cpp"};
+        settings.configJobs = 1;
+        CmdLineParser parser(&settings);
+        ASSERT(parser.ParseFromArgs(3, argv));
+        ASSERT_EQUALS(4, settings.configJobs);
+    }
+
+    void configJobsInvalid() {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--config-jobs=0", "file.cpp"};
+        CmdLineParser parser(&settings);
+        ASSERT_EQUALS(false, parser.ParseFromArgs(3, argv));
+    }
+
+    void checkJobs() {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--check-jobs=3", "file.cpp"};
+        settings.checkJobs = 1;
+        CmdLineParser parser(&settings);
+        ASSERT(parser.ParseFromArgs(3, argv));
+        ASSERT_EQUALS(3, settings.checkJobs);
+    }
+
+    void checkJobsInvalid() {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--check-jobs=x", "file.cpp"};
+        CmdLineParser parser(&settings);
+        ASSERT_EQUALS(false, parser.ParseFromArgs(3, argv));
+    }
+
+    void timingsFile() {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "-j2", "--timings-file=timings.txt", "file.cpp"};
+        settings.timingsFile.clear();
+        CmdLineParser parser(&settings);
+        ASSERT(parser.ParseFromArgs(4, argv));
+        ASSERT_EQUALS("timings.txt", settings.timingsFile);
+    }
+
+    void timingsFileMissingName() {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--timings-file=", "file.cpp"};
+        CmdLineParser parser(&settings);
+        ASSERT_EQUALS(false, parser.ParseFromArgs(3, argv));
+    }
+
+    void cacheDir() {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--cache-dir=.", "file.cpp"};
+        settings.cacheDir.clear();
+        CmdLineParser parser(&settings);
+        ASSERT(parser.ParseFromArgs(3, argv));
+        ASSERT_EQUALS(".", settings.cacheDir);
+        settings.cacheDir.clear();
+    }
+
+    void cacheDirMissingName() {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--cache-dir=", "file.cpp"};
+        CmdLineParser parser(&settings);
+        ASSERT_EQUALS(false, parser.ParseFromArgs(3, argv));
+    }
+
+    void incremental() {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--incremental=.", "file.cpp"};
+        settings.incrementalDir.clear();
+        CmdLineParser parser(&settings);
+        ASSERT(parser.ParseFromArgs(3, argv));
+        ASSERT_EQUALS(".", settings.incrementalDir);
+        settings.incrementalDir.clear();
+    }
+
+    void incrementalMissingName() {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--incremental=", "file.cpp"};
+        CmdLineParser parser(&settings);
+        ASSERT_EQUALS(false, parser.ParseFromArgs(3, argv));
+    }
+
+    void server() {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--server=/tmp/cppcheck.sock"};
+        settings.serverSocket.clear();
+        CmdLineParser parser(&settings);
+        ASSERT(parser.ParseFromArgs(2, argv));
+        ASSERT_EQUALS("/tmp/cppcheck.sock", settings.serverSocket);
+        settings.serverSocket.clear();
+    }
+
+    void serverWithFiles() {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--server=/tmp/cppcheck.sock", "file.cpp"};
+        CmdLineParser parser(&settings);
+        ASSERT_EQUALS(false, parser.ParseFromArgs(3, argv));
+        settings.serverSocket.clear();
+    }
+
+    void checkHeadersOnce() {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--check-headers-once", "file.cpp"};
+        settings.checkHeadersOnce = false;
+        CmdLineParser parser(&settings);
+        ASSERT(parser.ParseFromArgs(3, argv));
+        ASSERT_EQUALS(true, settings.checkHeadersOnce);
+        settings.checkHeadersOnce = false;
+    }
+
+    void shard() {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--shard=2/3", "file.cpp"};
+        CmdLineParser parser(&settings);
+        ASSERT(parser.ParseFromArgs(3, argv));
+        ASSERT_EQUALS(2, settings.shardIndex);
+        ASSERT_EQUALS(3, settings.shardCount);
+        settings.shardIndex = settings.shardCount = 1;
+    }
+
+    void shardInvalid() {
+        REDIRECT;
+        const char *argv1[] = {"cppcheck", "--shard=0/3", "file.cpp"};
+        const char *argv2[] = {"cppcheck", "--shard=4/3", "file.cpp"};
+        const char *argv3[] = {"cppcheck", "--shard=2", "file.cpp"};
+        const char *argv4[] = {"cppcheck", "--shard=1/2x", "file.cpp"};
+        CmdLineParser parser(&settings);
+        ASSERT_EQUALS(false, parser.ParseFromArgs(3, argv1));
+        ASSERT_EQUALS(false, parser.ParseFromArgs(3, argv2));
+        ASSERT_EQUALS(false, parser.ParseFromArgs(3, argv3));
+        ASSERT_EQUALS(false, parser.ParseFromArgs(3, argv4));
+        settings.shardIndex = settings.shardCount = 1;
+    }
+
+    void project() {
+        REDIRECT;
+        {
+            std::ofstream fout("compile_commands.json");
+            fout << "[ { \"directory\": \"/src\", \"file\": \"a.c\", \"command\": \"gcc -DA -Iinc -c a.c\" } ]";
+        }
+        const char *argv[] = {"cppcheck", "-DB", "--project=compile_commands.json"};
+        settings.userDefines.clear();
+        settings._includePaths.clear();
+        settings.fileSettings.clear();
+        CmdLineParser parser(&settings);
+        ASSERT(parser.ParseFromArgs(3, argv));
+        std::remove("compile_commands.json");
+        ASSERT_EQUALS(1U, settings.fileSettings.size());
+        ASSERT_EQUALS("/src/a.c", settings.fileSettings.begin()->first);
+        ASSERT_EQUALS("B=1;A=1", settings.fileSettings.begin()->second.defines);
+        ASSERT_EQUALS(1U, settings.fileSettings.begin()->second.includePaths.size());
+        ASSERT_EQUALS("/src/inc/", settings.fileSettings.begin()->second.includePaths.front());
+        settings.userDefines.clear();
+        settings.fileSettings.clear();
+    }
+
+    void projectWithFiles() {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--project=compile_commands.json", "file.cpp"};
+        CmdLineParser parser(&settings);
+        ASSERT_EQUALS(false, parser.ParseFromArgs(3, argv));
+    }
+
+    void projectMissingFile() {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--project=missing_compile_commands.json"};
+        settings.fileSettings.clear();
+        CmdLineParser parser(&settings);
+        ASSERT_EQUALS(false, parser.ParseFromArgs(2, argv));
+        ASSERT_EQUALS(true, settings.fileSettings.empty());
+    }
+
     void maxConfigs() {
         REDIRECT;
         const char *argv[] = {"cppcheck", "-f", "--max-configs=12", "file.cpp"};
@@ -701,6 +913,36 @@ private:
         ASSERT_EQUALS(false, parser.ParseFromArgs(3, argv));
     }
 
+    void maxMemory() {
+        REDIRECT;
+        const char *argv1[] = {"cppcheck", "--max-memory=512", "file.cpp"};
+        settings.maxMemory = 0;
+        CmdLineParser parser1(&settings);
+        ASSERT(parser1.ParseFromArgs(3, argv1));
+        ASSERT_EQUALS(512ULL * 1024 * 1024, settings.maxMemory);
+
+        const char *argv2[] = {"cppcheck", "--max-memory=8G", "file.cpp"};
+        CmdLineParser parser2(&settings);
+        ASSERT(parser2.ParseFromArgs(3, argv2));
+        ASSERT_EQUALS(8ULL * 1024 * 1024 * 1024, settings.maxMemory);
+
+        const char *argv3[] = {"cppcheck", "--max-memory=100K", "file.cpp"};
+        CmdLineParser parser3(&settings);
+        ASSERT(parser3.ParseFromArgs(3, argv3));
+        ASSERT_EQUALS(100ULL * 1024, settings.maxMemory);
+    }
+
+    void maxMemoryInvalid() {
+        REDIRECT;
+        const char *argv1[] = {"cppcheck", "--max-memory=0", "file.cpp"};
+        CmdLineParser parser1(&settings);
+        ASSERT_EQUALS(false, parser1.ParseFromArgs(3, argv1));
+
+        const char *argv2[] = {"cppcheck", "--max-memory=4GB", "file.cpp"};
+        CmdLineParser parser2(&settings);
+        ASSERT_EQUALS(false, parser2.ParseFromArgs(3, argv2));
+    }
+
     void maxConfigsTooSmall() {
         REDIRECT;
         const char *argv[] = {"cppcheck", "--max-configs=0", "file.cpp"};
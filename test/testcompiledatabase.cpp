@@ -0,0 +1,153 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2013 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include "testsuite.h"
+#include "compiledatabase.h"
+#include "settings.h"
+
+class TestCompileDatabase : public TestFixture {
+public:
+    TestCompileDatabase() : TestFixture("TestCompileDatabase")
+    { }
+
+private:
+
+    void run() {
+        TEST_CASE(splitCommand);
+        TEST_CASE(command);
+        TEST_CASE(arguments);
+        TEST_CASE(relativePaths);
+        TEST_CASE(commandLineFlags);
+        TEST_CASE(sameFileDifferentFlags);
+        TEST_CASE(sameFileSameFlags);
+        TEST_CASE(otherValues);
+        TEST_CASE(invalid);
+    }
+
+    bool parse(const char json[], std::map<std::string, Settings::FileSettings> &files, const Settings &settings = Settings()) {
+        std::istringstream istr(json);
+        std::string error;
+        return CompileDatabase::parse(istr, settings, files, error);
+    }
+
+    static std::string join(const std::list<std::string> &strings) {
+        std::string result;
+        for (std::list<std::string>::const_iterator it = strings.begin(); it != strings.end(); ++it)
+            result += (result.empty() ? "" : " ") + *it;
+        return result;
+    }
+
+    void splitCommand() {
+        const std::vector<std::string> args = CompileDatabase::splitCommand("gcc  -DA=\"x y\" '-DB=\"s\"' -DC=\\\"t\\\" -c a.c");
+        ASSERT_EQUALS(6U, args.size());
+        ASSERT_EQUALS("gcc", args[0]);
+        ASSERT_EQUALS("-DA=x y", args[1]);
+        ASSERT_EQUALS("-DB=\"s\"", args[2]);
+        ASSERT_EQUALS("-DC=\"t\"", args[3]);
+        ASSERT_EQUALS("-c", args[4]);
+        ASSERT_EQUALS("a.c", args[5]);
+    }
+
+    void command() {
+        std::map<std::string, Settings::FileSettings> files;
+        ASSERT(parse("[ { \"directory\": \"/src\",\n"
+                     "    \"command\": \"gcc -DA -DB=2 -D C -UD -I/usr/inc -I inc -isystem /sys -include cfg.h -o a.o -c a.c\",\n"
+                     "    \"file\": \"a.c\" } ]", files));
+        ASSERT_EQUALS(1U, files.size());
+        const Settings::FileSettings &fs = files["/src/a.c"];
+        ASSERT_EQUALS("/src/a.c", fs.filename);
+        ASSERT_EQUALS("A=1;B=2;C=1", fs.defines);
+        ASSERT_EQUALS(1U, fs.undefs.size());
+        ASSERT_EQUALS(1U, fs.undefs.count("D"));
+        ASSERT_EQUALS("/usr/inc/ /src/inc/ /sys/", join(fs.includePaths));
+        ASSERT_EQUALS("/src/cfg.h", join(fs.userIncludes));
+    }
+
+    void arguments() {
+        std::map<std::string, Settings::FileSettings> files;
+        ASSERT(parse("[{\"directory\":\"/src\",\"arguments\":[\"cc\",\"-DS=\\\"a b\\\"\",\"-c\",\"b.c\"],\"file\":\"/src/b.c\"}]", files));
+        ASSERT_EQUALS(1U, files.size());
+        ASSERT_EQUALS("S=\"a b\"", files["/src/b.c"].defines);
+    }
+
+    void relativePaths() {
+        std::map<std::string, Settings::FileSettings> files;
+        ASSERT(parse("[ { \"directory\": \"/src/build\", \"command\": \"gcc -I../inc -I./gen -c ../lib/./c.c\", \"file\": \"../lib/./c.c\" } ]", files));
+        ASSERT_EQUALS(1U, files.size());
+        const Settings::FileSettings &fs = files.begin()->second;
+        ASSERT_EQUALS("/src/lib/c.c", fs.filename);
+        ASSERT_EQUALS("/src/inc/ /src/build/gen/", join(fs.includePaths));
+    }
+
+    void commandLineFlags() {
+        Settings settings;
+        settings.userDefines = "X=1";
+        settings.userUndefs.insert("Y");
+        settings._includePaths.push_back("cmdline/");
+        std::map<std::string, Settings::FileSettings> files;
+        ASSERT(parse("[ { \"directory\": \"/src\", \"command\": \"gcc -DA -Iinc -c a.c\", \"file\": \"a.c\" } ]", files, settings));
+        const Settings::FileSettings &fs = files["/src/a.c"];
+        ASSERT_EQUALS("X=1;A=1", fs.defines);
+        ASSERT_EQUALS(1U, fs.undefs.count("Y"));
+        ASSERT_EQUALS("cmdline/ /src/inc/", join(fs.includePaths));
+    }
+
+    void sameFileDifferentFlags() {
+        std::map<std::string, Settings::FileSettings> files;
+        ASSERT(parse("[ { \"directory\": \"/src\", \"command\": \"gcc -DA -c a.c\", \"file\": \"a.c\" },\n"
+                     "  { \"directory\": \"/src\", \"command\": \"gcc -DB -c a.c\", \"file\": \"a.c\" },\n"
+                     "  { \"directory\": \"/src\", \"command\": \"gcc -DC -c a.c\", \"file\": \"a.c\" } ]", files));
+        ASSERT_EQUALS(3U, files.size());
+        ASSERT_EQUALS("A=1", files["/src/a.c"].defines);
+        ASSERT_EQUALS("B=1", files["/src/a.c (2)"].defines);
+        ASSERT_EQUALS("C=1", files["/src/a.c (3)"].defines);
+        ASSERT_EQUALS("/src/a.c", files["/src/a.c (3)"].filename);
+    }
+
+    void sameFileSameFlags() {
+        std::map<std::string, Settings::FileSettings> files;
+        ASSERT(parse("[ { \"directory\": \"/src\", \"command\": \"gcc -DA -o a.o -c a.c\", \"file\": \"a.c\" },\n"
+                     "  { \"directory\": \"/src\", \"command\": \"gcc -DA -fPIC -o a.so.o -c a.c\", \"file\": \"a.c\" } ]", files));
+        ASSERT_EQUALS(1U, files.size());
+    }
+
+    void otherValues() {
+        std::map<std::string, Settings::FileSettings> files;
+        ASSERT(parse("[ { \"directory\": \"/src\", \"output\": \"a.o\", \"n\": -1.5e3, \"ok\": true,\n"
+                     "    \"x\": { \"y\": [ null, {}, [] ] }, \"file\": \"a.c\", \"command\": \"gcc -DA\\u003d1 -c a.c\" } ]", files));
+        ASSERT_EQUALS("A=1", files["/src/a.c"].defines);
+
+        files.clear();
+        ASSERT(parse("[]", files));
+        ASSERT_EQUALS(true, files.empty());
+    }
+
+    void invalid() {
+        std::map<std::string, Settings::FileSettings> files;
+        ASSERT_EQUALS(false, parse("{}", files));
+        ASSERT_EQUALS(false, parse("[ { \"file\": \"a.c\" ", files));
+        ASSERT_EQUALS(false, parse("[ { \"file\": \"a.c\", } ]", files));
+        ASSERT_EQUALS(false, parse("[ { \"directory\": \"/src\" } ]", files));
+        ASSERT_EQUALS(false, parse("[ { \"file\": \"a.c\" } ] x", files));
+    }
+};
+
+REGISTER_TEST(TestCompileDatabase)
@@ -25,11 +25,21 @@
 #include "cppcheckexecutor.h"
 #include "testsuite.h"
 #include "path.h"
+#include "preprocessor.h"
+#include "tokenize.h"
 
 #include <algorithm>
+#include <cstdio>
+#include <fstream>
 #include <list>
 #include <string>
 
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 extern std::ostringstream errout;
 extern std::ostringstream output;
 
@@ -52,10 +62,31 @@ private:
         }
     };
 
+    /** @brief Records all output in the order it is reported */
+    class ErrorLogger3 : public ErrorLogger {
+    public:
+        std::string messages;
+
+        void reportOut(const std::string &outmsg) {
+            messages += outmsg + "\n";
+        }
+
+        void reportErr(const ErrorLogger::ErrorMessage &msg) {
+            messages += msg.toString(false) + "\n";
+        }
+    };
+
     void run() {
         TEST_CASE(instancesSorted);
         TEST_CASE(classInfoFormat);
         TEST_CASE(getErrorMessages);
+        TEST_CASE(configJobs);
+        TEST_CASE(checkJobs);
+        TEST_CASE(uniqueErrors);
+#ifndef _WIN32
+        TEST_CASE(incrementalMissingHeader);
+        TEST_CASE(cacheCheckHeadersOnce);
+#endif
     }
 
     void instancesSorted() const {
@@ -98,6 +129,149 @@ private:
         }
         ASSERT_EQUALS("", duplicate);
     }
+
+    std::string checkConfigurations(unsigned int configJobs, unsigned int checkJobs = 1) const {
+        const char code[] = "void f() {\n"
+                            "#ifdef A\n"
+                            "    char *a = malloc(10);\n"
+                            "#endif\n"
+                            "#ifdef B\n"
+                            "    int b[2]; b[2] = 0;\n"
+                            "#endif\n"
+                            "#ifdef C\n"
+                            "    }\n"
+                            "#endif\n"
+                            "    char *c = malloc(10);\n"
+                            "}\n";
+        ErrorLogger3 errorLogger;
+        CppCheck cppCheck(errorLogger, true);
+        cppCheck.settings().configJobs = configJobs;
+        cppCheck.settings().checkJobs = checkJobs;
+        cppCheck.settings().addEnabled("style");
+        cppCheck.check("test.c", code);
+        return errorLogger.messages;
+    }
+
+    void configJobs() const {
+        // Same messages in the same order whether the configurations are checked in parallel or not
+        const std::string expected = checkConfigurations(1);
+        ASSERT_EQUALS(true, expected.find("Memory leak: a") != std::string::npos);
+        ASSERT_EQUALS(true, expected.find("test.c:6") != std::string::npos);
+        ASSERT_EQUALS(expected, checkConfigurations(2));
+        ASSERT_EQUALS(expected, checkConfigurations(4));
+    }
+
+    void checkJobs() const {
+        // Same messages in the same order whether the checks are run in parallel or not
+        const std::string expected = checkConfigurations(1);
+        ASSERT_EQUALS(expected, checkConfigurations(1, 3));
+        ASSERT_EQUALS(expected, checkConfigurations(2, 8));
+    }
+
+    void uniqueErrors() const {
+        // The leak of c is found in every configuration but is reported once
+        const std::string messages = checkConfigurations(1);
+        const std::string::size_type pos = messages.find("Memory leak: c");
+        ASSERT_EQUALS(true, pos != std::string::npos);
+        ASSERT_EQUALS(std::string::npos, messages.find("Memory leak: c", pos + 1));
+    }
+
+#ifndef _WIN32
+    static void removeDirectory(const char path[]) {
+        if (DIR *dir = opendir(path)) {
+            while (const struct dirent *entry = readdir(dir)) {
+                if (entry->d_name[0] != '.')
+                    std::remove((path + ('/' + std::string(entry->d_name))).c_str());
+            }
+            closedir(dir);
+        }
+        rmdir(path);
+    }
+
+    static std::string checkIncremental(const std::string &filename) {
+        ErrorLogger3 errorLogger;
+        CppCheck cppCheck(errorLogger, true);
+        cppCheck.settings()._errorsOnly = true;
+        cppCheck.settings().incrementalDir = "testincremental";
+        cppCheck.check(filename);
+        return errorLogger.messages;
+    }
+
+    void incrementalMissingHeader() const {
+        // The results are stored while the header is missing, they can't
+        // be used when the include is resolved later
+        mkdir("testincremental", 0777);
+        std::remove("testincremental.h");
+        {
+            std::ofstream fout("testincremental.c");
+            fout << "#include \"testincremental.h\"\n"
+                 << "void f() { char a[2]; a[INDEX] = 0; }\n";
+        }
+        // The missing include is reported when the results are replayed too
+        Preprocessor::missingIncludeFlag = false;
+        ASSERT_EQUALS("", checkIncremental("testincremental.c"));
+        ASSERT_EQUALS(true, Preprocessor::missingIncludeFlag);
+        Preprocessor::missingIncludeFlag = false;
+        ASSERT_EQUALS("", checkIncremental("testincremental.c"));
+        ASSERT_EQUALS(true, Preprocessor::missingIncludeFlag);
+
+        {
+            std::ofstream fout("testincremental.h");
+            fout << "#define INDEX 2\n";
+        }
+        Preprocessor::missingIncludeFlag = false;
+        ASSERT_EQUALS("[testincremental.c:2]: (error) Array 'a[2]' accessed at index 2, which is out of bounds.\n",
+                      checkIncremental("testincremental.c"));
+        ASSERT_EQUALS(false, Preprocessor::missingIncludeFlag);
+
+        std::remove("testincremental.c");
+        std::remove("testincremental.h");
+        removeDirectory("testincremental");
+    }
+
+    static std::string checkCached(const std::string &filename) {
+        ErrorLogger3 errorLogger;
+        CppCheck cppCheck(errorLogger, true);
+        cppCheck.settings()._errorsOnly = true;
+        cppCheck.settings().checkHeadersOnce = true;
+        cppCheck.settings().cacheDir = "testcachedir";
+        cppCheck.check(filename);
+        return errorLogger.messages;
+    }
+
+    void cacheCheckHeadersOnce() const {
+        // The results of b.c are not stored, the code of the header was
+        // left out because it was checked for a.c
+        removeDirectory("testcachedir");
+        mkdir("testcachedir", 0777);
+        {
+            std::ofstream fout("testcachedir.h");
+            fout << "void g() { char *p = malloc(10); }\n";
+        }
+        {
+            std::ofstream fout("testcachedir-a.c");
+            fout << "#include \"testcachedir.h\"\n";
+        }
+        {
+            std::ofstream fout("testcachedir-b.c");
+            fout << "#include \"testcachedir.h\"\n";
+        }
+        const std::string expected("[testcachedir.h:1]: (error) Memory leak: p\n");
+        Tokenizer::clearCheckedHeaders();
+        ASSERT_EQUALS(expected, checkCached("testcachedir-a.c"));
+        ASSERT_EQUALS("", checkCached("testcachedir-b.c"));
+
+        // another run that checks b.c only
+        Tokenizer::clearCheckedHeaders();
+        ASSERT_EQUALS(expected, checkCached("testcachedir-b.c"));
+
+        Tokenizer::clearCheckedHeaders();
+        std::remove("testcachedir.h");
+        std::remove("testcachedir-a.c");
+        std::remove("testcachedir-b.c");
+        removeDirectory("testcachedir");
+    }
+#endif
 };
 
 REGISTER_TEST(TestCppcheck)
@@ -50,6 +50,8 @@ private:
 
         // Serialize / Deserialize inconclusive message
         TEST_CASE(SerializeInconclusiveMessage);
+        TEST_CASE(SerializeBinary);
+        TEST_CASE(Fingerprint);
 
         TEST_CASE(suppressUnmatchedSuppressions);
     }
@@ -318,6 +320,45 @@ private:
         ASSERT_EQUALS("Programming error", msg2.verboseMessage());
     }
 
+    void SerializeBinary() const {
+        std::list<ErrorLogger::ErrorMessage::FileLocation> locs;
+        locs.push_back(ErrorLogger::ErrorMessage::FileLocation("foo.cpp", 5));
+        locs.push_back(ErrorLogger::ErrorMessage::FileLocation("dir/bar.h", 12));
+        ErrorMessage msg(locs, Severity::warning, "Programming error.\nVerbose error", "errorId", true);
+
+        std::string data;
+        msg.serializeBinary(data);
+
+        ErrorMessage msg2;
+        ASSERT_EQUALS(true, msg2.deserializeBinary(data.data(), data.size()));
+        ASSERT_EQUALS("errorId", msg2._id);
+        ASSERT_EQUALS(Severity::warning, msg2._severity);
+        ASSERT_EQUALS(true, msg2._inconclusive);
+        ASSERT_EQUALS("Programming error.", msg2.shortMessage());
+        ASSERT_EQUALS("Verbose error", msg2.verboseMessage());
+        ASSERT_EQUALS(msg.toString(true), msg2.toString(true));
+
+        // Truncated data
+        ErrorMessage msg3;
+        ASSERT_EQUALS(false, msg3.deserializeBinary(data.data(), data.size() - 1));
+    }
+
+    void Fingerprint() const {
+        std::list<ErrorLogger::ErrorMessage::FileLocation> locs(1, ErrorLogger::ErrorMessage::FileLocation("foo.cpp", 5));
+        const ErrorMessage msg(locs, Severity::error, "Programming error.\nVerbose error", "errorId", false);
+        const ErrorMessage same(locs, Severity::error, "Programming error.\nVerbose error", "errorId", false);
+        const ErrorMessage otherVerbose(locs, Severity::error, "Programming error.\nOther verbose error", "errorId", false);
+        const ErrorMessage inconclusive(locs, Severity::error, "Programming error.\nVerbose error", "errorId", true);
+        std::list<ErrorLogger::ErrorMessage::FileLocation> locs2(1, ErrorLogger::ErrorMessage::FileLocation("foo.cpp", 6));
+        const ErrorMessage otherLine(locs2, Severity::error, "Programming error.\nVerbose error", "errorId", false);
+
+        ASSERT_EQUALS(true, msg.fingerprint(false) == same.fingerprint(false));
+        ASSERT_EQUALS(true, msg.fingerprint(false) == otherVerbose.fingerprint(false));
+        ASSERT_EQUALS(false, msg.fingerprint(true) == otherVerbose.fingerprint(true));
+        ASSERT_EQUALS(false, msg.fingerprint(false) == inconclusive.fingerprint(false));
+        ASSERT_EQUALS(false, msg.fingerprint(false) == otherLine.fingerprint(false));
+    }
+
     void suppressUnmatchedSuppressions() {
         std::list<Suppressions::SuppressionEntry> suppressions;
 
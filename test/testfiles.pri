@@ -4,6 +4,7 @@ INCLUDEPATH += ../externals/tinyxml
 
 
 SOURCES += $${BASEPATH}/test64bit.cpp \
+           $${BASEPATH}/testanalysisserver.cpp \
            $${BASEPATH}/testassert.cpp \
            $${BASEPATH}/testassignif.cpp \
            $${BASEPATH}/testautovariables.cpp \
@@ -13,15 +14,18 @@ SOURCES += $${BASEPATH}/test64bit.cpp \
            $${BASEPATH}/testcharvar.cpp \
            $${BASEPATH}/testclass.cpp \
            $${BASEPATH}/testcmdlineparser.cpp \
+           $${BASEPATH}/testcompiledatabase.cpp \
            $${BASEPATH}/testconstructors.cpp \
            $${BASEPATH}/testcppcheck.cpp \
            $${BASEPATH}/testdivision.cpp \
            $${BASEPATH}/testerrorlogger.cpp \
            $${BASEPATH}/testexceptionsafety.cpp \
            $${BASEPATH}/testfilelister.cpp \
+           $${BASEPATH}/testfilescheduler.cpp \
            $${BASEPATH}/testincompletestatement.cpp \
            $${BASEPATH}/testinternal.cpp \
            $${BASEPATH}/testio.cpp \
+           $${BASEPATH}/testjobserver.cpp \
            $${BASEPATH}/testleakautovar.cpp \
            $${BASEPATH}/testmathlib.cpp \
            $${BASEPATH}/testmemleak.cpp \
@@ -34,6 +38,7 @@ SOURCES += $${BASEPATH}/test64bit.cpp \
            $${BASEPATH}/testpathmatch.cpp \
            $${BASEPATH}/testpostfixoperator.cpp \
            $${BASEPATH}/testpreprocessor.cpp \
+           $${BASEPATH}/testresultscache.cpp \
            $${BASEPATH}/testrunner.cpp \
            $${BASEPATH}/testsimplifytokens.cpp \
            $${BASEPATH}/testsizeof.cpp \
@@ -0,0 +1,170 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2013 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "testsuite.h"
+#include "filescheduler.h"
+#include <sstream>
+
+class TestFileScheduler : public TestFixture {
+public:
+    TestFileScheduler() : TestFixture("TestFileScheduler")
+    { }
+
+private:
+    void run() {
+        TEST_CASE(orderBySize);
+        TEST_CASE(orderByName);
+        TEST_CASE(orderByTimings);
+        TEST_CASE(shard);
+        TEST_CASE(shardIgnoresTimings);
+        TEST_CASE(estimateFromTimings);
+        TEST_CASE(loadTimings);
+        TEST_CASE(saveTimings);
+        TEST_CASE(memory);
+        TEST_CASE(estimateMemory);
+    }
+
+    static std::string join(const std::vector<std::string> &files) {
+        std::string ret;
+        for (std::vector<std::string>::const_iterator it = files.begin(); it != files.end(); ++it)
+            ret += (ret.empty() ? "" : " ") + *it;
+        return ret;
+    }
+
+    void orderBySize() const {
+        std::map<std::string, std::size_t> files;
+        files["a.c"] = 10;
+        files["b.c"] = 1000;
+        files["c.c"] = 100;
+        const FileScheduler scheduler(files);
+        ASSERT_EQUALS("b.c c.c a.c", join(scheduler.order()));
+    }
+
+    void orderByName() const {
+        // files with the same cost are kept in alphabetical order
+        std::map<std::string, std::size_t> files;
+        files["c.c"] = 10;
+        files["a.c"] = 10;
+        files["b.c"] = 10;
+        const FileScheduler scheduler(files);
+        ASSERT_EQUALS("a.c b.c c.c", join(scheduler.order()));
+    }
+
+    void orderByTimings() const {
+        // a small file that took long to check in the previous run is started first
+        std::map<std::string, std::size_t> files;
+        files["a.c"] = 10;
+        files["b.c"] = 1000;
+        FileScheduler scheduler(files);
+        scheduler.setTiming("a.c", 5.0);
+        scheduler.setTiming("b.c", 0.5);
+        ASSERT_EQUALS("a.c b.c", join(scheduler.order()));
+    }
+
+    void shard() const {
+        // 1000 | 600 + 300 + 100 | 500 + 400 + 10
+        std::map<std::string, std::size_t> files;
+        files["a.c"] = 1000;
+        files["b.c"] = 600;
+        files["c.c"] = 500;
+        files["d.c"] = 400;
+        files["e.c"] = 300;
+        files["f.c"] = 100;
+        files["g.c"] = 10;
+        const FileScheduler scheduler(files);
+        ASSERT_EQUALS("a.c", join(scheduler.shard(0, 3)));
+        ASSERT_EQUALS("b.c e.c f.c", join(scheduler.shard(1, 3)));
+        ASSERT_EQUALS("c.c d.c g.c", join(scheduler.shard(2, 3)));
+        ASSERT_EQUALS("a.c b.c c.c d.c e.c f.c g.c", join(scheduler.shard(0, 1)));
+        ASSERT_EQUALS("", join(scheduler.shard(7, 8)));
+    }
+
+    void shardIgnoresTimings() const {
+        // the timings differ between the machines, the sizes don't
+        std::map<std::string, std::size_t> files;
+        files["a.c"] = 10;
+        files["b.c"] = 1000;
+        FileScheduler scheduler(files);
+        scheduler.setTiming("a.c", 5.0);
+        ASSERT_EQUALS("b.c", join(scheduler.shard(0, 2)));
+        ASSERT_EQUALS("a.c", join(scheduler.shard(1, 2)));
+    }
+
+    void estimateFromTimings() const {
+        // 1000 bytes took 2 seconds => the new 1500 byte file is estimated to take 3 seconds
+        std::map<std::string, std::size_t> files;
+        files["a.c"] = 1000;
+        files["b.c"] = 1500;
+        files["c.c"] = 100;
+        FileScheduler scheduler(files);
+        scheduler.setTiming("a.c", 2.0);
+        ASSERT_EQUALS(true, scheduler.cost("b.c") > 2.99 && scheduler.cost("b.c") < 3.01);
+        ASSERT_EQUALS("b.c a.c c.c", join(scheduler.order()));
+    }
+
+    void loadTimings() const {
+        std::map<std::string, std::size_t> files;
+        files["a.c"] = 10;
+        files["my file.c"] = 10;
+        files["c.c"] = 1000;
+        FileScheduler scheduler(files);
+        std::istringstream istr("0.5 a.c\n"
+                                "garbage\n"
+                                "-1 c.c\n"
+                                "2.25 my file.c\n");
+        scheduler.loadTimings(istr);
+        ASSERT_EQUALS(true, scheduler.cost("a.c") > 0.49 && scheduler.cost("a.c") < 0.51);
+        ASSERT_EQUALS(true, scheduler.cost("my file.c") > 2.24 && scheduler.cost("my file.c") < 2.26);
+        ASSERT_EQUALS("c.c my file.c a.c", join(scheduler.order()));
+    }
+
+    void saveTimings() const {
+        // timings of files that are not checked in this run are kept
+        std::map<std::string, std::size_t> files;
+        files["a.c"] = 10;
+        FileScheduler scheduler(files);
+        std::istringstream istr("1.5 old.c\n");
+        scheduler.loadTimings(istr);
+        scheduler.setTiming("a.c", 0.25);
+        std::ostringstream ostr;
+        scheduler.saveTimings(ostr);
+        ASSERT_EQUALS("0.25 a.c\n1.5 old.c\n", ostr.str());
+    }
+
+    void memory() const {
+        std::map<std::string, std::size_t> files;
+        files["a.c"] = 1000;
+        FileScheduler scheduler(files);
+        ASSERT_EQUALS(100000U, scheduler.memory("a.c"));
+        scheduler.setMemory("a.c", 5000);
+        ASSERT_EQUALS(5000U, scheduler.memory("a.c"));
+        ASSERT_EQUALS(0U, scheduler.memory("unknown.c"));
+    }
+
+    void estimateMemory() const {
+        // 1000 bytes needed 2 MB => the 500 byte file is estimated to need 1 MB
+        std::map<std::string, std::size_t> files;
+        files["a.c"] = 1000;
+        files["b.c"] = 500;
+        FileScheduler scheduler(files);
+        scheduler.setMemory("a.c", 2000000);
+        ASSERT_EQUALS(1000000U, scheduler.memory("b.c"));
+    }
+};
+
+REGISTER_TEST(TestFileScheduler)
@@ -0,0 +1,191 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2013 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "testsuite.h"
+#include "jobserver.h"
+#include <sstream>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+class TestJobServer : public TestFixture {
+public:
+    TestJobServer() : TestFixture("TestJobServer")
+    { }
+
+private:
+    void run() {
+        TEST_CASE(parseAuth);
+        TEST_CASE(parseFds);
+        TEST_CASE(parseFifo);
+        TEST_CASE(parseLastOption);
+        TEST_CASE(parseNoJobServer);
+        TEST_CASE(parseInvalid);
+#ifndef _WIN32
+        TEST_CASE(acquireRelease);
+        TEST_CASE(releaseOnDestruction);
+        TEST_CASE(closedDescriptors);
+        TEST_CASE(noNonBlockingDescriptor);
+#endif
+    }
+
+    void parseAuth() const {
+        JobServer jobServer;
+        ASSERT_EQUALS(true, jobServer.parse(" -j8 --jobserver-auth=3,4"));
+        ASSERT_EQUALS(3, jobServer.authReadFd());
+        ASSERT_EQUALS(4, jobServer.authWriteFd());
+        ASSERT_EQUALS("", jobServer.fifo());
+    }
+
+    void parseFds() const {
+        // option used by make 4.1 and older
+        JobServer jobServer;
+        ASSERT_EQUALS(true, jobServer.parse("w --jobserver-fds=5,6 -j"));
+        ASSERT_EQUALS(5, jobServer.authReadFd());
+        ASSERT_EQUALS(6, jobServer.authWriteFd());
+    }
+
+    void parseFifo() const {
+        JobServer jobServer;
+        ASSERT_EQUALS(true, jobServer.parse("-j4 --jobserver-auth=fifo:/tmp/GMfifo123"));
+        ASSERT_EQUALS("/tmp/GMfifo123", jobServer.fifo());
+        ASSERT_EQUALS(-1, jobServer.authReadFd());
+    }
+
+    void parseLastOption() const {
+        JobServer jobServer;
+        ASSERT_EQUALS(true, jobServer.parse("--jobserver-auth=3,4 --jobserver-fds=5,6 --jobserver-auth=7,8"));
+        ASSERT_EQUALS(7, jobServer.authReadFd());
+        ASSERT_EQUALS(8, jobServer.authWriteFd());
+    }
+
+    void parseNoJobServer() const {
+        JobServer jobServer;
+        ASSERT_EQUALS(false, jobServer.parse(""));
+        ASSERT_EQUALS(false, jobServer.parse("-k -- CC=gcc"));
+        ASSERT_EQUALS(false, jobServer.connected());
+    }
+
+    void parseInvalid() const {
+        JobServer jobServer;
+        ASSERT_EQUALS(false, jobServer.parse("--jobserver-auth=3"));
+        ASSERT_EQUALS(false, jobServer.parse("--jobserver-auth=,4"));
+        ASSERT_EQUALS(false, jobServer.parse("--jobserver-auth=3,"));
+        ASSERT_EQUALS(false, jobServer.parse("--jobserver-auth=gmake_semaphore_1234"));
+        ASSERT_EQUALS(false, jobServer.parse("--jobserver-auth=fifo:"));
+    }
+
+#ifndef _WIN32
+    /** @brief The bytes that are in the pipe */
+    static std::string readAll(int fd) {
+        const int flags = fcntl(fd, F_GETFL, 0);
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        std::string ret;
+        char c;
+        while (read(fd, &c, 1) == 1)
+            ret += c;
+        fcntl(fd, F_SETFL, flags);
+        return ret;
+    }
+
+    static std::string makeflags(const int fds[2]) {
+        std::ostringstream oss;
+        oss << "-j3 --jobserver-auth=" << fds[0] << ',' << fds[1];
+        return oss.str();
+    }
+
+    void acquireRelease() const {
+        // A stand-in for make: a pipe with two tokens
+        int fds[2];
+        ASSERT_EQUALS(0, pipe(fds));
+        ASSERT_EQUALS(2, write(fds[1], "ab", 2));
+
+        JobServer jobServer;
+        ASSERT_EQUALS(true, jobServer.parse(makeflags(fds)));
+        ASSERT_EQUALS(true, jobServer.connect());
+        ASSERT_EQUALS(true, jobServer.tryAcquire());
+        ASSERT_EQUALS(true, jobServer.tryAcquire());
+        ASSERT_EQUALS(false, jobServer.tryAcquire());
+        ASSERT_EQUALS(2U, jobServer.tokens());
+        ASSERT_EQUALS("", readAll(fds[0]));
+
+        // the same bytes are given back
+        jobServer.release();
+        ASSERT_EQUALS(1U, jobServer.tokens());
+        ASSERT_EQUALS("b", readAll(fds[0]));
+        jobServer.releaseAll();
+        ASSERT_EQUALS(0U, jobServer.tokens());
+        ASSERT_EQUALS("a", readAll(fds[0]));
+
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+    void releaseOnDestruction() const {
+        int fds[2];
+        ASSERT_EQUALS(0, pipe(fds));
+        ASSERT_EQUALS(1, write(fds[1], "+", 1));
+        {
+            JobServer jobServer;
+            jobServer.parse(makeflags(fds));
+            jobServer.connect();
+            ASSERT_EQUALS(true, jobServer.tryAcquire());
+        }
+        ASSERT_EQUALS("+", readAll(fds[0]));
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+    void closedDescriptors() const {
+        // make did not pass the descriptors to this process
+        int fds[2];
+        ASSERT_EQUALS(0, pipe(fds));
+        close(fds[0]);
+        close(fds[1]);
+
+        JobServer jobServer;
+        ASSERT_EQUALS(true, jobServer.parse(makeflags(fds)));
+        ASSERT_EQUALS(false, jobServer.connect());
+        ASSERT_EQUALS(false, jobServer.tryAcquire());
+    }
+
+    void noNonBlockingDescriptor() const {
+        // A socket can't be opened again through /proc, a blocking read on
+        // the shared descriptor could wait for another client's token, so
+        // the jobserver is not used
+        int fds[2];
+        ASSERT_EQUALS(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+        ASSERT_EQUALS(1, write(fds[1], "x", 1));
+
+        JobServer jobServer;
+        ASSERT_EQUALS(true, jobServer.parse(makeflags(fds)));
+        ASSERT_EQUALS(false, jobServer.connect());
+        ASSERT_EQUALS(false, jobServer.tryAcquire());
+        ASSERT_EQUALS(0U, jobServer.tokens());
+
+        close(fds[0]);
+        close(fds[1]);
+    }
+#endif
+};
+
+REGISTER_TEST(TestJobServer)
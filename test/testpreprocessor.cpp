@@ -27,6 +27,8 @@
 #include "token.h"
 #include "settings.h"
 
+#include <cstdio>
+#include <fstream>
 #include <map>
 #include <string>
 #include <sstream>
@@ -288,6 +290,9 @@ private:
         TEST_CASE(validateCfg);
 
         TEST_CASE(if_sizeof);
+
+        TEST_CASE(headerCache);
+        TEST_CASE(headerConfigurations);
     }
 
 
@@ -3784,6 +3789,97 @@ private:
         preprocessor.preprocess(istr, actual, "file.c");
         ASSERT_EQUALS("\nFred & Wilma\n\n\n\n\n", actual[""]);
     }
+
+    void headerCache() {
+        const std::list<std::string> includePaths;
+        std::map<std::string,std::string> defs;
+        Preprocessor::clearHeaderCache();
+
+        {
+            std::ofstream fout("headercache.h");
+            fout << "int a;\n";
+        }
+        {
+            Preprocessor preprocessor(NULL, this);
+            const std::string actual(preprocessor.handleIncludes("#include \"headercache.h\"\n", "test.c", includePaths, defs));
+            ASSERT_EQUALS("#file \"headercache.h\"\nint a;\n\n#endfile\n", actual);
+        }
+
+        // the header is read again when it has changed
+        {
+            std::ofstream fout("headercache.h");
+            fout << "int bb;\n";
+        }
+        {
+            Preprocessor preprocessor(NULL, this);
+            const std::string actual(preprocessor.handleIncludes("#include \"headercache.h\"\n", "test.c", includePaths, defs));
+            ASSERT_EQUALS("#file \"headercache.h\"\nint bb;\n\n#endfile\n", actual);
+        }
+
+        // a change that keeps the size, right after the previous one, so
+        // the modification time can be the same
+        {
+            std::ofstream fout("headercache.h");
+            fout << "int cc;\n";
+        }
+        {
+            Preprocessor preprocessor(NULL, this);
+            const std::string actual(preprocessor.handleIncludes("#include \"headercache.h\"\n", "test.c", includePaths, defs));
+            ASSERT_EQUALS("#file \"headercache.h\"\nint cc;\n\n#endfile\n", actual);
+        }
+
+        // inline suppressions are added for every file that includes the header
+        {
+            std::ofstream fout("headercache.h");
+            fout << "// cppcheck-suppress foo\nint c;\n";
+        }
+        for (int i = 0; i < 2; ++i) {
+            Settings settings;
+            settings._inlineSuppressions = true;
+            Preprocessor preprocessor(&settings, this);
+            preprocessor.handleIncludes("#include \"headercache.h\"\n", "test.c", includePaths, defs);
+            ASSERT_EQUALS(true, settings.nomsg.isSuppressed("foo", "headercache.h", 2));
+        }
+
+        ASSERT_EQUALS(0, std::remove("headercache.h"));
+        Preprocessor::clearHeaderCache();
+    }
+
+    std::string getConfigurations(const char code[]) {
+        std::istringstream istr(code);
+        std::string filedata;
+        std::list<std::string> configurations;
+        Settings settings;
+        Preprocessor preprocessor(&settings, this);
+        preprocessor.preprocess(istr, filedata, configurations, "test.c", std::list<std::string>());
+        std::string ret;
+        for (std::list<std::string>::const_iterator it = configurations.begin(); it != configurations.end(); ++it)
+            ret += (it == configurations.begin() ? "" : "\n") + *it;
+        return ret;
+    }
+
+    void headerConfigurations() {
+        Preprocessor::clearHeaderCache();
+        {
+            std::ofstream fout("headerconfigurations.h");
+            fout << "int x;\n#ifdef A\n#endif\n#if B == 1\n#endif\n";
+        }
+
+        // The configurations of the header are found again when they are reused
+        ASSERT_EQUALS("\nA\nB=1", getConfigurations("#include \"headerconfigurations.h\"\n"));
+        ASSERT_EQUALS("\nA\nB=1", getConfigurations("int x;\n#include \"headerconfigurations.h\"\n"));
+
+        // The conditions of the header depend on the macros defined before it
+        ASSERT_EQUALS("\nA", getConfigurations("#define B 1\n#include \"headerconfigurations.h\"\n"));
+        ASSERT_EQUALS("\nA\nB=1", getConfigurations("#define C 1\n#include \"headerconfigurations.h\"\n"));
+
+        // The configurations in the header depend on the open conditions
+        ASSERT_EQUALS("\nA;C\nB=1;C\nC", getConfigurations("#ifdef C\n#include \"headerconfigurations.h\"\n#endif\n"));
+        ASSERT_EQUALS("\nA;C\nB=1;C\nC", getConfigurations("#ifdef C\n#include \"headerconfigurations.h\"\n#endif\n"));
+
+        ASSERT_EQUALS(0, std::remove("headerconfigurations.h"));
+        Preprocessor::clearHeaderCache();
+    }
 };
 
 REGISTER_TEST(TestPreprocessor)
@@ -0,0 +1,129 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2013 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "testsuite.h"
+#include "resultscache.h"
+#include "settings.h"
+#include <cstdio>
+
+class TestResultsCache : public TestFixture {
+public:
+    TestResultsCache() : TestFixture("TestResultsCache")
+    { }
+
+private:
+    void run() {
+        TEST_CASE(key);
+        TEST_CASE(keySettings);
+        TEST_CASE(records);
+        TEST_CASE(invalidRecords);
+        TEST_CASE(saveLoad);
+    }
+
+    void key() const {
+        const Settings settings;
+        const unsigned long long key = ResultsCache::key("int a;", "a.c", "", settings);
+        ASSERT_EQUALS(key, ResultsCache::key("int a;", "a.c", "", settings));
+        ASSERT(key != ResultsCache::key("int b;", "a.c", "", settings));
+        ASSERT(key != ResultsCache::key("int a;", "b.c", "", settings));
+        ASSERT(key != ResultsCache::key("int a;", "a.c", "A", settings));
+
+        // the strings are not simply concatenated
+        ASSERT(ResultsCache::key("int a;", "a.c", "", settings) != ResultsCache::key("a.c", "int a;", "", settings));
+        ASSERT(ResultsCache::key("x", "ab", "", settings) != ResultsCache::key("x", "a", "b", settings));
+    }
+
+    void keySettings() const {
+        Settings settings1;
+        const unsigned long long key = ResultsCache::key("int a;", "a.c", "", settings1);
+
+        Settings settings2;
+        settings2.addEnabled("style");
+        ASSERT(key != ResultsCache::key("int a;", "a.c", "", settings2));
+
+        Settings settings3;
+        settings3.inconclusive = true;
+        ASSERT(key != ResultsCache::key("int a;", "a.c", "", settings3));
+
+        Settings settings4;
+        settings4.platform(Settings::Win64);
+        ASSERT(key != ResultsCache::key("int a;", "a.c", "", settings4));
+
+        // the file names in the messages are relative to the base paths
+        Settings settings6;
+        settings6._relativePaths = true;
+        settings6._basePaths.push_back("/home/user/project");
+        const unsigned long long key6 = ResultsCache::key("int a;", "a.c", "", settings6);
+        ASSERT(key != key6);
+        settings6._basePaths[0] = "/home/user";
+        ASSERT(key6 != ResultsCache::key("int a;", "a.c", "", settings6));
+
+        // settings that don't change the results
+        Settings settings5;
+        settings5._verbose = true;
+        settings5._jobs = 4;
+        ASSERT_EQUALS(key, ResultsCache::key("int a;", "a.c", "", settings5));
+    }
+
+    void records() const {
+        std::string data;
+        ResultsCache::addRecord(data, 'E', "error");
+        ResultsCache::addRecord(data, 'O', "");
+        ResultsCache::addRecord(data, 'D', std::string("a\0b", 3));
+
+        std::vector<std::pair<char, std::string> > records;
+        ASSERT_EQUALS(true, ResultsCache::getRecords(data, records));
+        ASSERT_EQUALS(3U, records.size());
+        ASSERT_EQUALS('E', records[0].first);
+        ASSERT_EQUALS("error", records[0].second);
+        ASSERT_EQUALS('O', records[1].first);
+        ASSERT_EQUALS("", records[1].second);
+        ASSERT_EQUALS('D', records[2].first);
+        ASSERT_EQUALS(std::string("a\0b", 3), records[2].second);
+    }
+
+    void invalidRecords() const {
+        std::string data;
+        ResultsCache::addRecord(data, 'E', "error");
+
+        // truncated file
+        std::vector<std::pair<char, std::string> > records;
+        ASSERT_EQUALS(false, ResultsCache::getRecords(data.substr(0, data.size() - 1), records));
+        ASSERT_EQUALS(false, ResultsCache::getRecords(data.substr(0, 3), records));
+        ASSERT_EQUALS(true, ResultsCache::getRecords("", records));
+        ASSERT_EQUALS(0U, records.size());
+    }
+
+    void saveLoad() const {
+        const ResultsCache cache(".");
+        const unsigned long long key = 0x0123456789abcdefULL;
+        std::vector<std::pair<char, std::string> > records;
+        ASSERT_EQUALS(false, cache.load(key, records));
+
+        std::string data;
+        ResultsCache::addRecord(data, 'E', "error");
+        ASSERT_EQUALS(true, cache.save(key, data));
+        ASSERT_EQUALS(true, cache.load(key, records));
+        ASSERT_EQUALS(1U, records.size());
+        ASSERT_EQUALS("error", records[0].second);
+
+        ASSERT_EQUALS(0, std::remove("./0123456789abcdef.results"));
+    }
+};
+
+REGISTER_TEST(TestResultsCache)
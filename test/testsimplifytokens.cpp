@@ -294,6 +294,7 @@ private:
         TEST_CASE(simplifyTypedef105); // ticket #3616
         TEST_CASE(simplifyTypedef106); // ticket #3619
         TEST_CASE(simplifyTypedef107); // ticket #3963 - bad code => segmentation fault
+        TEST_CASE(simplifyTypedefUnnamed);
 
         TEST_CASE(simplifyTypedefFunction1);
         TEST_CASE(simplifyTypedefFunction2); // ticket #1685
@@ -3980,17 +3981,35 @@ private:
         const char expected[] =
             "union t { int a ; float b ; } ; "
             "union U { int a ; float b ; } ; "
-            "union Unnamed1 { int a ; float b ; } ; "
+            "union Unnamed0 { int a ; float b ; } ; "
             "union s s ; "
             "union s * ps ; "
             "union t t ; "
             "union t * tp ; "
             "union U u ; "
-            "union Unnamed1 * v ;";
+            "union Unnamed0 * v ;";
 
         ASSERT_EQUALS(expected, tok(code, false));
     }
 
+    void simplifyTypedefUnnamed() {
+        // the names of unnamed structs are numbered per file, so they do
+        // not depend on what was checked before
+        const char code[] = "typedef struct { int a; } * A;\n"
+                            "typedef union { int b; } * B;\n"
+                            "A a;\n"
+                            "B b;";
+
+        const char expected[] =
+            "struct Unnamed0 { int a ; } ; "
+            "union Unnamed1 { int b ; } ; "
+            "struct Unnamed0 * a ; "
+            "union Unnamed1 * b ;";
+
+        ASSERT_EQUALS(expected, tok(code, false));
+        ASSERT_EQUALS(expected, tok(code, false));
+    }
+
     void simplifyTypedef11() {
         const char code[] = "typedef enum { a = 0 , b = 1 , c = 2 } abc;\n"
                             "typedef enum xyz { x = 0 , y = 1 , z = 2 } XYZ;\n"
@@ -4151,10 +4170,10 @@ private:
                                 "C c;";
 
             const char expected[] =
-                "struct Unnamed2 { } ; "
-                "struct Unnamed2 * * * * * * * * * * a ; "
-                "struct Unnamed2 * b ; "
-                "struct Unnamed2 c ;";
+                "struct Unnamed0 { } ; "
+                "struct Unnamed0 * * * * * * * * * * a ; "
+                "struct Unnamed0 * b ; "
+                "struct Unnamed0 c ;";
 
             ASSERT_EQUALS(expected, tok(code, false));
         }
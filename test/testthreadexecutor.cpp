@@ -28,10 +28,31 @@
 
 #include <map>
 #include <string>
+#include <cstdlib>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#endif
 
 extern std::ostringstream errout;
 extern std::ostringstream output;
 
+#ifndef _WIN32
+/** A worker that crashes after it has reported an error */
+class CrashingExecutor : public ThreadExecutor {
+public:
+    CrashingExecutor(const std::map<std::string, std::size_t> &files, Settings &settings, ErrorLogger &errorLogger)
+        : ThreadExecutor(files, settings, errorLogger)
+    { }
+
+    virtual void reportErr(const ErrorLogger::ErrorMessage &msg) {
+        ThreadExecutor::reportErr(msg);
+        std::abort();
+    }
+};
+#endif
+
 class TestThreadExecutor : public TestFixture {
 public:
     TestThreadExecutor() : TestFixture("TestThreadExecutor")
@@ -43,7 +64,7 @@ private:
      * Execute check using n jobs for y files which are have
      * identical data, given within data.
      */
-    void check(unsigned int jobs, int files, int result, const std::string &data) {
+    void check(unsigned int jobs, int files, int result, const std::string &data, Settings::Executor executorType = Settings::Process, bool jobServer = false, unsigned long long maxMemory = 0) {
         errout.str("");
         output.str("");
         if (!ThreadExecutor::isEnabled()) {
@@ -60,6 +81,9 @@ private:
 
         Settings settings;
         settings._jobs = jobs;
+        settings.executor = executorType;
+        settings.jobServer = jobServer;
+        settings.maxMemory = maxMemory;
         ThreadExecutor executor(filemap, settings, *this);
         for (std::map<std::string, std::size_t>::const_iterator i = filemap.begin(); i != filemap.end(); ++i)
             executor.addFileContent(i->first, data);
@@ -74,6 +98,18 @@ private:
         TEST_CASE(no_errors_equal_amount_files);
         TEST_CASE(one_error_less_files);
         TEST_CASE(one_error_several_files);
+        TEST_CASE(one_worker_several_files);
+        TEST_CASE(many_errors_several_files);
+        TEST_CASE(threads_no_errors_more_files);
+        TEST_CASE(threads_one_error_several_files);
+        TEST_CASE(threads_many_errors);
+        TEST_CASE(max_memory_processes);
+        TEST_CASE(max_memory_threads);
+#ifndef _WIN32
+        TEST_CASE(jobserver_processes);
+        TEST_CASE(jobserver_threads);
+        TEST_CASE(crash_keeps_messages);
+#endif
     }
 
     void deadlock_with_many_errors() {
@@ -134,6 +170,136 @@ private:
         oss << "}\n";
         check(2, 20, 20, oss.str());
     }
+
+    void one_worker_several_files() {
+        // The same worker process checks all files
+        std::ostringstream oss;
+        oss << "int main()\n"
+            << "{\n";
+        oss << "  {char *a = malloc(10);}\n";
+        oss << "  return 0;\n";
+        oss << "}\n";
+        check(1, 10, 10, oss.str());
+    }
+
+    void many_errors_several_files() {
+        std::ostringstream oss;
+        oss << "int main()\n"
+            << "{\n";
+        for (int i = 0; i < 500; i++)
+            oss << "  {char *a = malloc(10);}\n";
+
+        oss << "  return 0;\n";
+        oss << "}\n";
+        check(2, 8, 8, oss.str());
+    }
+
+    void threads_no_errors_more_files() {
+        std::ostringstream oss;
+        oss << "int main()\n"
+            << "{\n";
+        oss << "  return 0;\n";
+        oss << "}\n";
+        check(2, 3, 0, oss.str(), Settings::Thread);
+    }
+
+    void threads_one_error_several_files() {
+        std::ostringstream oss;
+        oss << "int main()\n"
+            << "{\n";
+        oss << "  {char *a = malloc(10);}\n";
+        oss << "  return 0;\n";
+        oss << "}\n";
+        check(4, 20, 20, oss.str(), Settings::Thread);
+    }
+
+    void threads_many_errors() {
+        std::ostringstream oss;
+        oss << "int main()\n"
+            << "{\n";
+        for (int i = 0; i < 500; i++)
+            oss << "  {char *a = malloc(10);}\n";
+
+        oss << "  return 0;\n";
+        oss << "}\n";
+        check(3, 5, 5, oss.str(), Settings::Thread);
+    }
+
+    static std::string smallFile() {
+        std::ostringstream oss;
+        oss << "int main()\n"
+            << "{\n";
+        oss << "  {char *a = malloc(10);}\n";
+        oss << "  return 0;\n";
+        oss << "}\n";
+        return oss.str();
+    }
+
+    void max_memory_processes() {
+        // The budget is too small for two files, they are checked one at a time
+        check(3, 4, 4, smallFile(), Settings::Process, false, 1024);
+        ASSERT_EQUALS(true, output.str().find("Delayed by --max-memory: file_2.cpp") != std::string::npos);
+    }
+
+    void max_memory_threads() {
+        // Which files are delayed depends on how fast the threads are
+        check(3, 4, 4, smallFile(), Settings::Thread, false, 1024);
+    }
+
+#ifndef _WIN32
+    void jobserver(Settings::Executor executorType) {
+        // A stand-in for make: a pipe with two tokens
+        int fds[2];
+        ASSERT_EQUALS(0, pipe(fds));
+        ASSERT_EQUALS(2, write(fds[1], "++", 2));
+        std::ostringstream makeflags;
+        makeflags << "-j3 --jobserver-auth=" << fds[0] << ',' << fds[1];
+        setenv("MAKEFLAGS", makeflags.str().c_str(), 1);
+
+        std::ostringstream oss;
+        oss << "int main()\n"
+            << "{\n";
+        oss << "  {char *a = malloc(10);}\n";
+        oss << "  return 0;\n";
+        oss << "}\n";
+        check(4, 10, 10, oss.str(), executorType, true);
+        unsetenv("MAKEFLAGS");
+
+        // All tokens are given back
+        fcntl(fds[0], F_SETFL, O_NONBLOCK);
+        char tokens[3] = {0};
+        ASSERT_EQUALS(2, read(fds[0], tokens, 3));
+        ASSERT_EQUALS("++", tokens);
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+    void jobserver_processes() {
+        jobserver(Settings::Process);
+    }
+
+    void crash_keeps_messages() {
+        // The error that was found before the worker crashed is reported
+        errout.str("");
+        output.str("");
+        if (!ThreadExecutor::isEnabled())
+            return;
+
+        std::map<std::string, std::size_t> filemap;
+        filemap["file_1.cpp"] = 1;
+        Settings settings;
+        settings._jobs = 2;
+        CrashingExecutor executor(filemap, settings, *this);
+        executor.addFileContent("file_1.cpp", smallFile());
+        executor.check();
+        ASSERT_EQUALS("[file_1.cpp:4]: (error) Memory leak: a\n"
+                      "[file_1.cpp]: (error) Internal error: Child process crashed with signal 6\n", errout.str());
+    }
+
+    void jobserver_threads() {
+        jobserver(Settings::Thread);
+    }
+#endif
 };
 
 REGISTER_TEST(TestThreadExecutor)
@@ -23,6 +23,7 @@
 
 #include <vector>
 #include <string>
+#include <cstring>
 
 extern std::ostringstream errout;
 class TestToken : public TestFixture {
@@ -52,6 +53,9 @@ private:
         TEST_CASE(deleteLast);
         TEST_CASE(nextArgument);
         TEST_CASE(eraseTokens);
+        TEST_CASE(allocator);
+        TEST_CASE(internedStrings);
+        TEST_CASE(resetSymbols);
 
         TEST_CASE(matchAny);
         TEST_CASE(matchSingleChar);
@@ -66,6 +70,9 @@ private:
         TEST_CASE(matchOr);
         TEST_CASE(matchOp);
         TEST_CASE(matchConstOp);
+        TEST_CASE(matchChangedPattern);
+        TEST_CASE(matchLocalPattern);
+        TEST_CASE(matchCompiled);
 
         TEST_CASE(isArithmeticalOp);
         TEST_CASE(isOp);
@@ -297,6 +304,86 @@ private:
         ASSERT_EQUALS("begin ; end", code.tokens()->stringifyList(0, false));
     }
 
+    void allocator() const {
+        TokenList list(0);
+        list.addtoken("a", 1, 0);
+        list.addtoken("b", 1, 0);
+        list.addtoken("c", 1, 0);
+
+        // the appended tokens are next to each other
+        Token *a = list.front();
+        ASSERT(a->next() == a + 1);
+        ASSERT(a->tokAt(2) == a + 2);
+
+        // a new token gets the memory of a deleted token
+        Token * const b = a->next();
+        a->deleteNext();
+        a->insertToken("x");
+        ASSERT(a->next() == b);
+        ASSERT_EQUALS("a x c", list.front()->stringifyList(0, false));
+        ASSERT_EQUALS(4U, list.allocator().created());
+        ASSERT_EQUALS(1U, list.allocator().reused());
+        ASSERT_EQUALS(1U, list.allocator().slabs());
+
+        list.deallocateTokens();
+        ASSERT(list.front() == 0);
+        list.addtoken("d", 1, 0);
+        ASSERT_EQUALS("d", list.front()->str());
+        ASSERT_EQUALS(2U, list.allocator().slabs());
+    }
+
+    void internedStrings() const {
+        givenACodeSampleToTokenize code("x = x ( y ) ;", true);
+        const Token *tok = code.tokens();
+
+        // equal strings have the same address and id
+        ASSERT(&tok->str() == &tok->tokAt(2)->str());
+        ASSERT(&tok->str() == &Token::intern("x"));
+        ASSERT(&tok->str() != &tok->tokAt(4)->str());
+        ASSERT_EQUALS(tok->strId(), tok->tokAt(2)->strId());
+        ASSERT(tok->strId() != tok->tokAt(4)->strId());
+
+        // the common strings have fixed ids
+        ASSERT_EQUALS(1U, tok->tokAt(3)->strId());
+        ASSERT_EQUALS(2U, tok->tokAt(5)->strId());
+        ASSERT_EQUALS(7U, tok->tokAt(6)->strId());
+
+        // the string changes, the type follows
+        Token t(0);
+        ASSERT_EQUALS(0U, t.strId());
+        t.str("\"a\"");
+        ASSERT_EQUALS(Token::eString, t.type());
+        t.concatStr("\"b\"");
+        ASSERT_EQUALS("\"ab\"", t.str());
+        ASSERT(&t.str() == &Token::intern("\"ab\""));
+        t.str("int");
+        ASSERT_EQUALS(true, t.isStandardType());
+        ASSERT_EQUALS(Token::eType, t.type());
+    }
+
+    void resetSymbols() const {
+        const std::string &kept = Token::intern("resetSymbolsKept");
+        unsigned int id;
+        {
+            givenACodeSampleToTokenize code("resetSymbolsKept resetSymbolsFreed ;", true);
+            ASSERT(&code.tokens()->str() == &kept);
+            id = code.tokens()->next()->strId();
+            ASSERT(Token::Match(code.tokens(), "resetSymbolsKept %var% ;"));
+        }
+        Token::resetSymbols();
+
+        // the strings of intern() and of the patterns are kept
+        ASSERT(&Token::intern("resetSymbolsKept") == &kept);
+        ASSERT_EQUALS("resetSymbolsKept", kept);
+
+        // the other strings are interned again
+        givenACodeSampleToTokenize code("resetSymbolsFreed resetSymbolsFreed ;", true);
+        const Token *tok = code.tokens();
+        ASSERT_EQUALS("resetSymbolsFreed", tok->str());
+        ASSERT(&tok->str() == &tok->next()->str());
+        ASSERT(tok->strId() != id);
+        ASSERT(Token::Match(tok, "%var% resetSymbolsFreed ;"));
+    }
 
     void matchAny() const {
         givenACodeSampleToTokenize varBitOrVar("abc|def", true);
@@ -569,6 +656,81 @@ private:
     }
 
 
+    void matchChangedPattern() const {
+        givenACodeSampleToTokenize code("int a ; char b ;", true);
+        const Token *tok = code.tokens();
+
+        // The pattern at the same address changes, it must not be compiled
+        char pattern[32];
+        std::strcpy(pattern, "int %var% ;");
+        ASSERT_EQUALS(true, Token::Match(tok, pattern));
+        ASSERT(Token::findmatch(tok, pattern) == tok);
+        std::strcpy(pattern, "char %var% ;");
+        ASSERT_EQUALS(false, Token::Match(tok, pattern));
+        ASSERT_EQUALS(true, Token::Match(tok->tokAt(3), pattern));
+        ASSERT(Token::findmatch(tok, pattern) == tok->tokAt(3));
+        std::strcpy(pattern, "int");
+        ASSERT(Token::findmatch(tok->next(), pattern) == 0);
+
+        const std::string s("char %var%");
+        ASSERT_EQUALS(true, Token::Match(tok->tokAt(3), s.c_str()));
+        ASSERT_EQUALS(false, Token::Match(tok, s.c_str()));
+    }
+
+    // Local const arrays, both can get the same address on the stack
+    static bool matchLocalInt(const Token *tok) {
+        const char pattern[] = "int %var% ;";
+        return Token::Match(tok, pattern);
+    }
+
+    static bool matchLocalChar(const Token *tok) {
+        const char pattern[] = "char %var% ;";
+        return Token::Match(tok, pattern);
+    }
+
+    void matchLocalPattern() const {
+        givenACodeSampleToTokenize code("int a ; char b ;", true);
+        const Token *tok = code.tokens();
+
+        ASSERT_EQUALS(true, matchLocalInt(tok));
+        ASSERT_EQUALS(false, matchLocalChar(tok));
+        ASSERT_EQUALS(true, matchLocalChar(tok->tokAt(3)));
+        ASSERT_EQUALS(false, matchLocalInt(tok->tokAt(3)));
+    }
+
+    // The compiled pattern gives the same result as the interpreter at every token
+    template<std::size_t N>
+    static bool compiledLikeInterpreted(const Token *tokens, const char (&pattern)[N]) {
+        for (const Token *tok = tokens; tok; tok = tok->next()) {
+            if (Token::Match(tok, pattern) != Token::interpretMatch(tok, pattern))
+                return false;
+        }
+        return true;
+    }
+
+    void matchCompiled() const {
+        givenACodeSampleToTokenize code("x = \"a b\" | y ; delete p ; z = 'c' % 2 ;", true);
+        const Token *tokens = code.tokens();
+
+        ASSERT_EQUALS(true, Token::Match(tokens, "%var% = %str% %or%|%oror% %type%"));
+        ASSERT_EQUALS(true, Token::Match(tokens->tokAt(5), "[;|] delete|%type% %var% !!("));
+        ASSERT_EQUALS(false, Token::Match(tokens->tokAt(6), "%type%"));
+
+        ASSERT(compiledLikeInterpreted(tokens, "%var% = %str%"));
+        ASSERT(compiledLikeInterpreted(tokens, "%type% ="));
+        ASSERT(compiledLikeInterpreted(tokens, "%var%|%num% =|+="));
+        ASSERT(compiledLikeInterpreted(tokens, "= \"a|%str% b\""));
+        ASSERT(compiledLikeInterpreted(tokens, "= %char%|x %"));
+        ASSERT(compiledLikeInterpreted(tokens, "%or%|%oror% %var%"));
+        ASSERT(compiledLikeInterpreted(tokens, "&&|%oror%|%or%"));
+        ASSERT(compiledLikeInterpreted(tokens, "&&|%or%|%cop% %var%"));
+        ASSERT(compiledLikeInterpreted(tokens, "[;|] delete|%type% %var%"));
+        ASSERT(compiledLikeInterpreted(tokens, "!!else"));
+        ASSERT(compiledLikeInterpreted(tokens, "%any% %any% %any% !!;"));
+        ASSERT(compiledLikeInterpreted(tokens, "%var% %comp%|"));
+        ASSERT(compiledLikeInterpreted(tokens, ";|= %var%| %str%|;"));
+    }
+
     void isArithmeticalOp() const {
         std::vector<std::string>::const_iterator test_op, test_ops_end = arithmeticalOps.end();
         for (test_op = arithmeticalOps.begin(); test_op != test_ops_end; ++test_op) {
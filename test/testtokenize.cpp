@@ -22,6 +22,7 @@
 #include "token.h"
 #include "settings.h"
 #include "path.h"
+#include "symboldatabase.h"
 #include <cstring>
 
 extern std::ostringstream errout;
@@ -302,6 +303,8 @@ private:
 
         TEST_CASE(macrodoublesharp);
 
+        TEST_CASE(createTokensFromBuffer);
+
         TEST_CASE(simplifyFunctionParameters);
         TEST_CASE(simplifyFunctionParameters1); // #3721
         TEST_CASE(simplifyFunctionParameters2); // #4430
@@ -490,6 +493,14 @@ private:
         TEST_CASE(astunaryop);
         TEST_CASE(astfunction);
         TEST_CASE(asttemplate);
+
+        // binary snapshot of the tokens
+        TEST_CASE(snapshot);
+        TEST_CASE(snapshotInvalid);
+        TEST_CASE(snapshotTemplates);
+
+        // --check-headers-once
+        TEST_CASE(checkHeadersOnce);
     }
 
     std::string tokenizeAndStringify(const char code[], bool simplify = false, bool expand = true, Settings::PlatformType platform = Settings::Unspecified, const char* filename = "test.cpp", bool cpp11 = true) {
@@ -4905,6 +4916,26 @@ private:
         ASSERT_EQUALS("DBG ( fmt , args . . . ) printf ( fmt , ## args )", tokenizer.tokens()->stringifyList(0, false));
     }
 
+    void createTokensFromBuffer() {
+        // The buffer is not null terminated, the tokens end at its size
+        const char code[] = "x = 0x10 + .5e+3;\ns = \"a\\\"b\" 'c';\ny = \"unterminated string";
+        const std::size_t size = sizeof(code) - 1 - std::strlen(" string");
+
+        Settings settings;
+
+        TokenList bufferList(&settings);
+        ASSERT_EQUALS(true, bufferList.createTokens(code, size, "a.cpp"));
+
+        TokenList streamList(&settings);
+        std::istringstream istr(std::string(code, size));
+        ASSERT_EQUALS(true, streamList.createTokens(istr, "a.cpp"));
+
+        ASSERT_EQUALS("x = 16 + 0.5e+3 ;\n"
+                      "s = \"a\\\"b\" 'c' ;\n"
+                      "y = \"unterminated\"", bufferList.front()->stringifyList(false, false, false, true, false));
+        ASSERT_EQUALS(streamList.front()->stringifyList(true), bufferList.front()->stringifyList(true));
+    }
+
     void simplifyFunctionParameters() {
         {
             const char code[] = "char a [ ABC ( DEF ) ] ;";
@@ -8036,6 +8067,170 @@ private:
     void asttemplate() const { // uninstantiated templates will have <,>,etc.. how do we handle them?
         //ASSERT_EQUALS("", testAst("a<int>()==3"));
     }
+
+    void snapshot() {
+        const char code[] = "struct A { int x; };\n"
+                            "void f(A &&a, unsigned long n) {\n"
+                            "    int buf[10];\n"
+                            "    if (n < 10U) { buf[n] = a.x; }\n"
+                            "}";
+        Settings settings;
+        settings.standards.cpp = Standards::CPP11;
+
+        Tokenizer tokenizer1(&settings, this);
+        std::istringstream istr(code);
+        std::string data;
+        ASSERT(tokenizer1.tokenize(istr, "test.cpp", "A", &data));
+        ASSERT(!data.empty());
+
+        Tokenizer tokenizer2(&settings, this);
+        ASSERT(tokenizer2.loadSnapshot(data.data(), data.size(), "A"));
+
+        ASSERT_EQUALS(tokenizer1.tokens()->stringifyList(true, true, true, true, true, &tokenizer1.list.getFiles()),
+                      tokenizer2.tokens()->stringifyList(true, true, true, true, true, &tokenizer2.list.getFiles()));
+        ASSERT_EQUALS(tokenizer1.varIdCount(), tokenizer2.varIdCount());
+
+        // The links point to the same places
+        for (const Token *tok1 = tokenizer1.tokens(), *tok2 = tokenizer2.tokens(); tok1 && tok2; tok1 = tok1->next(), tok2 = tok2->next()) {
+            ASSERT_EQUALS(tok1->type(), tok2->type());
+            ASSERT_EQUALS(tok1->link() != 0, tok2->link() != 0);
+            if (tok1->link() && tok2->link())
+                ASSERT_EQUALS(tokenizer1.list.fileLine(tok1->link()) + tok1->link()->strAt(-1),
+                              tokenizer2.list.fileLine(tok2->link()) + tok2->link()->strAt(-1));
+        }
+
+        // The symbol database is created
+        ASSERT(tokenizer2.getSymbolDatabase() != 0);
+        ASSERT_EQUALS(tokenizer1.getSymbolDatabase()->getVariableListSize(), tokenizer2.getSymbolDatabase()->getVariableListSize());
+    }
+
+    void snapshotInvalid() {
+        Settings settings;
+        Tokenizer tokenizer1(&settings, this);
+        std::istringstream istr("void f() { }");
+        std::string data;
+        ASSERT(tokenizer1.tokenize(istr, "test.cpp", "", &data));
+
+        Tokenizer tokenizer2(&settings, this);
+        ASSERT(!tokenizer2.loadSnapshot(data.data(), data.size() - 1));
+        ASSERT(!tokenizer2.loadSnapshot(data.data(), 2));
+        const std::size_t stateSize = 2 * sizeof(unsigned int) + 1;
+        data[stateSize - 1] = 'X';
+        ASSERT(!tokenizer2.loadSnapshot(data.data(), data.size()));
+        data[stateSize - 1] = '0';
+        data[stateSize] = 'X';
+        ASSERT(!tokenizer2.loadSnapshot(data.data(), data.size()));
+        ASSERT(tokenizer2.tokens() == 0);
+    }
+
+    void snapshotTemplates() {
+        // The state of the tokenizer is restored with the tokens,
+        // checks use codeWithTemplates()
+        const char code[] = "template<class T> struct A { T x; };\n"
+                            "A<int> a;\n"
+                            "struct { int y; } b;\n"
+                            "void f(unsigned int u) { if (u < 0) { } }";
+        Settings settings;
+
+        Tokenizer tokenizer1(&settings, this);
+        std::istringstream istr(code);
+        std::string data;
+        ASSERT(tokenizer1.tokenize(istr, "test.cpp", "", &data));
+        ASSERT_EQUALS(true, tokenizer1.codeWithTemplates());
+
+        Tokenizer tokenizer2(&settings, this);
+        ASSERT(tokenizer2.loadSnapshot(data.data(), data.size()));
+        ASSERT_EQUALS(tokenizer1.codeWithTemplates(), tokenizer2.codeWithTemplates());
+        ASSERT_EQUALS(tokenizer1.varIdCount(), tokenizer2.varIdCount());
+
+        // simplifyTokenList() gives the same result
+        tokenizer1.simplifyTokenList();
+        tokenizer2.simplifyTokenList();
+        ASSERT_EQUALS(tokenizer1.tokens()->stringifyList(true, true, true, true, true, &tokenizer1.list.getFiles()),
+                      tokenizer2.tokens()->stringifyList(true, true, true, true, true, &tokenizer2.list.getFiles()));
+    }
+
+    std::string tokenizeCheckedHeaders(const char code[], std::string &lines) {
+        Settings settings;
+        settings.checkHeadersOnce = true;
+        Tokenizer tokenizer(&settings, this);
+        std::istringstream istr(code);
+        tokenizer.tokenize(istr, "test.cpp");
+        std::ostringstream ostr;
+        for (std::list<Tokenizer::HeaderLines>::const_iterator it = tokenizer.checkedHeaderLines().begin(); it != tokenizer.checkedHeaderLines().end(); ++it)
+            ostr << it->file << ':' << it->first << '-' << it->last << ' ';
+        lines = ostr.str();
+        return tokenizer.tokens()->stringifyList(0, false);
+    }
+
+    void checkHeadersOnce() {
+        Tokenizer::clearCheckedHeaders();
+        const char header[] = "#file \"a.h\"\n"
+                              "void f() { g(); }\n"
+                              "void g() { }\n"
+                              "void h() { }\n"
+                              "class A {\n"
+                              "    A() : x(0) { }\n"
+                              "    int get() const { return x; }\n"
+                              "    int x;\n"
+                              "};\n"
+                              "#endfile\n";
+        std::string lines;
+
+        // The first time the header is checked
+        const std::string code1 = std::string(header) + "void f1() { f(); }\n";
+        ASSERT_EQUALS("void f ( ) { g ( ) ; } "
+                      "void g ( ) { } "
+                      "void h ( ) { } "
+                      "class A { A ( ) : x ( 0 ) { } int get ( ) const { return x ; } int x ; } ; "
+                      "void f1 ( ) { f ( ) ; }",
+                      tokenizeCheckedHeaders(code1.c_str(), lines));
+        ASSERT_EQUALS("", lines);
+
+        // Then only the functions that the other code uses are kept, and the functions they use
+        const std::string code2 = std::string(header) + "void f2() { f(); }\n";
+        ASSERT_EQUALS("void f ( ) { g ( ) ; } "
+                      "void g ( ) { } "
+                      "void h ( ) ; "
+                      "class A { A ( ) ; int get ( ) const ; int x ; } ; "
+                      "void f2 ( ) { f ( ) ; }",
+                      tokenizeCheckedHeaders(code2.c_str(), lines));
+        ASSERT_EQUALS("a.h:3-3 a.h:4-8 ", lines);
+
+        // The classes that the other code uses are kept
+        const std::string code3 = std::string(header) + "void f3(A &a) { }\n";
+        ASSERT_EQUALS("void f ( ) ; "
+                      "void g ( ) ; "
+                      "void h ( ) ; "
+                      "class A { A ( ) : x ( 0 ) { } int get ( ) const { return x ; } int x ; } ; "
+                      "void f3 ( A & a ) { }",
+                      tokenizeCheckedHeaders(code3.c_str(), lines));
+        ASSERT_EQUALS("a.h:1-1 a.h:2-2 a.h:3-3 ", lines);
+
+        // Other code in the header is checked
+        std::string header4(header);
+        header4.replace(header4.find("h()"), 3, "k()");
+        const std::string code4 = header4 + "void f4() { }\n";
+        ASSERT_EQUALS("void f ( ) { g ( ) ; } "
+                      "void g ( ) { } "
+                      "void k ( ) { } "
+                      "class A { A ( ) : x ( 0 ) { } int get ( ) const { return x ; } int x ; } ; "
+                      "void f4 ( ) { }",
+                      tokenizeCheckedHeaders(code4.c_str(), lines));
+        ASSERT_EQUALS("", lines);
+
+        // Functions that are defined outside their class are kept
+        Tokenizer::clearCheckedHeaders();
+        const char code5[] = "#file \"b.h\"\n"
+                             "class B { void f(); };\n"
+                             "void B::f() { }\n"
+                             "#endfile\n";
+        tokenizeCheckedHeaders(code5, lines);
+        ASSERT_EQUALS("class B { void f ( ) ; } ; void B :: f ( ) { }", tokenizeCheckedHeaders(code5, lines));
+        ASSERT_EQUALS("", lines);
+
+        Tokenizer::clearCheckedHeaders();
+    }
 };
 
 REGISTER_TEST(TestTokenizer)
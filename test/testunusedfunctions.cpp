@@ -49,6 +49,7 @@ private:
         TEST_CASE(returnRef);
 
         TEST_CASE(multipleFiles);   // same function name in multiple files
+        TEST_CASE(mergeFiles);      // function usage of files parsed by different instances
 
         TEST_CASE(lineNumber); // Ticket 3059
 
@@ -252,6 +253,39 @@ private:
         ASSERT_EQUALS("[test1.cpp:1]: (style) The function 'f' is never used.\n", errout.str());
     }
 
+    void mergeFiles() {
+        const char * const files[] = { "test1.cpp", "sub dir/test2.cpp" };
+        const char * const code[] = { "void h() { }\n"
+                                      "void g() { f(); }\n",
+                                      "void f() { }\n"
+                                      "void k() { h(); }\n"
+                                    };
+
+        // Parse the files with separate instances, like the jobs of -j
+        std::string data[2];
+        for (int i = 0; i < 2; ++i) {
+            Settings settings;
+            Tokenizer tokenizer(&settings, this);
+            std::istringstream istr(code[i]);
+            tokenizer.tokenize(istr, files[i]);
+
+            CheckUnusedFunctions c(&tokenizer, &settings, this);
+            c.parseTokens(tokenizer);
+            data[i] = c.serialize();
+        }
+
+        // The order of merging does not matter
+        for (int first = 0; first < 2; ++first) {
+            errout.str("");
+            CheckUnusedFunctions c(0, 0, 0);
+            c.merge(data[first]);
+            c.merge(data[1 - first]);
+            c.check(this);
+            ASSERT_EQUALS("[test1.cpp:2]: (style) The function 'g' is never used.\n"
+                          "[sub dir/test2.cpp:2]: (style) The function 'k' is never used.\n", errout.str());
+        }
+    }
+
     void lineNumber() {
         check("void foo() {}\n"
               "void bar() {}\n"
@@ -233,8 +233,13 @@ int main(int argc, char **argv)
     // compiled patterns..
     fout << "# folder where lib/*.cpp files are located\n";
     makeConditionalVariable(fout, "SRCDIR", "lib");
+    fout << "# with VERIFY=yes the compiled patterns are compared to Token::Match() at runtime\n";
     fout << "ifeq ($(SRCDIR),build)\n"
-         << "    matchcompiler_S := $(shell python tools/matchcompiler.py)\n"
+         << "    ifeq ($(VERIFY),yes)\n"
+         << "        matchcompiler_S := $(shell python tools/matchcompiler.py --verify)\n"
+         << "    else\n"
+         << "        matchcompiler_S := $(shell python tools/matchcompiler.py)\n"
+         << "    endif\n"
          << "endif\n\n";
 
     // The _GLIBCXX_DEBUG doesn't work in cygwin or other Win32 systems.
@@ -259,6 +264,9 @@ int main(int argc, char **argv)
          << "else # !COMSPEC\n"
          << "    uname_S := $(shell sh -c 'uname -s 2>/dev/null || echo not')\n"
          << "\n"
+         << "    # The checking threads (--executor=thread) need pthreads\n"
+         << "    LDFLAGS += -pthread\n"
+         << "\n"
          << "    ifeq ($(uname_S),Linux)\n"
          << "        ifndef CPPCHK_GLIBCXX_DEBUG\n"
          << "            CPPCHK_GLIBCXX_DEBUG=-D_GLIBCXX_DEBUG\n"
@@ -347,8 +355,8 @@ int main(int argc, char **argv)
     fout << "cppcheck: $(LIBOBJ) $(CLIOBJ) $(EXTOBJ)\n";
     fout << "\t$(CXX) $(CPPFLAGS) $(CXXFLAGS) -o cppcheck $(CLIOBJ) $(LIBOBJ) $(EXTOBJ) $(LIBS) $(LDFLAGS)\n\n";
     fout << "all:\tcppcheck testrunner\n\n";
-    fout << "testrunner: $(TESTOBJ) $(LIBOBJ) $(EXTOBJ) cli/threadexecutor.o cli/cmdlineparser.o cli/cppcheckexecutor.o cli/filelister.o cli/pathmatch.o\n";
-    fout << "\t$(CXX) $(CPPFLAGS) $(CXXFLAGS) -o testrunner $(TESTOBJ) $(LIBOBJ) cli/threadexecutor.o cli/cppcheckexecutor.o cli/cmdlineparser.o cli/filelister.o cli/pathmatch.o $(EXTOBJ) $(LIBS) $(LDFLAGS)\n\n";
+    fout << "testrunner: $(TESTOBJ) $(LIBOBJ) $(EXTOBJ) cli/analysisserver.o cli/threadexecutor.o cli/cmdlineparser.o cli/compiledatabase.o cli/cppcheckexecutor.o cli/filelister.o cli/filescheduler.o cli/jobserver.o cli/pathmatch.o\n";
+    fout << "\t$(CXX) $(CPPFLAGS) $(CXXFLAGS) -o testrunner $(TESTOBJ) $(LIBOBJ) cli/analysisserver.o cli/threadexecutor.o cli/cppcheckexecutor.o cli/cmdlineparser.o cli/compiledatabase.o cli/filelister.o cli/filescheduler.o cli/jobserver.o cli/pathmatch.o $(EXTOBJ) $(LIBS) $(LDFLAGS)\n\n";
     fout << "test:\tall\n";
     fout << "\t./testrunner\n\n";
     fout << "check:\tall\n";
@@ -357,8 +365,13 @@ int main(int argc, char **argv)
     fout << "\t$(CXX) -o dmake tools/dmake.cpp cli/filelister.cpp lib/path.cpp -Ilib $(LDFLAGS)\n\n";
     fout << "reduce:\ttools/reduce.cpp\n";
     fout << "\t$(CXX) -g -o reduce tools/reduce.cpp -Ilib lib/*.cpp\n\n";
+    fout << "# with SRCDIR=build the benchmark is also compiled by tools/matchcompiler.py\n";
+    fout << "matchbench:\ttools/matchbench.cpp $(LIBOBJ)\n";
+    fout << "\t$(CXX) $(CPPFLAGS) $(CXXFLAGS) ${INCLUDE_FOR_LIB} -o matchbench $(if $(filter build,$(SRCDIR)),build,tools)/matchbench.cpp $(LIBOBJ) $(LIBS) $(LDFLAGS)\n\n";
+    fout << "tokenizebench:\ttools/tokenizebench.cpp $(LIBOBJ)\n";
+    fout << "\t$(CXX) $(CPPFLAGS) $(CXXFLAGS) ${INCLUDE_FOR_LIB} -o tokenizebench tools/tokenizebench.cpp $(LIBOBJ) $(LIBS) $(LDFLAGS)\n\n";
     fout << "clean:\n";
-    fout << "\trm -f build/*.o lib/*.o cli/*.o test/*.o externals/tinyxml/*.o testrunner reduce cppcheck cppcheck.1\n\n";
+    fout << "\trm -f build/*.o lib/*.o cli/*.o test/*.o externals/tinyxml/*.o testrunner reduce matchbench tokenizebench cppcheck cppcheck.1\n\n";
     fout << "man:\tman/cppcheck.1\n\n";
     fout << "man/cppcheck.1:\t$(MAN_SOURCE)\n\n";
     fout << "\t$(XP) $(DB2MAN) $(MAN_SOURCE)\n\n";
@@ -0,0 +1,233 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2013 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Micro-benchmark for Token::Match patterns. A file is tokenized and some
+ * patterns from the checks are matched at every token, with:
+ *  - interpreted: Token::interpretMatch, the pattern is parsed on every call
+ *  - compiled: Token::Match with the cached, compiled pattern
+ *  - call site: Token::Match with a string literal. When this file is
+ *    built with 'make matchbench SRCDIR=build', tools/matchcompiler.py
+ *    has replaced these calls, so this is the matchcompiler output.
+ *    Otherwise it is the same as compiled.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "errorlogger.h"
+#include "settings.h"
+#include "token.h"
+#include "tokenize.h"
+
+namespace {
+    class NullLogger : public ErrorLogger {
+    public:
+        void reportOut(const std::string &) {
+        }
+        void reportErr(const ErrorLogger::ErrorMessage &) {
+        }
+    };
+
+    // The patterns are written twice: in an array for the compiled
+    // Token::Match and as a literal that tools/matchcompiler.py can compile.
+    const char pattern0[] = "%type% *|& %var% (";
+    bool compiled0(const Token *tok)
+    {
+        return Token::Match(tok, pattern0);
+    }
+    bool literal0(const Token *tok)
+    {
+        return Token::Match(tok, "%type% *|& %var% (");
+    }
+
+    const char pattern1[] = "[;{}] %var% = %var% [";
+    bool compiled1(const Token *tok)
+    {
+        return Token::Match(tok, pattern1);
+    }
+    bool literal1(const Token *tok)
+    {
+        return Token::Match(tok, "[;{}] %var% = %var% [");
+    }
+
+    const char pattern2[] = "if|while ( !| %var% )";
+    bool compiled2(const Token *tok)
+    {
+        return Token::Match(tok, pattern2);
+    }
+    bool literal2(const Token *tok)
+    {
+        return Token::Match(tok, "if|while ( !| %var% )");
+    }
+
+    const char pattern3[] = "%var% . push_back|push_front|insert (";
+    bool compiled3(const Token *tok)
+    {
+        return Token::Match(tok, pattern3);
+    }
+    bool literal3(const Token *tok)
+    {
+        return Token::Match(tok, "%var% . push_back|push_front|insert (");
+    }
+
+    const char pattern4[] = "return|throw !!;";
+    bool compiled4(const Token *tok)
+    {
+        return Token::Match(tok, pattern4);
+    }
+    bool literal4(const Token *tok)
+    {
+        return Token::Match(tok, "return|throw !!;");
+    }
+
+    const char pattern5[] = "%var%|%num% %comp%|%oror%|&& %any%";
+    bool compiled5(const Token *tok)
+    {
+        return Token::Match(tok, pattern5);
+    }
+    bool literal5(const Token *tok)
+    {
+        return Token::Match(tok, "%var%|%num% %comp%|%oror%|&& %any%");
+    }
+
+    const char pattern6[] = "const| std :: string|vector|list <";
+    bool compiled6(const Token *tok)
+    {
+        return Token::Match(tok, pattern6);
+    }
+    bool literal6(const Token *tok)
+    {
+        return Token::Match(tok, "const| std :: string|vector|list <");
+    }
+
+    const char pattern7[] = "delete [ ] %var% ;";
+    bool compiled7(const Token *tok)
+    {
+        return Token::Match(tok, pattern7);
+    }
+    bool literal7(const Token *tok)
+    {
+        return Token::Match(tok, "delete [ ] %var% ;");
+    }
+
+    const struct Pattern {
+        const char *pattern;
+        bool (*compiled)(const Token *);
+        bool (*literal)(const Token *);
+    } patterns[] = {
+        { pattern0, compiled0, literal0 },
+        { pattern1, compiled1, literal1 },
+        { pattern2, compiled2, literal2 },
+        { pattern3, compiled3, literal3 },
+        { pattern4, compiled4, literal4 },
+        { pattern5, compiled5, literal5 },
+        { pattern6, compiled6, literal6 },
+        { pattern7, compiled7, literal7 }
+    };
+
+    enum Variant { interpreted, compiled, callSite };
+
+    unsigned int run(const Token *tokens, const Pattern &pattern, Variant variant, unsigned int repeat, double &seconds)
+    {
+        unsigned int matches = 0;
+        const std::clock_t start = std::clock();
+        for (unsigned int i = 0; i < repeat; ++i) {
+            for (const Token *tok = tokens; tok; tok = tok->next()) {
+                bool match;
+                if (variant == interpreted)
+                    match = Token::interpretMatch(tok, pattern.pattern);
+                else if (variant == compiled)
+                    match = pattern.compiled(tok);
+                else
+                    match = pattern.literal(tok);
+                if (match)
+                    ++matches;
+            }
+        }
+        seconds = double(std::clock() - start) / CLOCKS_PER_SEC;
+        return matches;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int repeat = 20;
+    const char *filename = 0;
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "--repeat=", 9) == 0)
+            repeat = static_cast<unsigned int>(std::atoi(argv[i] + 9));
+        else if (!filename)
+            filename = argv[i];
+        else {
+            std::cerr << "invalid option " << argv[i] << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!filename || repeat == 0) {
+        std::cerr << "Syntax:" << std::endl
+                  << argv[0] << " [--repeat=20] filename" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::ifstream fin(filename);
+    if (!fin.is_open()) {
+        std::cerr << "could not open " << filename << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    Settings settings;
+    NullLogger logger;
+    Tokenizer tokenizer(&settings, &logger);
+    tokenizer.tokenize(fin, filename);
+
+    unsigned int tokens = 0;
+    for (const Token *tok = tokenizer.tokens(); tok; tok = tok->next())
+        ++tokens;
+    std::cout << tokens << " tokens, " << repeat << " rounds, times in seconds" << std::endl;
+    std::cout << std::left << std::setw(42) << "pattern" << std::right
+              << std::setw(12) << "interpreted" << std::setw(10) << "compiled"
+              << std::setw(11) << "call site" << std::setw(10) << "matches" << std::endl;
+
+    double total[3] = {0, 0, 0};
+    for (std::size_t i = 0; i < sizeof(patterns) / sizeof(patterns[0]); ++i) {
+        double seconds[3];
+        const unsigned int matches = run(tokenizer.tokens(), patterns[i], interpreted, repeat, seconds[0]);
+        if (run(tokenizer.tokens(), patterns[i], compiled, repeat, seconds[1]) != matches ||
+            run(tokenizer.tokens(), patterns[i], callSite, repeat, seconds[2]) != matches) {
+            std::cerr << "different results for \"" << patterns[i].pattern << '\"' << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        std::cout << std::left << std::setw(42) << patterns[i].pattern << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(12) << seconds[0] << std::setw(10) << seconds[1]
+                  << std::setw(11) << seconds[2] << std::setw(10) << matches / repeat << std::endl;
+        for (int v = 0; v < 3; ++v)
+            total[v] += seconds[v];
+    }
+    std::cout << std::left << std::setw(42) << "total" << std::right
+              << std::setw(12) << total[0] << std::setw(10) << total[1]
+              << std::setw(11) << total[2] << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -32,6 +32,7 @@ class MatchCompiler:
         self._rawMatchFunctions = []
         self._matchStrs = {}
         self._matchFunctionCache = {}
+        self._matchChainCount = 0
 
     def _generateCacheSignature(self, pattern, endToken=None, varId=None, isFindMatch=False):
         sig = pattern
@@ -95,13 +96,13 @@ class MatchCompiler:
         elif tok == '%op%':
             return 'tok->isOp()'
         elif tok == '%or%':
-            return '(tok->str()==' + self._insertMatchStr('|') + ')/* | */'
+            return '(&tok->str()==&' + self._insertMatchStr('|') + ')/* | */'
         elif tok == '%oror%':
-            return '(tok->str()==' + self._insertMatchStr('||') + ')/* || */'
+            return '(&tok->str()==&' + self._insertMatchStr('||') + ')/* || */'
         elif tok == '%str%':
             return '(tok->type()==Token::eString)'
         elif tok == '%type%':
-            return '(tok->isName() && tok->varId()==0U && tok->str() != ' + self._insertMatchStr('delete') + '/* delete */)'
+            return '(tok->isName() && tok->varId()==0U && &tok->str() != &' + self._insertMatchStr('delete') + '/* delete */)'
         elif tok == '%var%':
             return 'tok->isName()'
         elif tok == '%varid%':
@@ -109,7 +110,8 @@ class MatchCompiler:
         elif (len(tok) > 2) and (tok[0] == "%"):
             print ("unhandled:" + tok)
 
-        return '(tok->str()==' + self._insertMatchStr(tok) + ')/* ' + tok + ' */'
+        # The token strings are interned, equal strings have the same address
+        return '(&tok->str()==&' + self._insertMatchStr(tok) + ')/* ' + tok + ' */'
 
     def _compilePattern(self, pattern, nr, varid, isFindMatch=False):
         ret = ''
@@ -179,7 +181,7 @@ class MatchCompiler:
 
             # !!a
             elif tok[0:2] == "!!":
-                ret += '    if (tok && tok->str() == ' + self._insertMatchStr(tok[2:]) + ')/* ' + tok[2:] + ' */\n'
+                ret += '    if (tok && &tok->str() == &' + self._insertMatchStr(tok[2:]) + ')/* ' + tok[2:] + ' */\n'
                 ret += '        ' + returnStatement
                 gotoNextToken = '    tok = tok ? tok->next() : NULL;\n'
 
@@ -306,11 +308,7 @@ class MatchCompiler:
 
         return ret
 
-    def _replaceSpecificTokenMatch(self, is_simplematch, line, start_pos, end_pos, pattern, tok, varId):
-        more_args = ''
-        if varId:
-            more_args = ',' + varId
-
+    def _compileMatchFunction(self, pattern, varId):
         # Compile function or use previously compiled one
         patternNumber = self._lookupMatchFunctionId(pattern, None, varId, False)
 
@@ -319,6 +317,15 @@ class MatchCompiler:
             self._insertMatchFunctionId(patternNumber, pattern, None, varId, False)
             self._rawMatchFunctions.append(self._compilePattern(pattern, patternNumber, varId))
 
+        return patternNumber
+
+    def _replaceSpecificTokenMatch(self, is_simplematch, line, start_pos, end_pos, pattern, tok, varId):
+        more_args = ''
+        if varId:
+            more_args = ',' + varId
+
+        patternNumber = self._compileMatchFunction(pattern, varId)
+
         functionName = "match"
         if self._verifyMode:
             verifyNumber = len(self._rawMatchFunctions) + 1
@@ -499,6 +506,155 @@ class MatchCompiler:
 
         return line
 
+    # "if (Token::Match(tok, "pattern")) {" and the "} else if" lines of the
+    # same chain. The token argument must not have side effects.
+    _chainTok = r'[A-Za-z_]\w*(?:->(?:next|previous)\(\)|->tokAt\(-?\d+\))*'
+    _chainFirst = re.compile(r'^(\s*)if \(Token::Match\((' + _chainTok + r'), "([^"\\]*)"\)\)(\s*\{)?\s*$')
+    _chainNext = re.compile(r'^(\s*)(\} )?else if \(Token::Match\((' + _chainTok + r'), "([^"\\]*)"\)\)(\s*\{)?\s*$')
+
+    @staticmethod
+    def _indentation(line):
+        return len(line) - len(line.lstrip())
+
+    def _findMatchChain(self, lines, first):
+        # Returns the line numbers of the Token::Match conditions of the
+        # if / else if chain that starts at lines[first]
+        res = self._chainFirst.match(lines[first])
+        if res is None:
+            return None
+
+        # The result is stored in a variable that is declared before the
+        # if, which must be a statement of its own
+        prev = first - 1
+        while prev >= 0 and (lines[prev].strip() == '' or lines[prev].strip().startswith('//')):
+            prev -= 1
+        if prev < 0 or not lines[prev].rstrip().endswith(('{', ';', '}')):
+            return None
+
+        indent = len(res.group(1))
+        tok = res.group(2)
+        chain = [first]
+        for nr in range(first + 1, len(lines)):
+            line = lines[nr]
+            if line.strip() == '' or self._indentation(line) > indent:
+                continue
+            if self._indentation(line) == indent and line.strip() == '}':
+                continue
+            res = self._chainNext.match(line)
+            if res is None or len(res.group(1)) != indent or res.group(3) != tok:
+                break
+            chain.append(nr)
+
+        if len(chain) < 2:
+            return None
+        return chain
+
+    @staticmethod
+    def _firstWord(pattern):
+        for word in pattern.split(' '):
+            if word != '':
+                return word
+        return ''
+
+    @staticmethod
+    def _isLiteralWord(word):
+        return word != '' and word[0] not in '%[' and not word.startswith('!!') and '|' not in word
+
+    def _chainGains(self, patterns):
+        # The dispatch on the first character only skips patterns if at
+        # least two of them start with a literal. Otherwise the chain is
+        # the same as calling the match functions one after the other.
+        firstWords = [self._firstWord(pattern) for pattern in patterns]
+        return len([word for word in firstWords if self._isLiteralWord(word)]) >= 2
+
+    def _compileMatchChain(self, patterns, nr):
+        # A matcher for all patterns of the chain that switches on the first
+        # character of the token and then compares the interned string. It
+        # returns the number of the first pattern that matches, 0 if none.
+        functions = [self._compileMatchFunction(pattern, None) for pattern in patterns]
+        firstWords = [self._firstWord(pattern) for pattern in patterns]
+
+        ret = '// chain: ' + ' | '.join(patterns) + '\n'
+        ret += 'static int matchChain' + str(nr) + '(const Token *tok) {\n'
+
+        cases = sorted(set(word[0] for word in firstWords if self._isLiteralWord(word)))
+        if cases:
+            ret += '    switch (tok ? tok->str()[0] : \'\\0\') {\n'
+            for c in cases:
+                ret += "    case '" + ('\\' + c if c in '\\\'' else c) + "':\n"
+                for i, word in enumerate(firstWords):
+                    if self._isLiteralWord(word):
+                        if word[0] != c:
+                            continue
+                        ret += '        if (&tok->str()==&' + self._insertMatchStr(word) + ' && match' + str(functions[i]) + '(tok))\n'
+                    else:
+                        ret += '        if (match' + str(functions[i]) + '(tok))\n'
+                    ret += '            return ' + str(i + 1) + ';\n'
+                ret += '        return 0;\n'
+            ret += '    }\n'
+
+        for i, word in enumerate(firstWords):
+            if not self._isLiteralWord(word):
+                ret += '    if (match' + str(functions[i]) + '(tok))\n'
+                ret += '        return ' + str(i + 1) + ';\n'
+        ret += '    return 0;\n'
+        ret += '}\n'
+        return ret
+
+    def _compileVerifyMatchChain(self, patterns, nr):
+        ret = 'static int matchChain_verify' + str(nr) + '(const Token *tok) {\n'
+        ret += '    const int res_compiled_match = matchChain' + str(nr) + '(tok);\n'
+        ret += '    int res_parsed_match = 0;\n'
+        for i, pattern in enumerate(patterns):
+            ret += '    ' + ('else ' if i > 0 else '') + 'if (Token::Match(tok, "' + pattern + '"))\n'
+            ret += '        res_parsed_match = ' + str(i + 1) + ';\n'
+        ret += '    if (res_parsed_match != res_compiled_match)\n'
+        ret += '        throw InternalError(tok, "Internal error. compiled match chain returned different result than parsed match");\n'
+        ret += '    return res_compiled_match;\n'
+        ret += '}\n'
+        return ret
+
+    def _replaceMatchChains(self, lines):
+        # Fuse the Token::Match calls of an if / else if chain that test the
+        # same token, so the token is compared to all patterns at once
+        ret = list(lines)
+        nr = 0
+        while nr < len(ret):
+            chain = self._findMatchChain(ret, nr)
+            if chain is None:
+                nr += 1
+                continue
+
+            tok = self._chainFirst.match(ret[chain[0]]).group(2)
+            patterns = [self._chainNext.match(ret[i]).group(4) for i in chain[1:]]
+            patterns.insert(0, self._chainFirst.match(ret[chain[0]]).group(3))
+            if not self._chainGains(patterns):
+                nr += 1
+                continue
+
+            self._matchChainCount += 1
+            chainNr = self._matchChainCount
+
+            self._rawMatchFunctions.append(self._compileMatchChain(patterns, chainNr))
+            functionName = 'matchChain'
+            if self._verifyMode:
+                self._rawMatchFunctions.append(self._compileVerifyMatchChain(patterns, chainNr))
+                functionName = 'matchChain_verify'
+
+            result = 'matchChainResult' + str(chainNr)
+            call = 'Token::Match(' + tok + ', "' + patterns[0] + '")'
+            ret[chain[0]] = ret[chain[0]].replace(call, '(' + result + ' = ' + functionName + str(chainNr) + '(' + tok + ')) == 1', 1)
+            for i in range(1, len(chain)):
+                call = 'Token::Match(' + tok + ', "' + patterns[i] + '")'
+                ret[chain[i]] = ret[chain[i]].replace(call, result + ' == ' + str(i + 1), 1)
+
+            # No initializer, a jump to a case label may cross the declaration
+            indent = ret[chain[0]][:self._indentation(ret[chain[0]])]
+            ret.insert(chain[0], indent + 'int ' + result + ';\n')
+            nr = chain[-1] + 2
+
+        return ret
+
     def convertFile(self, srcname, destname):
         self._reset()
 
@@ -513,6 +669,8 @@ class MatchCompiler:
         # header += '#include <iostream>\n'
         code = ''
 
+        srclines = self._replaceMatchChains(srclines)
+
         for line in srclines:
             # Compile Token::Match and Token::simpleMatch
             line = self._replaceTokenMatch(line)
@@ -528,7 +686,7 @@ class MatchCompiler:
         # Compute string list
         stringList = ''
         for match in sorted(self._matchStrs, key=self._matchStrs.get):
-            stringList += 'static const std::string matchStr' + str(self._matchStrs[match]) + '("' + match + '");\n'
+            stringList += 'static const std::string &matchStr' + str(self._matchStrs[match]) + ' = Token::intern("' + match + '");\n'
 
         # Compute matchFunctions
         strFunctions = ''
@@ -568,5 +726,9 @@ def main():
         print (f + ' => ' + build_dir + '/' + f[4:])
         mc.convertFile(f, build_dir + '/'+f[4:])
 
+    # the benchmark of Token::Match() compares itself to the compiled matches
+    print ('tools/matchbench.cpp => ' + build_dir + '/matchbench.cpp')
+    mc.convertFile('tools/matchbench.cpp', build_dir + '/matchbench.cpp')
+
 if __name__ == '__main__':
     main()
@@ -0,0 +1,232 @@
+#!/usr/bin/python
+#
+# Cppcheck - A tool for static C/C++ code analysis
+# Copyright (C) 2007-2013 Daniel Marjamaeki and Cppcheck team.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+"""
+Merge the --xml-version=2 results of the parts of a --shard run into one
+report. Messages that several parts report, for example about a header
+that files of several parts include, are reported once. The suppressions
+are applied to the whole set of messages, so a suppression is reported as
+unmatched only when no part has a message that matches it.
+
+The parts must be run without global suppressions, those that are not
+for one file (no file name, a file name with wildcards, unusedFunction).
+Give them here instead, a part can't know if another part has a message
+that matches them. It is an error if a part reports such a suppression
+as unmatched.
+
+Inline suppressions (--inline-suppr) and suppressions for one file can be
+given to the parts, the part that checks the file knows if they are
+matched. Their unmatchedSuppression messages are kept, unless the same
+suppression is given here too, then it is matched with the messages of
+all parts.
+
+usage: mergeshards.py [--suppressions-list=<file>] [--suppress=<spec>]
+                      [-o <output>] part1.xml part2.xml ...
+"""
+
+import re
+import sys
+import xml.etree.ElementTree as ET
+import argparse
+
+
+def xmlAttribute(s):
+    """ Quote a string the way cppcheck does in its XML output """
+    s = s.replace('&', '&amp;').replace('<', '&lt;').replace('>', '&gt;')
+    return s.replace('"', '&quot;').replace('\n', '&#xa;')
+
+
+class Error:
+    def __init__(self, element):
+        self.id = element.get('id', '')
+        self.severity = element.get('severity', '')
+        self.msg = element.get('msg', '')
+        self.verbose = element.get('verbose', '')
+        self.inconclusive = element.get('inconclusive') == 'true'
+        self.locations = [(loc.get('file', ''), int(loc.get('line', '0')))
+                          for loc in element.findall('location')]
+
+    def key(self):
+        """ Messages with the same key are the same message """
+        return (tuple(self.locations), self.id, self.severity, self.msg, self.verbose, self.inconclusive)
+
+    def sortKey(self):
+        return (self.locations, self.id, self.msg)
+
+    def file(self):
+        """ Suppressions are matched with the first location """
+        if self.locations:
+            return self.locations[0][0].replace('\\', '/')
+        return ''
+
+    def line(self):
+        if self.locations:
+            return self.locations[0][1]
+        return 0
+
+    def toXML(self):
+        xml = '  <error id="%s" severity="%s" msg="%s" verbose="%s"' % (
+            self.id, self.severity, xmlAttribute(self.msg), xmlAttribute(self.verbose))
+        if self.inconclusive:
+            xml += ' inconclusive="true"'
+        xml += '>\n'
+        for loc in self.locations:
+            xml += '    <location file="%s" line="%d"/>\n' % (xmlAttribute(loc[0]), loc[1])
+        xml += '  </error>\n'
+        return xml
+
+
+class Suppression:
+    """ A suppression in the format of --suppress: id[:file[:line]] """
+
+    def __init__(self, spec):
+        self.id = spec
+        self.file = ''
+        self.line = 0
+        self.matched = False
+        if ':' in spec:
+            self.id, self.file = spec.split(':', 1)
+            # a colon without a dot after it starts the line number
+            pos = self.file.rfind(':')
+            if pos >= 0 and self.file.find('.', pos) < 0:
+                try:
+                    self.line = int(self.file[pos + 1:])
+                except ValueError:
+                    self.line = 0
+                if self.line > 0:
+                    self.file = self.file[:pos]
+        self.file = self.file.replace('\\', '/')
+        if self.file.startswith('./'):
+            self.file = self.file[2:]
+        if not self.file:
+            self.file = '*'
+        self.isGlob = '*' in self.file or '?' in self.file
+        pattern = ''.join('.*' if c == '*' else '.' if c == '?' else re.escape(c) for c in self.file)
+        self._regex = re.compile(pattern + '$')
+
+    def matches(self, error):
+        if self.id != error.id and (self.id != '*' or error.id == 'unmatchedSuppression'):
+            return False
+        if self.line != 0 and self.line != error.line():
+            return False
+        if self.isGlob:
+            return self._regex.match(error.file()) is not None
+        return self.file == error.file()
+
+
+def isGlobalSuppression(id, file):
+    """ Is the suppression reported as unmatched at the end of a run, instead of for a checked file? """
+    return id == 'unusedFunction' or '*' in file or '?' in file
+
+
+def readSuppressions(filename):
+    suppressions = []
+    for line in open(filename):
+        line = line.strip()
+        if line and not line.startswith('//'):
+            suppressions.append(Suppression(line))
+    return suppressions
+
+
+def merge(parts, suppressions):
+    """ Merge the XML texts of the parts, return the XML of the result """
+    version = ''
+    errors = {}
+    for index, part in enumerate(parts):
+        root = ET.fromstring(part)
+        if root.get('version') != '2':
+            raise ValueError('the results must be written with --xml-version=2')
+        cppcheck = root.find('cppcheck')
+        if cppcheck is not None and not version:
+            version = cppcheck.get('version', '')
+        for element in root.iter('error'):
+            error = Error(element)
+            if error.id == 'unmatchedSuppression':
+                prefix = 'Unmatched suppression: '
+                id = error.msg[len(prefix):] if error.msg.startswith(prefix) else ''
+                if isGlobalSuppression(id, error.file()):
+                    raise ValueError('part %d was run with the global suppression %s:%s, give it to mergeshards.py instead'
+                                     % (index + 1, id, error.file()))
+                if [s for s in suppressions if (s.id, s.file, s.line) == (id, error.file(), error.line())]:
+                    continue
+            errors[error.key()] = error
+
+    reported = []
+    for error in sorted(errors.values(), key=Error.sortKey):
+        suppressed = False
+        for suppression in suppressions:
+            if suppression.matches(error):
+                suppression.matched = True
+                suppressed = True
+        if not suppressed:
+            reported.append(error)
+
+    # Unmatched suppressions, unless they are suppressed themselves
+    for suppression in suppressions:
+        if suppression.matched or suppression.id == 'unmatchedSuppression':
+            continue
+        element = ET.Element('error', id='unmatchedSuppression', severity='information',
+                             msg='Unmatched suppression: ' + suppression.id,
+                             verbose='Unmatched suppression: ' + suppression.id)
+        ET.SubElement(element, 'location', file=suppression.file, line=str(suppression.line))
+        error = Error(element)
+        if not [s for s in suppressions if s.id == 'unmatchedSuppression' and s.matches(error)]:
+            reported.append(error)
+
+    xml = '<?xml version="1.0" encoding="UTF-8"?>\n'
+    xml += '<results version="2">\n'
+    xml += '  <cppcheck version="%s"/>\n' % xmlAttribute(version)
+    xml += '  <errors>\n'
+    for error in reported:
+        xml += error.toXML()
+    xml += '  </errors>\n'
+    xml += '</results>\n'
+    return xml
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Merge the XML results of the parts of a cppcheck --shard run')
+    parser.add_argument('--suppressions-list', action='append', default=[], metavar='FILE',
+                        help='suppressions file, one suppression on each line')
+    parser.add_argument('--suppress', action='append', default=[], metavar='SPEC',
+                        help='suppression in the format id[:file[:line]]')
+    parser.add_argument('-o', '--output', help='write the report to this file instead of stdout')
+    parser.add_argument('parts', nargs='+', help='the --xml-version=2 results of the parts')
+    args = parser.parse_args()
+
+    suppressions = [Suppression(spec) for spec in args.suppress]
+    for filename in args.suppressions_list:
+        suppressions += readSuppressions(filename)
+
+    parts = [open(filename).read() for filename in args.parts]
+    try:
+        xml = merge(parts, suppressions)
+    except (ValueError, ET.ParseError) as e:
+        sys.stderr.write('mergeshards.py: %s\n' % e)
+        sys.exit(1)
+
+    if args.output:
+        fout = open(args.output, 'w')
+        fout.write(xml)
+        fout.close()
+    else:
+        sys.stdout.write(xml)
+
+
+if __name__ == '__main__':
+    main()
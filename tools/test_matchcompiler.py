@@ -29,6 +29,12 @@ class MatchCompilerTest(unittest.TestCase):
         self.assertEqual(self.mc.parseMatch('  Token::Match(tok,', 2), None)    # multiline Token::Match is not supported yet
         self.assertEqual(self.mc.parseMatch('  Token::Match(Token::findsimplematch(tok,")"), ";")', 2), ['Token::Match(Token::findsimplematch(tok,")"), ";")', 'Token::findsimplematch(tok,")")', ' ";"'])  # inner function call
 
+    def test_compileCmd(self):
+        # the token strings are interned, they are compared by address
+        self.assertEqual(self.mc._compileCmd('foobar'), '(&tok->str()==&matchStr1)/* foobar */')
+        self.assertEqual(self.mc._compileCmd('%or%'), '(&tok->str()==&matchStr2)/* | */')
+        self.assertEqual(self.mc._compileCmd('%var%'), 'tok->isName()')
+
     def test_replaceTokenMatch(self):
         input = 'if (Token::Match(tok, "foobar")) {'
         output = self.mc._replaceTokenMatch(input)
@@ -142,5 +148,136 @@ class MatchCompilerTest(unittest.TestCase):
         self.assertEqual(2, len(self.mc._matchStrs))
         self.assertEqual(1, self.mc._matchStrs['foobar'])
 
+    def test_replaceMatchChains(self):
+        input = ['    ;\n',
+                 '    if (Token::Match(tok, "foo (")) {\n',
+                 '        f();\n',
+                 '    } else if (Token::Match(tok, "%var% =")) {\n',
+                 '        g();\n',
+                 '    }\n',
+                 '    else if (Token::Match(tok, "bar ;"))\n',
+                 '        h();\n',
+                 '    else if (Token::Match(tok->next(), "foo"))\n',
+                 '        i();\n']
+        output = self.mc._replaceMatchChains(input)
+        self.assertEqual(output, ['    ;\n',
+                                  '    int matchChainResult1;\n',
+                                  '    if ((matchChainResult1 = matchChain1(tok)) == 1) {\n',
+                                  '        f();\n',
+                                  '    } else if (matchChainResult1 == 2) {\n',
+                                  '        g();\n',
+                                  '    }\n',
+                                  '    else if (matchChainResult1 == 3)\n',
+                                  '        h();\n',
+                                  '    else if (Token::Match(tok->next(), "foo"))\n',
+                                  '        i();\n'])
+        # three patterns and the chain
+        self.assertEqual(4, len(self.mc._rawMatchFunctions))
+
+        # the generated function checks the literals that start with the
+        # first character of the token, and the other patterns, in order
+        chain = self.mc._compileMatchChain(['foo (', '%var% =', 'bar|foo ;', 'foo'], 2)
+        self.assertEqual(chain, '// chain: foo ( | %var% = | bar|foo ; | foo\n'
+                                'static int matchChain2(const Token *tok) {\n'
+                                '    switch (tok ? tok->str()[0] : \'\\0\') {\n'
+                                '    case \'f\':\n'
+                                '        if (&tok->str()==&matchStr1 && match1(tok))\n'
+                                '            return 1;\n'
+                                '        if (match2(tok))\n'
+                                '            return 2;\n'
+                                '        if (match5(tok))\n'
+                                '            return 3;\n'
+                                '        if (&tok->str()==&matchStr1 && match6(tok))\n'
+                                '            return 4;\n'
+                                '        return 0;\n'
+                                '    }\n'
+                                '    if (match2(tok))\n'
+                                '        return 2;\n'
+                                '    if (match5(tok))\n'
+                                '        return 3;\n'
+                                '    return 0;\n'
+                                '}\n')
+
+    def test_replaceMatchChainsNoChain(self):
+        # a single Token::Match
+        input = ['    ;\n',
+                 '    if (Token::Match(tok, "foo"))\n',
+                 '        f();\n',
+                 '    else if (x)\n',
+                 '        g();\n']
+        self.assertEqual(self.mc._replaceMatchChains(input), input)
+
+        # different tokens
+        input = ['    ;\n',
+                 '    if (Token::Match(tok, "foo"))\n',
+                 '        f();\n',
+                 '    else if (Token::Match(tok->next(), "bar"))\n',
+                 '        g();\n']
+        self.assertEqual(self.mc._replaceMatchChains(input), input)
+
+        # the if is the body of an else, there is no room for the result
+        input = ['    else\n',
+                 '        if (Token::Match(tok, "foo"))\n',
+                 '            f();\n',
+                 '        else if (Token::Match(tok, "bar"))\n',
+                 '            g();\n']
+        self.assertEqual(self.mc._replaceMatchChains(input), input)
+
+        # the token argument might have side effects
+        input = ['    ;\n',
+                 '    if (Token::Match(tok = tok->next(), "foo"))\n',
+                 '        f();\n',
+                 '    else if (Token::Match(tok = tok->next(), "bar"))\n',
+                 '        g();\n']
+        self.assertEqual(self.mc._replaceMatchChains(input), input)
+
+        # only one pattern starts with a literal, there is nothing to dispatch
+        input = ['    ;\n',
+                 '    if (Token::Match(tok, "%var% ("))\n',
+                 '        f();\n',
+                 '    else if (Token::Match(tok, "[;{}] %var%"))\n',
+                 '        g();\n',
+                 '    else if (Token::Match(tok, "foo"))\n',
+                 '        h();\n']
+        self.assertEqual(self.mc._replaceMatchChains(input), input)
+        self.assertEqual(0, len(self.mc._rawMatchFunctions))
+
+        # a chain in the body of a chain that is not fused
+        input = ['    ;\n',
+                 '    if (Token::Match(tok, "%var% ("))\n',
+                 '        f();\n',
+                 '    else if (Token::Match(tok, "%num%")) {\n',
+                 '        ;\n',
+                 '        if (Token::Match(tok->next(), "foo"))\n',
+                 '            g();\n',
+                 '        else if (Token::Match(tok->next(), "bar"))\n',
+                 '            h();\n',
+                 '    }\n']
+        output = self.mc._replaceMatchChains(input)
+        self.assertEqual(output[:5], input[:5])
+        self.assertEqual(output[5], '        int matchChainResult1;\n')
+        self.assertEqual(output[6], '        if ((matchChainResult1 = matchChain1(tok->next())) == 1)\n')
+
+    def test_matchChainDispatch(self):
+        # For every first character, the patterns that can match a token
+        # starting with it are tried in the order of the chain
+        patterns = ['( %var%', '[;{}] %type%', '%num% ,', '(|[ )', '!!;', '* (', '( )', '\\ x', '\' y']
+        chain = self.mc._compileMatchChain(patterns, 1)
+        self.assertEqual(chain.count('\n    case '), 4)
+        for c in ['(', '*', 'x', ';', '\\', '\'']:
+            expected = []
+            for i, pattern in enumerate(patterns):
+                word = pattern.split(' ')[0]
+                if not self.mc._isLiteralWord(word) or word[0] == c:
+                    expected.append(i + 1)
+            case = "    case '" + ('\\' + c if c in '\\\'' else c) + "':\n"
+            if case in chain:
+                body = chain[chain.index(case):]
+                body = body[:body.index('        return 0;')]
+            else:
+                body = chain[chain.rindex('    }\n'):]
+            returns = [int(line.split()[1][:-1]) for line in body.split('\n') if line.strip().startswith('return ') and line.strip() != 'return 0;']
+            self.assertEqual(returns, expected)
+
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,106 @@
+#!/usr/bin/python
+#
+# Cppcheck - A tool for static C/C++ code analysis
+# Copyright (C) 2007-2013 Daniel Marjamaeki and Cppcheck team.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+import unittest
+import mergeshards
+
+
+def results(*errors):
+    xml = '<?xml version="1.0" encoding="UTF-8"?>\n<results version="2">\n  <cppcheck version="1.60 dev"/>\n  <errors>\n'
+    for error in errors:
+        id, file, line = error[:3]
+        msg = error[3] if len(error) > 3 else 'm &amp; &quot;q&quot;'
+        xml += '  <error id="%s" severity="error" msg="%s" verbose="v">\n' % (id, msg)
+        xml += '    <location file="%s" line="%d"/>\n  </error>\n' % (file, line)
+    return xml + '  </errors>\n</results>\n'
+
+
+def unmatched(id, file, line):
+    """ The message of a part about an unmatched suppression """
+    return ('unmatchedSuppression', file, line, 'Unmatched suppression: ' + id)
+
+
+def ids(xml):
+    return [(e.id, e.file(), e.line()) for e in map(mergeshards.Error, mergeshards.ET.fromstring(xml).iter('error'))]
+
+
+class MergeShardsTest(unittest.TestCase):
+    def test_merge(self):
+        xml = mergeshards.merge([results(('a', 'b.c', 3)), results(('a', 'a.c', 1))], [])
+        self.assertEqual(ids(xml), [('a', 'a.c', 1), ('a', 'b.c', 3)])
+        self.assertTrue('<cppcheck version="1.60 dev"/>' in xml)
+        self.assertTrue('msg="m &amp; &quot;q&quot;"' in xml)
+
+    def test_headerMessagesOnce(self):
+        # both parts include the header
+        xml = mergeshards.merge([results(('a', 'a.h', 2), ('b', 'a.c', 1)),
+                                 results(('a', 'a.h', 2), ('b', 'b.c', 1))], [])
+        self.assertEqual(ids(xml), [('b', 'a.c', 1), ('a', 'a.h', 2), ('b', 'b.c', 1)])
+
+    def test_suppressions(self):
+        suppressions = [mergeshards.Suppression('a:a.h'),
+                        mergeshards.Suppression('b:*.c:1'),
+                        mergeshards.Suppression('c')]
+        xml = mergeshards.merge([results(('a', 'a.h', 2), ('b', 'a.c', 1)),
+                                 results(('a', 'a.h', 2), ('b', 'b.c', 2))], suppressions)
+        self.assertEqual(ids(xml), [('b', 'b.c', 2), ('unmatchedSuppression', '*', 0)])
+
+    def test_unmatchedSuppressionsOfParts(self):
+        # the suppression is given to the merge too, it knows if it is
+        # matched in any part
+        suppressions = [mergeshards.Suppression('a:b.c')]
+        xml = mergeshards.merge([results(unmatched('a', 'b.c', 0)),
+                                 results(('a', 'b.c', 3))], suppressions)
+        self.assertEqual(ids(xml), [])
+
+    def test_unmatchedLocalSuppressionsOfParts(self):
+        # inline suppressions and suppressions for one file are only known
+        # by the part that checks the file
+        xml = mergeshards.merge([results(unmatched('a', 'a.c', 3), ('b', 'a.c', 1)),
+                                 results(unmatched('c', 'b.c', 0)),
+                                 results(unmatched('c', 'b.c', 0))], [])
+        self.assertEqual(ids(xml), [('b', 'a.c', 1), ('unmatchedSuppression', 'a.c', 3), ('unmatchedSuppression', 'b.c', 0)])
+
+        # they can be suppressed in the merge
+        suppressions = [mergeshards.Suppression('unmatchedSuppression:a.c')]
+        xml = mergeshards.merge([results(unmatched('a', 'a.c', 3))], suppressions)
+        self.assertEqual(ids(xml), [])
+
+    def test_globalSuppressionsOfParts(self):
+        # a part can't know if a global suppression is matched by another part
+        for spec in [('a', '*', 0), ('a', '*.c', 0), ('unusedFunction', 'a.c', 0)]:
+            part = results(unmatched(*spec))
+            self.assertRaises(ValueError, mergeshards.merge, [part], [])
+
+    def test_suppressUnmatched(self):
+        suppressions = [mergeshards.Suppression('a:x.c'),
+                        mergeshards.Suppression('unmatchedSuppression')]
+        xml = mergeshards.merge([results()], suppressions)
+        self.assertEqual(ids(xml), [])
+
+    def test_suppressionLine(self):
+        s = mergeshards.Suppression('id:dir/file.cpp:12')
+        self.assertEqual((s.id, s.file, s.line, s.isGlob), ('id', 'dir/file.cpp', 12, False))
+        s = mergeshards.Suppression('*')
+        self.assertEqual((s.id, s.file, s.line, s.isGlob), ('*', '*', 0, True))
+
+    def test_version1(self):
+        self.assertRaises(ValueError, mergeshards.merge, ['<results><error file="a.c" line="1" id="a"/></results>'], [])
+
+if __name__ == '__main__':
+    unittest.main()
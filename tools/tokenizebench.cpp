@@ -0,0 +1,188 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2013 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Throughput of TokenList::createTokens() in MB/s. The file is tokenized
+ * as it is, so it should be preprocessed code without comments. It is
+ * tokenized from:
+ *  - stream: a std::istringstream with a copy of the file, as the
+ *    tokenizer was fed before it could read from a buffer
+ *  - buffer: the file itself, mapped into memory where mmap() exists
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "settings.h"
+#include "token.h"
+#include "tokenlist.h"
+
+namespace {
+    /** The contents of a file, mapped or read into memory */
+    class FileData {
+    public:
+        FileData() : _data(0), _size(0), _mapped(false) {
+        }
+
+        ~FileData() {
+#ifndef _WIN32
+            if (_mapped)
+                munmap(const_cast<char *>(_data), _size);
+#endif
+        }
+
+        bool load(const char filename[]) {
+#ifndef _WIN32
+            const int fd = open(filename, O_RDONLY);
+            if (fd < 0)
+                return false;
+            struct stat st;
+            if (fstat(fd, &st) == 0 && st.st_size > 0) {
+                void *data = mmap(0, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data != MAP_FAILED) {
+                    _data = static_cast<const char *>(data);
+                    _size = static_cast<std::size_t>(st.st_size);
+                    _mapped = true;
+                }
+            }
+            close(fd);
+            if (_mapped)
+                return true;
+#endif
+            std::ifstream fin(filename, std::ios::in | std::ios::binary);
+            if (!fin.is_open())
+                return false;
+            std::ostringstream ostr;
+            ostr << fin.rdbuf();
+            _copy = ostr.str();
+            _data = _copy.data();
+            _size = _copy.size();
+            return true;
+        }
+
+        const char *data() const {
+            return _data;
+        }
+
+        std::size_t size() const {
+            return _size;
+        }
+
+        bool mapped() const {
+            return _mapped;
+        }
+
+    private:
+        const char *_data;
+        std::size_t _size;
+        bool _mapped;
+        std::string _copy;
+    };
+
+    enum Variant { stream, buffer };
+
+    /** @return number of tokens, 0 if the file could not be tokenized */
+    unsigned int run(const FileData &file, Variant variant, unsigned int repeat, double &seconds)
+    {
+        Settings settings;
+        unsigned int tokens = 0;
+        const std::clock_t start = std::clock();
+        for (unsigned int i = 0; i < repeat; ++i) {
+            TokenList list(&settings);
+            bool tokenized;
+            if (variant == stream) {
+                std::istringstream istr(std::string(file.data(), file.size()));
+                tokenized = list.createTokens(istr, "bench.cpp");
+            } else {
+                tokenized = list.createTokens(file.data(), file.size(), "bench.cpp");
+            }
+            if (!tokenized)
+                return 0;
+            for (const Token *tok = list.front(); tok; tok = tok->next())
+                ++tokens;
+        }
+        seconds = double(std::clock() - start) / CLOCKS_PER_SEC;
+        return tokens;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int repeat = 20;
+    const char *filename = 0;
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "--repeat=", 9) == 0)
+            repeat = static_cast<unsigned int>(std::atoi(argv[i] + 9));
+        else if (!filename)
+            filename = argv[i];
+        else {
+            std::cerr << "invalid option " << argv[i] << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!filename || repeat == 0) {
+        std::cerr << "Syntax:" << std::endl
+                  << argv[0] << " [--repeat=20] filename" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    FileData file;
+    if (!file.load(filename)) {
+        std::cerr << "could not open " << filename << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    double seconds[2];
+    const unsigned int tokens = run(file, stream, repeat, seconds[0]);
+    if (tokens == 0) {
+        std::cerr << "could not tokenize " << filename << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (run(file, buffer, repeat, seconds[1]) != tokens) {
+        std::cerr << "different results for stream and buffer" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const double megabytes = double(file.size()) * repeat / (1024 * 1024);
+    std::cout << file.size() << " bytes (" << (file.mapped() ? "mapped" : "read") << "), "
+              << tokens / repeat << " tokens, " << repeat << " rounds" << std::endl;
+    std::cout << std::left << std::setw(8) << "input" << std::right
+              << std::setw(10) << "seconds" << std::setw(10) << "MB/s" << std::endl;
+    const char * const names[] = { "stream", "buffer" };
+    for (int v = 0; v < 2; ++v) {
+        std::cout << std::left << std::setw(8) << names[v] << std::right << std::fixed
+                  << std::setprecision(3) << std::setw(10) << seconds[v]
+                  << std::setprecision(1) << std::setw(10) << (seconds[v] > 0 ? megabytes / seconds[v] : 0) << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}